@@ -0,0 +1,151 @@
+#version 120
+/*
+** Rendering of the color correction of a source into a 3D lookup table
+**
+** The slices of the table (blue) are drawn side by side ; each fragment
+** is a cell of the table (red along x in the slice, green along y).
+** The alpha of the table is the luma key (1 opaque, 0 transparent).
+*/
+
+/*
+** Gamma correction
+** Details: http://blog.mouaif.org/2009/01/22/photoshop-gamma-correction-shader/
+*/
+#define GammaCorrection(color, gamma) pow( color, 1.0 / vec3(gamma))
+
+/*
+** Levels control (input (+gamma), output)
+** Details: http://blog.mouaif.org/2009/01/28/levels-control-shader/
+*/
+#define LevelsControlInputRange(color, minInput, maxInput)  min(max(color - vec3(minInput), 0.0) / (vec3(maxInput) - vec3(minInput)), 1.0)
+#define LevelsControlInput(color, minInput, gamma, maxInput) GammaCorrection(LevelsControlInputRange(color, minInput, maxInput), gamma)
+#define LevelsControlOutputRange(color, minOutput, maxOutput)  mix(vec3(minOutput), vec3(maxOutput), color)
+#define LevelsControl(color, minInput, gamma, maxInput, minOutput, maxOutput)   LevelsControlOutputRange(LevelsControlInput(color, minInput, gamma, maxInput), minOutput, maxOutput)
+
+#define ONETHIRD 0.333333
+#define TWOTHIRD 0.666666
+#define EPSILON  0.000001
+
+uniform float lutSize;
+
+// user table (.cube file) applied first
+uniform sampler3D cubeTexture;
+uniform float cubeSize;
+uniform vec3 cubeDomainMin;
+uniform vec3 cubeDomainMax;
+
+uniform float contrast;
+uniform float saturation;
+uniform float brightness;
+uniform vec4 gamma;
+uniform vec4 levels;
+uniform float hueshift;
+uniform float threshold;
+uniform int nbColors;
+uniform int invertMode;
+uniform float lumakey;
+
+/*
+** Hue, saturation, luminance <=> Red Green Blue
+*/
+
+float HueToRGB(float f1, float f2, float hue)
+{
+    float res;
+
+    hue += mix( -float( hue > 1.0 ), 1.0, float(hue < 0.0) );
+
+    res = mix( f1, mix( clamp( f1 + (f2 - f1) * ((2.0 / 3.0) - hue) * 6.0, 0.0, 1.0) , mix( f2,  clamp(f1 + (f2 - f1) * 6.0 * hue, 0.0, 1.0), float((6.0 * hue) < 1.0)),  float((2.0 * hue) < 1.0)), float((3.0 * hue) < 2.0) );
+
+    return res;
+}
+
+vec3 HSV2RGB(vec3 hsl)
+{
+    vec3 rgb;
+    float f1, f2;
+
+    f2 = mix( (hsl.z + hsl.y) - (hsl.y * hsl.z), hsl.z * (1.0 + hsl.y), float(hsl.z < 0.5) );
+
+    f1 = 2.0 * hsl.z - f2;
+
+    rgb.r = HueToRGB(f1, f2, hsl.x + ONETHIRD);
+    rgb.g = HueToRGB(f1, f2, hsl.x);
+    rgb.b = HueToRGB(f1, f2, hsl.x - ONETHIRD);
+
+    rgb =  mix( rgb, vec3(hsl.z), float(hsl.y < EPSILON));
+
+    return rgb;
+}
+
+vec3 RGB2HSV( vec3 color )
+{
+    vec3 hsl = vec3(0.0); // init to 0
+
+    float fmin = min(min(color.r, color.g), color.b);    //Min. value of RGB
+    float fmax = max(max(color.r, color.g), color.b);    //Max. value of RGB
+    float delta = fmax - fmin + EPSILON;             //Delta RGB value
+
+    vec3 deltaRGB = ( ( vec3(fmax) - color ) / 6.0  + vec3(delta) / 2.0 ) / delta ;
+
+    hsl.z = (fmax + fmin) / 2.0; // Luminance
+
+    hsl.y = delta / ( EPSILON + mix( 2.0 - fmax - fmin, fmax + fmin, float(hsl.z < 0.5)) );
+
+    hsl.x = mix( hsl.x, TWOTHIRD + deltaRGB.g - deltaRGB.r, float(color.b == fmax));
+    hsl.x = mix( hsl.x, ONETHIRD + deltaRGB.r - deltaRGB.b, float(color.g == fmax));
+    hsl.x = mix( hsl.x, deltaRGB.b - deltaRGB.g,  float(color.r == fmax));
+
+    hsl.x += mix( - float( hsl.x > 1.0 ), 1.0, float(hsl.x < 0.0) );
+
+    hsl = mix ( hsl, vec3(-1.0, 0.0, hsl.z), float(delta<EPSILON) );
+
+    return hsl;
+}
+
+
+
+void main(void)
+{
+    // color of the cell drawn by this fragment
+    vec2 cell = floor(gl_FragCoord.xy);
+    vec3 transformedRGB = vec3( mod(cell.x, lutSize), cell.y, floor(cell.x / lutSize) ) / (lutSize - 1.0);
+
+    // user table
+    if (cubeSize > 1.0) {
+        vec3 c = clamp( (transformedRGB - cubeDomainMin) / (cubeDomainMax - cubeDomainMin), 0.0, 1.0);
+        transformedRGB = texture3D(cubeTexture, c * (cubeSize - 1.0) / cubeSize + 0.5 / cubeSize).rgb;
+    }
+
+    // color transformation
+    transformedRGB = mix(vec3(0.62), transformedRGB, contrast) + brightness;
+    transformedRGB = LevelsControl(transformedRGB, levels.x, gamma.rgb * gamma.a, levels.y, levels.z, levels.w);
+
+    // RGB invert
+    transformedRGB = vec3(float(invertMode==1)) + ( transformedRGB * vec3(1.0 - 2.0 * float(invertMode==1)) );
+
+    // Convert to HSL
+    vec3 transformedHSL = RGB2HSV( transformedRGB );
+
+    // Luminance invert
+    transformedHSL.z = float(invertMode==2) +  transformedHSL.z * (1.0 - 2.0 * float(invertMode==2) );
+
+    // perform hue shift
+    transformedHSL.x = transformedHSL.x + hueshift;
+
+    // Saturation
+    transformedHSL.y *= saturation;
+
+    // perform reduction of colors
+    transformedHSL = mix( transformedHSL, floor(transformedHSL * vec3(nbColors)) / vec3(nbColors-1),  float( nbColors > 0 ) );
+
+    // luma key
+    float key = 1.0 - mix( 0.0, step( transformedHSL.z, lumakey ), float(lumakey > EPSILON));
+
+    // level threshold
+    transformedHSL = mix( transformedHSL, vec3(0.0, 0.0, step( transformedHSL.z, threshold )), float(threshold > EPSILON));
+
+    // after operations on HSL, convert back to RGB
+    gl_FragColor = vec4( HSV2RGB(transformedHSL), key );
+}
+
@@ -23,6 +23,7 @@ varying vec2 maskc;
 
 uniform sampler2D sourceTexture;
 uniform sampler2D maskTexture;
+uniform sampler3D lutTexture;
 
 uniform vec4 baseColor;
 uniform float baseAlpha;
@@ -249,26 +250,48 @@ float alphachromakey(vec3 color, vec3 colorKey, float delta)
 }
 
 
+/*
+** Program variants are compiled with the features used by each source
+** (SHADER_FILTER, SHADER_CHROMAKEY, SHADER_COLOR, SHADER_HSL or SHADER_LUT
+** defined before this code) ; the operations of other features are skipped.
+*/
 void main(void)
 {
     // deal with alpha separately
-    float ma = texture2D(maskTexture, maskc).a * texture2D(sourceTexture, texc).a;
+    vec4 texel = texture2D(sourceTexture, texc);
+    float ma = texture2D(maskTexture, maskc).a * texel.a;
     float alpha = clamp(ma * baseAlpha, 0.0, 1.0);
     vec3 transformedRGB;
 
     // read color & apply basic filter
+#ifdef SHADER_FILTER
     transformedRGB = apply_filter();
+#else
+    transformedRGB = texel.rgb;
+#endif
 
+#ifdef SHADER_CHROMAKEY
     // chromakey
     alpha -= mix( 0.0, 1.0 - alphachromakey( transformedRGB, chromakey.rgb, chromadelta), float(chromakey.w > 0.0) );
-
+#endif
+
+#ifdef SHADER_LUT
+    // color correction baked in a table (the steps of SHADER_HSL follow)
+    vec4 lut = texture3D(lutTexture, transformedRGB * (LUT_SIZE - 1.0) / LUT_SIZE + 0.5 / LUT_SIZE);
+    transformedRGB = lut.rgb;
+    alpha -= 1.0 - lut.a;
+#else
+#ifdef SHADER_COLOR
     // color transformation
     transformedRGB = mix(vec3(0.62), transformedRGB, contrast) + brightness;
     transformedRGB = LevelsControl(transformedRGB, levels.x, gamma.rgb * gamma.a, levels.y, levels.z, levels.w);
 
     // RGB invert
     transformedRGB = vec3(float(invertMode==1)) + ( transformedRGB * vec3(1.0 - 2.0 * float(invertMode==1)) );
+#endif
+#endif
 
+#ifdef SHADER_HSL
     // Convert to HSL
     vec3 transformedHSL = RGB2HSV( transformedRGB );
 
@@ -293,6 +316,7 @@ void main(void)
 
     // after operations on HSL, convert back to RGB
     transformedRGB = HSV2RGB(transformedHSL);
+#endif
 
     // stippling
     alpha += 2.0 * ma * mod( floor(gl_FragCoord.x * stippling) + floor(gl_FragCoord.y * stippling), 2.0);
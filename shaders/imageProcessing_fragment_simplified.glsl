@@ -23,6 +23,7 @@ varying vec2 maskc;
 
 uniform sampler2D sourceTexture;
 uniform sampler2D maskTexture;
+uniform sampler3D lutTexture;
 
 uniform vec4 baseColor;
 uniform float baseAlpha;
@@ -100,19 +101,34 @@ vec3 RGB2HSV( vec3 color )
 }
 
 
+/*
+** Program variants are compiled with the features used by each source
+** (SHADER_CHROMAKEY, SHADER_COLOR, SHADER_HSL or SHADER_LUT defined before this code)
+*/
 void main(void)
 {
     // deal with alpha separately
-    float ma = texture2D(maskTexture, maskc).a * texture2D(sourceTexture, texc).a;
+    vec4 texel = texture2D(sourceTexture, texc);
+    float ma = texture2D(maskTexture, maskc).a * texel.a;
     float alpha = ma * baseAlpha;
-    vec3 transformedRGB;
-
-    transformedRGB = mix(vec3(0.62), texture2D(sourceTexture, texc).rgb, contrast) + brightness;
+    vec3 transformedRGB = texel.rgb;
+
+#ifdef SHADER_LUT
+    // color correction baked in a table (the steps of SHADER_HSL follow)
+    vec4 lut = texture3D(lutTexture, transformedRGB * (LUT_SIZE - 1.0) / LUT_SIZE + 0.5 / LUT_SIZE);
+    transformedRGB = lut.rgb;
+    alpha -= 1.0 - lut.a;
+#else
+#ifdef SHADER_COLOR
+    transformedRGB = mix(vec3(0.62), transformedRGB, contrast) + brightness;
     transformedRGB = LevelsControl(transformedRGB, levels.x, gamma.rgb * gamma.a, levels.y, levels.z, levels.w);
 
     // RGB invert
     transformedRGB = vec3(float(invertMode==1)) + ( transformedRGB * vec3(1.0 - 2.0 * float(invertMode==1)) );
+#endif
+#endif
 
+#ifdef SHADER_HSL
     // Convert to HSL
     vec3 transformedHSL = RGB2HSV( transformedRGB );
 
@@ -133,9 +149,12 @@ void main(void)
 
     // after operations on HSL, convert back to RGB
     transformedRGB = HSV2RGB(transformedHSL);
+#endif
 
+#ifdef SHADER_CHROMAKEY
     // chromakey
     alpha -= mix( 0.0, step( length( normalize(chromakey.xyz) - normalize(transformedRGB) ), chromadelta ), float(chromakey.w > 0.0) );
+#endif
 
     // stippling
     alpha += 2.0 * ma * mod( floor(gl_FragCoord.x * stippling) + floor(gl_FragCoord.y * stippling), 2.0);
@@ -1,5 +1,9 @@
 
-attribute highp vec2 texCoord;
+// area of the texture mapped on the quad (left, top, right, bottom)
+uniform highp vec4 textureCoordinates;
+// placement of the quad (identity when only the modelview matrix is used)
+uniform highp mat4 sourceTransform;
+
 attribute lowp vec2 maskCoord;
 
 varying vec2 texc;
@@ -7,9 +11,9 @@ varying vec2 maskc;
    
 void main(void)
 {
-    texc = texCoord;
+    texc = mix(textureCoordinates.xy, textureCoordinates.zw, maskCoord);
     maskc = maskCoord;
 
-    gl_Position = ftransform();
+    gl_Position = gl_ModelViewProjectionMatrix * (sourceTransform * gl_Vertex);
 }
 
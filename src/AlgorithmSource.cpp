@@ -36,6 +36,7 @@ bool AlgorithmSource::playable = true;
 
 #include "common.h"
 #include "SourcePropertyBrowser.h"
+#include "Tracer.h"
 
 #include <QMutex>
 #include <QWaitCondition>
@@ -194,7 +195,7 @@ class AlgorithmThread: public QThread {
 public:
     AlgorithmThread(AlgorithmSource *source) :
         QThread(), as(source), end(false), phase(1), i(0.0), j(0.0), k(0.0), l(0.0), di(0.5), dj(0.4), dk(0.3), dl(0.7) {
-
+        setObjectName("AlgorithmThread");
     }
 
     void run();
@@ -218,12 +219,12 @@ void AlgorithmThread::run() {
     t.start();
     do
     {
-        as->_mutex->lock();
+        TRACE_WAIT("wait mutex", as->_mutex->lock());
         if (!as->frameChanged) {
 
             // fill frame
             if (as->variability > EPSILON )
-                fill(as->variability);
+                TRACE_WAIT("fill", fill(as->variability));
 
             as->frameChanged = true;
             as->_cond->wait(as->_mutex);
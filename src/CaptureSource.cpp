@@ -16,6 +16,9 @@ CaptureSource::CaptureSource(QImage capture, GLuint texture, double d): Source(t
     if (_capture.isNull())
         SourceConstructorException().raise();
 
+    // texture changes only with new images
+    trackChanges = true;
+
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, textureIndex);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -93,6 +96,7 @@ void CaptureSource::update()
     #endif
 
         _captureChanged = false;
+        changed = true;
     }
 
     // perform source update
@@ -142,7 +142,7 @@ void CatalogView::drawSource(Source *s)
         glLoadIdentity();
 
         // non-transparency blending
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_baseAlpha, 1.f);
+        ViewRenderWidget::setBaseAlpha(1.f);
 
         // standard transparency blending
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -150,16 +150,12 @@ void CatalogView::drawSource(Source *s)
 
         // draw source in FBO
         // texture coordinate to default
-        ViewRenderWidget::texc[0] = ViewRenderWidget::texc[6] = 0.0;
-        ViewRenderWidget::texc[1] = ViewRenderWidget::texc[3] = 0.0;
-        ViewRenderWidget::texc[2] = ViewRenderWidget::texc[4] = 1.0;
-        ViewRenderWidget::texc[5] = ViewRenderWidget::texc[7] = 1.0;
+        ViewRenderWidget::setTextureCoordinates(0.f, 0.f, 1.f, 1.f);
         // draw vertex array
-        glCallList(ViewRenderWidget::vertex_array_coords);
-        glDrawArrays(GL_QUADS, 0, 4);
+        ViewRenderWidget::drawQuad();
 
         // restore source alpha
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_baseAlpha, (GLfloat) s->getAlpha());
+        ViewRenderWidget::setBaseAlpha((GLfloat) s->getAlpha());
 
         // done drawing
         _catalogfbo->release();
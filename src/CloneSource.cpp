@@ -37,6 +37,9 @@ CloneSource::CloneSource(SourceSet::iterator sit,  double d): Source(0, d), orig
 
     // initialize
     setOriginal(*sit);
+
+    // the texture changes with the original
+    trackChanges = true;
 }
 
 CloneSource::~CloneSource() {
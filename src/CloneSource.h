@@ -57,6 +57,7 @@ public:
     int getFrameHeight() const { return original->getFrameHeight(); }
     double getFrameRate() const { return original->getFrameRate(); }
     double getAspectRatio() const { return original->getAspectRatio(); }
+    bool hasChanged() const { return Source::hasChanged() || original->hasChanged(); }
 
     QDomElement getConfiguration(QDomDocument &doc, QDir current);
 
@@ -68,6 +68,7 @@ CodecManager::CodecManager(QObject *parent) : QObject(parent)
     avcodec_register_all();
     avfilter_register_all();
     avdevice_register_all();
+    avformat_network_init();
 
 #ifndef NDEBUG
     /* print warning info from ffmpeg */
@@ -0,0 +1,242 @@
+/*
+ * ColorLookupTable.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#include "ColorLookupTable.h"
+
+#include "common.h"
+
+#include <QGLFramebufferObject>
+#include <QGLShaderProgram>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QDebug>
+
+// largest table accepted in a .cube file
+#define MAX_CUBE_SIZE 256
+
+QGLFramebufferObject *ColorLookupTable::_fbo = NULL;
+QGLShaderProgram *ColorLookupTable::_program = NULL;
+
+ColorLookupTable::ColorLookupTable() : _lut(0), _cube(0), _cubeSize(0)
+{
+    _domainMin[0] = _domainMin[1] = _domainMin[2] = 0.f;
+    _domainMax[0] = _domainMax[1] = _domainMax[2] = 1.f;
+}
+
+ColorLookupTable::~ColorLookupTable()
+{
+    if (_lut)
+        glDeleteTextures(1, &_lut);
+    if (_cube)
+        glDeleteTextures(1, &_cube);
+}
+
+bool ColorLookupTable::isSupported()
+{
+    // 3D textures are standard in OpenGL 2.1 ; the table must be
+    // rendered with floating point precision
+    static int supported = -1;
+    if (supported < 0)
+        supported = glewIsSupported("GL_ARB_texture_float GL_EXT_framebuffer_object") ? 1 : 0;
+
+    return supported > 0;
+}
+
+bool ColorLookupTable::setCubeFile(QString filename)
+{
+    _cubeFile = QString::null;
+    _cubeData.clear();
+    _cubeSize = 0;
+    _domainMin[0] = _domainMin[1] = _domainMin[2] = 0.f;
+    _domainMax[0] = _domainMax[1] = _domainMax[2] = 1.f;
+
+    if (filename.isEmpty())
+        return true;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << filename << QChar(124).toLatin1() << QObject::tr("Cannot open color table.");
+        return false;
+    }
+
+    // read the cube format : keywords, then one line of R G B per cell
+    // (red changing fastest, blue slowest)
+    QVector<GLfloat> data;
+    int size = 0;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        QStringList words = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+        if (words[0] == "LUT_3D_SIZE" && words.size() > 1) {
+            size = words[1].toInt();
+            if (size < 2 || size > MAX_CUBE_SIZE) {
+                qWarning() << filename << QChar(124).toLatin1() << QObject::tr("Unsupported size of color table (%1, from 2 to %2).").arg(size).arg(MAX_CUBE_SIZE);
+                return false;
+            }
+            data.reserve(size * size * size * 3);
+        }
+        else if (words[0] == "DOMAIN_MIN" && words.size() > 3) {
+            for (int i = 0; i < 3; ++i)
+                _domainMin[i] = words[i+1].toFloat();
+        }
+        else if (words[0] == "DOMAIN_MAX" && words.size() > 3) {
+            for (int i = 0; i < 3; ++i)
+                _domainMax[i] = words[i+1].toFloat();
+        }
+        else if (words.size() == 3 && size > 0) {
+            bool ok = true;
+            for (int i = 0; i < 3 && ok; ++i)
+                data.append( words[i].toFloat(&ok) );
+            if (!ok)
+                break;
+        }
+        else if (words[0] == "LUT_1D_SIZE") {
+            qWarning() << filename << QChar(124).toLatin1() << QObject::tr("1D color tables are not supported.");
+            return false;
+        }
+        // ignore other keywords (TITLE...)
+    }
+
+    if (size < 2 || data.size() != size * size * size * 3) {
+        qWarning() << filename << QChar(124).toLatin1() << QObject::tr("Invalid 3D color table (.cube file).");
+        return false;
+    }
+
+    _cubeFile = filename;
+    _cubeData = data;
+    _cubeSize = size;
+
+    qDebug() << filename << QChar(124).toLatin1() << QObject::tr("Color table of %1 x %1 x %1 loaded.").arg(size);
+    return true;
+}
+
+void ColorLookupTable::bake(const ShaderAttributes &a)
+{
+    // create shared rendering target and program
+    if (!_fbo) {
+        _fbo = new QGLFramebufferObject(LUT_SIZE * LUT_SIZE, LUT_SIZE, QGLFramebufferObject::NoAttachment, GL_TEXTURE_2D, GL_RGBA16F_ARB);
+        CHECK_PTR_EXCEPTION(_fbo);
+        _program = new QGLShaderProgram();
+        CHECK_PTR_EXCEPTION(_program);
+        if (!_program->addShaderFromSourceFile(QGLShader::Fragment, ":/glsl/shaders/colorLookupTable_fragment.glsl") || !_program->link())
+            qCritical() << "colorLookupTable_fragment.glsl" << QChar(124).toLatin1()<< QObject::tr("OpenGL GLSL error in color table shader;%1").arg(_program->log());
+    }
+
+    // keep the current rendering state
+    GLint previousfbo = 0, previousprogram = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousfbo);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousprogram);
+    glPushAttrib(GL_VIEWPORT_BIT | GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
+
+    // the tables use texture unit 2 (0 is the source, 1 is the mask)
+    glActiveTexture(GL_TEXTURE2);
+
+    // create the table
+    if (!_lut) {
+        glGenTextures(1, &_lut);
+        glBindTexture(GL_TEXTURE_3D, _lut);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F_ARB, LUT_SIZE, LUT_SIZE, LUT_SIZE, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+
+    // send the table read in the cube file
+    if (!_cubeData.isEmpty()) {
+        if (!_cube)
+            glGenTextures(1, &_cube);
+        glBindTexture(GL_TEXTURE_3D, _cube);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F_ARB, _cubeSize, _cubeSize, _cubeSize, 0, GL_RGB, GL_FLOAT, _cubeData.constData());
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        _cubeData.clear();
+    }
+    else if (_cubeFile.isEmpty() && _cube) {
+        glDeleteTextures(1, &_cube);
+        _cube = 0;
+    }
+    glBindTexture(GL_TEXTURE_3D, _cube);
+
+    // render all the cells
+    _fbo->bind();
+    glViewport(0, 0, _fbo->width(), _fbo->height());
+    glDisable(GL_BLEND);
+
+    _program->bind();
+    _program->setUniformValue("lutSize", (GLfloat) LUT_SIZE);
+    _program->setUniformValue("cubeTexture", 2);
+    _program->setUniformValue("cubeSize", _cube ? (GLfloat) _cubeSize : 0.f);
+    _program->setUniformValue("cubeDomainMin", _domainMin[0], _domainMin[1], _domainMin[2]);
+    _program->setUniformValue("cubeDomainMax", _domainMax[0], _domainMax[1], _domainMax[2]);
+    _program->setUniformValue("gamma", a.gamma[0], a.gamma[1], a.gamma[2], a.gamma[3]);
+    _program->setUniformValue("levels", a.levels[0], a.levels[1], a.levels[2], a.levels[3]);
+    _program->setUniformValue("contrast", a.contrast);
+    _program->setUniformValue("brightness", a.brightness);
+    _program->setUniformValue("saturation", a.saturation);
+    _program->setUniformValue("hueshift", a.hueshift);
+    _program->setUniformValue("invertMode", a.invertMode);
+    _program->setUniformValue("nbColors", a.nbColors);
+    _program->setUniformValue("threshold", a.threshold);
+    _program->setUniformValue("lumakey", a.lumakey);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glBegin(GL_QUADS);
+    glVertex2f(-1.f, -1.f);
+    glVertex2f( 1.f, -1.f);
+    glVertex2f( 1.f,  1.f);
+    glVertex2f(-1.f,  1.f);
+    glEnd();
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+
+    // copy the slices side by side into the 3D texture
+    glBindTexture(GL_TEXTURE_3D, _lut);
+    for (int z = 0; z < LUT_SIZE; ++z)
+        glCopyTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, z, z * LUT_SIZE, 0, LUT_SIZE, LUT_SIZE);
+
+    // restore rendering state (the table stays bound to unit 2)
+    glUseProgram(previousprogram);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousfbo);
+    glPopAttrib();
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,89 @@
+/*
+ * ColorLookupTable.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef COLORLOOKUPTABLE_H
+#define COLORLOOKUPTABLE_H
+
+#include <QString>
+#include <QVector>
+
+#include "Source.h"
+
+/**
+ * Number of cells of the table in each dimension
+ */
+#define LUT_SIZE 33
+
+class QGLFramebufferObject;
+class QGLShaderProgram;
+
+/**
+ * Color correction of a source baked in a 3D texture.
+ *
+ * The continuous color operations of the image processing shader
+ * (brightness, contrast, levels, gamma, inversion, hue and saturation)
+ * only depend on the input color; they are rendered once in a table of
+ * LUT_SIZE^3 cells when the properties change and the shader then reads
+ * the result in the table. Posterize, threshold and lumakey are steps
+ * which the interpolation of the table would blur; the caller leaves
+ * them to the shader.
+ *
+ * A table given in a .cube file can be applied before these operations.
+ */
+class ColorLookupTable
+{
+public:
+    ColorLookupTable();
+    ~ColorLookupTable();
+
+    // can OpenGL render floating point 3D tables ?
+    static bool isSupported();
+
+    // render the color operations in the table
+    // (requires an OpenGL context ; the current rendering state is preserved)
+    void bake(const ShaderAttributes &attributes);
+
+    // the 3D texture to sample
+    GLuint texture() const { return _lut; }
+
+    // read a table from a .cube file (empty filename to remove)
+    bool setCubeFile(QString filename);
+    QString cubeFile() const { return _cubeFile; }
+
+private:
+    GLuint _lut, _cube;
+    QString _cubeFile;
+
+    // content of the .cube file waiting to be sent to the texture
+    QVector<GLfloat> _cubeData;
+    int _cubeSize;
+    GLfloat _domainMin[3], _domainMax[3];
+
+    // shared rendering target and program
+    static QGLFramebufferObject *_fbo;
+    static QGLShaderProgram *_program;
+};
+
+#endif // COLORLOOKUPTABLE_H
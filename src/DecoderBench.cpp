@@ -0,0 +1,348 @@
+/*
+ * DecoderBench.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+/*
+ * glmixer-decodebench : performance of the decoding alone
+ *
+ * Plays a file (or a generated clip) with a VideoFile, or a stream with
+ * a VideoStream, without OpenGL nor display: the pictures are consumed as
+ * fast as possible or at a target frame rate while seeking and changing
+ * speed. The measures are written in JSON:
+ *
+ *  glmixer-decodebench [--file FILE | --codec NAME --resolution WxH] [--stream URL]
+ *                      [--mode fast|fps] [--fps N] [--speeds S1,S2,..] [--seeks N]
+ *                      [--duration SECONDS] [--size WxH] [--pot] [--ignore-alpha]
+ *                      [--hardware] [--memory-policy PERCENT] [--output FILE]
+ */
+
+#include "DecoderBench.moc"
+
+#include "common.h"
+#include "VideoFile.h"
+#include "VideoStream.h"
+#include "VideoRecorder.h"
+
+#include <QApplication>
+#include <QStringList>
+#include <QVector>
+#include <QtAlgorithms>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+#include <chrono>
+#include <thread>
+
+// generated clip (frames at 25 fps)
+#define DECODEBENCH_CLIP_FRAMES 250
+#define DECODEBENCH_CLIP_FPS 25
+
+DecoderConsumer::DecoderConsumer() : QObject(), frames(0), loops(0), seeking(false),
+    lastPts(-1.0), pictureMemory(0)
+{
+}
+
+void DecoderConsumer::requestSeek()
+{
+    seeking = true;
+    seekTimer.start();
+}
+
+void DecoderConsumer::consume(VideoPicture *vp)
+{
+    if (!vp)
+        return;
+
+    ++frames;
+
+    // first picture after a seek
+    if (seeking && vp->hasAction(VideoPicture::ACTION_RESET_PTS)) {
+        seekLatencies.append( (double) seekTimer.nsecsElapsed() / 1000000.0 );
+        seeking = false;
+    }
+    // back to the beginning
+    else if (vp->getPts() < lastPts)
+        ++loops;
+    lastPts = vp->getPts();
+
+    pictureMemory = qMax(pictureMemory, (qint64) VideoPicture::getPictureMapsMemory());
+
+    // the pictures not kept by the VideoFile
+    if (vp->hasAction(VideoPicture::ACTION_DELETE))
+        delete vp;
+}
+
+static QString option(const QStringList &args, const QString &name, const QString &defaultValue)
+{
+    int idx = args.indexOf(name);
+    if (idx > -1 && idx + 1 < args.size())
+        return args.at(idx + 1);
+    return defaultValue;
+}
+
+static QString jsonString(QString s)
+{
+    s.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+    return QString("\"%1\"").arg(s);
+}
+
+static QString distribution(QVector<double> values)
+{
+    if (values.isEmpty())
+        return QString("{ \"count\": 0 }");
+
+    qSort(values);
+    return QString("{ \"count\": %1, \"p50\": %2, \"p95\": %3, \"max\": %4 }").arg(values.size())
+            .arg(values[ (values.size() - 1) / 2 ], 0, 'f', 3)
+            .arg(values[ (int) (0.95 * (values.size() - 1)) ], 0, 'f', 3)
+            .arg(values.last(), 0, 'f', 3);
+}
+
+static void waitMicroseconds(int us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+int main(int argc, char **argv)
+{
+    // no GUI : runs without display
+    QApplication a(argc, argv, false);
+    a.setApplicationName("glmixer-decodebench");
+
+    QStringList args = a.arguments();
+    if (args.contains("-h") || args.contains("--help")) {
+        qDebug("%s [--file FILE | --codec NAME --resolution WxH] [--stream URL] [--mode fast|fps] [--fps N] [--speeds S1,S2,..] [--seeks N] [--duration SECONDS] [--size WxH] [--pot] [--ignore-alpha] [--hardware] [--memory-policy PERCENT] [--output FILE]", qPrintable(args.at(0)));
+        qDebug("codecs : %s", qPrintable(VideoRecorder::getCodecNames().join(" ")));
+        return EXIT_SUCCESS;
+    }
+
+    QString file = option(args, "--file", QString());
+    QString stream = option(args, "--stream", QString());
+    QString codec = option(args, "--codec", "h264");
+    QStringList resolution = option(args, "--resolution", "1280x720").split("x");
+    bool fast = option(args, "--mode", "fast") == "fast";
+    double fps = qMax(1.0, option(args, "--fps", "60").toDouble());
+    QStringList speeds = option(args, "--speeds", "1").split(",", QString::SkipEmptyParts);
+    int seeks = qMax(0, option(args, "--seeks", "0").toInt());
+    double duration = qMax(0.1, option(args, "--duration", "10").toDouble());
+    QStringList size = option(args, "--size", "0x0").split("x");
+    bool powerOfTwo = args.contains("--pot");
+    bool ignoreAlpha = args.contains("--ignore-alpha");
+    bool hardware = args.contains("--hardware");
+    QString output = option(args, "--output", QString());
+
+    if (args.contains("--memory-policy"))
+        VideoFile::setMemoryUsagePolicy( option(args, "--memory-policy", "50").toInt() );
+
+    int width = size.size() == 2 ? size[0].toInt() : 0;
+    int height = size.size() == 2 ? size[1].toInt() : 0;
+
+    //
+    // 1. The input : a file, a stream or a generated clip
+    //
+    bool generated = file.isEmpty() && stream.isEmpty();
+    if (generated) {
+        int format = VideoRecorder::getFormatFromCodecName(codec);
+        int w = resolution.size() == 2 ? resolution[0].toInt() : 0;
+        int h = resolution.size() == 2 ? resolution[1].toInt() : 0;
+        if (format < 0 || w < 16 || h < 16) {
+            qWarning() << "glmixer-decodebench" << QChar(124).toLatin1() << QObject::tr("Invalid codec or resolution.");
+            return EXIT_FAILURE;
+        }
+        file = QDir::temp().absoluteFilePath(QString("glmixer-decodebench-%1").arg(a.applicationPid()));
+        try {
+            VideoRecorder::recordTestClip((encodingformat) format, file, w, h, DECODEBENCH_CLIP_FPS, DECODEBENCH_CLIP_FRAMES);
+        }
+        catch (VideoRecorderException &e){
+            qWarning() << "glmixer-decodebench" << QChar(124).toLatin1() << e.message();
+            return EXIT_FAILURE;
+        }
+    }
+
+    DecoderConsumer consumer;
+    VideoFile *vf = NULL;
+    VideoStream *vs = NULL;
+    QElapsedTimer timer;
+
+    if (stream.isEmpty()) {
+        vf = new VideoFile(0, powerOfTwo, width, height);
+        if ( !vf->open(file, hardware, ignoreAlpha) ) {
+            qWarning() << file << QChar(124).toLatin1() << QObject::tr("The file could not be loaded.");
+            delete vf;
+            return EXIT_FAILURE;
+        }
+        QObject::connect(vf, SIGNAL(frameReady(VideoPicture *)), &consumer, SLOT(consume(VideoPicture *)));
+
+        // the benchmark chooses when pictures are taken
+        vf->setFramePacing(true);
+        vf->setFastForward(fast);
+        vf->setLoop(true);
+        vf->play(true);
+    }
+    else {
+        vs = new VideoStream(0, width, height);
+        QObject::connect(vs, SIGNAL(frameReady(VideoPicture *)), &consumer, SLOT(consume(VideoPicture *)));
+        vs->open(stream);
+
+        // wait for the connection
+        timer.start();
+        while ( !vs->isOpen() && timer.elapsed() < 10000 ) {
+            a.processEvents();
+            waitMicroseconds(1000);
+        }
+        if ( !vs->isOpen() ) {
+            qWarning() << stream << QChar(124).toLatin1() << QObject::tr("The stream could not be opened.");
+            delete vs;
+            return EXIT_FAILURE;
+        }
+        vs->play(true);
+    }
+
+    //
+    // 2. Consume the pictures
+    //
+    int starvations = 0;
+    bool starving = false;
+    int segment = -1;
+    int seekDone = 0;
+    qsrand(1);
+
+    qint64 period = (qint64) (1000000000.0 / fps);
+    qint64 deadline = 0;
+    qint64 end = (qint64) (duration * 1000000000.0);
+    timer.start();
+    while ( timer.nsecsElapsed() < end ) {
+
+        a.processEvents();
+
+        if (!vf) {
+            // the stream shows its pictures at its own pace
+            waitMicroseconds(1000);
+            continue;
+        }
+
+        qint64 now = timer.nsecsElapsed();
+
+        // change of speed for each segment of the duration
+        int s = (int) ( (double) now / (double) end * (double) speeds.size() );
+        if (s != segment && s < speeds.size()) {
+            segment = s;
+            vf->setPlaySpeed( speeds[s].toDouble() );
+        }
+
+        // seeks distributed over the duration
+        if ( seekDone < seeks && now > (qint64) ( (double) (seekDone + 1) / (double) (seeks + 1) * (double) end ) ) {
+            double t = vf->getBegin() + (vf->getEnd() - vf->getBegin()) * (double) qrand() / (double) RAND_MAX;
+            consumer.requestSeek();
+            vf->seekToPosition(t);
+            ++seekDone;
+        }
+
+        // at target frame rate, wait for the next frame
+        if (!fast && now < deadline) {
+            waitMicroseconds( (int) qMin((qint64) 1000, (deadline - now) / 1000) );
+            continue;
+        }
+        deadline = now + period;
+
+        // no picture when one is needed (not counting the wait after a seek)
+        bool empty = vf->getPictureQueueCount() < 1;
+        if (empty && !starving && !consumer.seeking)
+            ++starvations;
+        starving = empty;
+
+        if (empty && fast)
+            waitMicroseconds(100);
+        else
+            vf->present(fast ? 0.0 : 1.0 / fps);
+    }
+    double elapsed = (double) timer.nsecsElapsed() / 1000000000.0;
+
+    //
+    // 3. Results
+    //
+    QFile out_file;
+    if (output.isEmpty())
+        out_file.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    else {
+        out_file.setFileName(output);
+        if (!out_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning() << output << QChar(124).toLatin1() << QObject::tr("Cannot write results.");
+            return EXIT_FAILURE;
+        }
+    }
+
+    QTextStream out(&out_file);
+    out << "{\n";
+    out << "  \"input\": " << jsonString(vf ? (generated ? codec : file) : stream) << ",\n";
+    if (vf) {
+        out << "  \"codec\": " << jsonString(vf->getCodecName()) << ",\n";
+        out << "  \"pixel_format\": " << jsonString(vf->getPixelFormatName()) << ",\n";
+        out << "  \"width\": " << vf->getFrameWidth() << ",\n";
+        out << "  \"height\": " << vf->getFrameHeight() << ",\n";
+        out << "  \"hardware\": " << (vf->useHardwareCodec() ? "true" : "false") << ",\n";
+        out << "  \"memory_policy\": " << VideoFile::getMemoryUsagePolicy() << ",\n";
+        out << "  \"picture_queue_size\": " << vf->getPictureQueueSize() << ",\n";
+    }
+    else {
+        out << "  \"codec\": " << jsonString(vs->getCodecName()) << ",\n";
+        out << "  \"width\": " << vs->getFrameWidth() << ",\n";
+        out << "  \"height\": " << vs->getFrameHeight() << ",\n";
+    }
+    out << "  \"mode\": " << jsonString(fast ? "fast" : "fps");
+    if (!fast)
+        out << ", \"target_fps\": " << fps;
+    out << ",\n";
+    out << "  \"speeds\": [" << speeds.join(", ") << "],\n";
+    out << "  \"duration_s\": " << QString::number(elapsed, 'f', 3) << ",\n";
+    out << "  \"frames\": " << consumer.frames << ",\n";
+    out << "  \"fps\": " << QString::number( (double) consumer.frames / elapsed, 'f', 2) << ",\n";
+    if (vf) {
+        out << "  \"decoded_fps\": " << QString::number( (double) vf->getDecodedFrameCount() / elapsed, 'f', 2) << ",\n";
+        out << "  \"dropped_frames\": " << vf->getDroppedFrameCount() << ",\n";
+        out << "  \"loops\": " << consumer.loops << ",\n";
+        out << "  \"starvation_events\": " << starvations << ",\n";
+        out << "  \"seek_ms\": " << distribution(consumer.seekLatencies) << ",\n";
+    }
+    out << "  \"picture_memory_peak_bytes\": " << consumer.pictureMemory << ",\n";
+    out << "  \"peak_rss_bytes\": " << getPeakResidentMemory() << "\n";
+    out << "}\n";
+    out.flush();
+    out_file.close();
+
+    //
+    // 4. Cleanup
+    //
+    if (vf)
+        delete vf;
+    if (vs)
+        delete vs;
+    if (generated)
+        QDir::temp().remove(file);
+
+    return EXIT_SUCCESS;
+}
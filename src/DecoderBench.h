@@ -0,0 +1,62 @@
+/*
+ * DecoderBench.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef DECODERBENCH_H
+#define DECODERBENCH_H
+
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+
+#include "VideoPicture.h"
+
+/**
+ * Consumer of the pictures decoded in glmixer-decodebench
+ * (counts frames and loops, measures the latency of seeks).
+ */
+class DecoderConsumer: public QObject
+{
+    Q_OBJECT
+
+public:
+    DecoderConsumer();
+
+    // start measuring the latency of a seek
+    void requestSeek();
+
+    int frames, loops;
+    bool seeking;
+    double lastPts;
+    qint64 pictureMemory;
+    QVector<double> seekLatencies;
+
+public slots:
+    void consume(VideoPicture *vp);
+
+private:
+    QElapsedTimer seekTimer;
+};
+
+#endif // DECODERBENCH_H
@@ -0,0 +1,376 @@
+/*
+ * DiskWriter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+extern "C" {
+#include <libavutil/mem.h>
+#include <libavutil/error.h>
+}
+
+#include "DiskWriter.h"
+#include "VideoRecorder.h"
+#include "common.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define ALIGNED_SIZE(s) ( ((s) + DISKWRITER_ALIGNMENT - 1) & ~((int64_t) DISKWRITER_ALIGNMENT - 1) )
+
+DiskWriter::DiskWriter(int blockcount) : QThread(), fd(-1), patchfd(-1), direct(false), _quit(false), failed(0),
+    context(NULL), maxBlockCount(qMax(2, blockcount)), blockCount(0), current(NULL),
+    position(0), length(0), allocated(0), written(0), busy(0), stall(0)
+{
+
+}
+
+DiskWriter::~DiskWriter()
+{
+    // make sure the thread is over
+    if (isRunning()) {
+        mutex.lock();
+        _quit = true;
+        blockFull.wakeAll();
+        mutex.unlock();
+        wait();
+    }
+
+    if (fd > -1)
+        ::close(fd);
+    if (patchfd > -1 && patchfd != fd)
+        ::close(patchfd);
+
+    if (context) {
+        av_freep(&context->buffer);
+        av_freep(&context);
+    }
+
+    freeBlocks();
+}
+
+void DiskWriter::open(QString filename)
+{
+    fileName = filename;
+
+    // open file without page cache if possible
+#ifdef Q_OS_LINUX
+    fd = ::open(qPrintable(fileName), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    direct = (fd > -1);
+#endif
+    if (fd < 0)
+        fd = ::open(qPrintable(fileName), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        VideoRecorderException(QString("File open %1").arg(strerror(errno))).raise();
+
+#ifdef Q_OS_MAC
+    // equivalent of O_DIRECT
+    direct = ( fcntl(fd, F_NOCACHE, 1) != -1 );
+#endif
+
+    // unaligned writes are done without O_DIRECT
+    patchfd = fd;
+#ifdef Q_OS_LINUX
+    if (direct)
+        patchfd = ::open(qPrintable(fileName), O_WRONLY);
+    if (patchfd < 0)
+        VideoRecorderException(QString("File open %1").arg(strerror(errno))).raise();
+#endif
+
+    // custom output for libavformat
+    unsigned char *buffer = (unsigned char *) av_malloc(DISKWRITER_ALIGNMENT * 16);
+    context = avio_alloc_context(buffer, DISKWRITER_ALIGNMENT * 16, 1, this, NULL, DiskWriter::writePacket, DiskWriter::seek);
+    if (!context)
+        VideoRecorderException("Cannot allocate output context.").raise();
+
+    // start writing thread
+    _quit = false;
+    start(QThread::HighPriority);
+
+    qDebug() << fileName << QChar(124).toLatin1() << QObject::tr("Asynchronous disk writer (%1 blocks of %2%3).").arg(maxBlockCount).arg(getByteSizeString(DISKWRITER_BLOCK_SIZE)).arg(direct ? ", direct I/O" : "");
+}
+
+void DiskWriter::close()
+{
+    if (!context)
+        return;
+
+    // send the last block (padded to alignment if necessary)
+    if (current && current->size > 0)
+        pushBlock();
+
+    // wait for all blocks to be written
+    mutex.lock();
+    _quit = true;
+    blockFull.wakeAll();
+    mutex.unlock();
+    wait();
+
+    // remove padding and preallocated space
+    if ( ftruncate(fd, length) != 0 )
+        setFailed();
+
+    // write parts updated by the muxer (e.g. headers)
+    for (int i = 0; i < patches.size(); ++i) {
+        const QByteArray &data = patches[i].second;
+        if ( pwrite(patchfd, data.constData(), data.size(), patches[i].first) != data.size() )
+            setFailed();
+    }
+    patches.clear();
+
+    if (patchfd != fd)
+        ::close(patchfd);
+    patchfd = -1;
+    if ( ::close(fd) != 0 )
+        setFailed();
+    fd = -1;
+
+    freeBlocks();
+
+    qDebug() << fileName << QChar(124).toLatin1() << QObject::tr("Written %1 at %2/s (encoder stalled %3 ms).").arg(getByteSizeString(written)).arg(getByteSizeString(throughput())).arg(stall);
+
+    if (hasFailed())
+        VideoRecorderException(QString("File close %1").arg(fileName)).raise();
+}
+
+qint64 DiskWriter::bytesWritten()
+{
+    QMutexLocker locker(&mutex);
+    return written;
+}
+
+double DiskWriter::throughput()
+{
+    QMutexLocker locker(&mutex);
+    return busy > 0 ? (double) written * 1000.0 / (double) busy : 0.0;
+}
+
+qint64 DiskWriter::stallTime()
+{
+    QMutexLocker locker(&mutex);
+    return stall;
+}
+
+int DiskWriter::writePacket(void *opaque, uint8_t *buf, int size)
+{
+    DiskWriter *w = (DiskWriter *) opaque;
+
+    if (w->hasFailed())
+        return AVERROR(EIO);
+
+    int done = 0;
+
+    // part overwriting data already written (e.g. header updated by the muxer)
+    if (w->position < w->length) {
+        done = (int) qMin( (int64_t) size, w->length - w->position);
+        w->patches.append( qMakePair(w->position, QByteArray((const char *) buf, done)) );
+        w->position += done;
+    }
+
+    // part appended at the end of the file
+    if (done < size)
+        w->append(buf + done, size - done);
+
+    return w->hasFailed() ? AVERROR(EIO) : size;
+}
+
+int64_t DiskWriter::seek(void *opaque, int64_t offset, int whence)
+{
+    DiskWriter *w = (DiskWriter *) opaque;
+
+    int64_t pos = -1;
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE:
+        return w->length;
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = w->position + offset;
+        break;
+    case SEEK_END:
+        pos = w->length + offset;
+        break;
+    }
+
+    // cannot seek beyond end of file
+    if (pos < 0 || pos > w->length)
+        return AVERROR(EINVAL);
+
+    w->position = pos;
+    return pos;
+}
+
+void DiskWriter::append(const uint8_t *buf, int size)
+{
+    while (size > 0) {
+
+        // get a block to fill
+        if (!current) {
+            current = getFreeBlock();
+            if (!current)
+                return;
+            current->offset = length;
+            current->size = 0;
+        }
+
+        // fill block
+        int n = qMin(size, DISKWRITER_BLOCK_SIZE - current->size);
+        memcpy(current->data + current->size, buf, n);
+        current->size += n;
+        length += n;
+        position += n;
+        buf += n;
+        size -= n;
+
+        // send full block to writing thread
+        if (current->size == DISKWRITER_BLOCK_SIZE)
+            pushBlock();
+    }
+}
+
+DiskBlock *DiskWriter::getFreeBlock()
+{
+    QMutexLocker locker(&mutex);
+
+    // allocate a new block if possible
+    if (emptyBlocks.isEmpty() && blockCount < maxBlockCount) {
+        DiskBlock *b = new DiskBlock;
+        Q_CHECK_PTR(b);
+        if ( posix_memalign((void **) &b->data, DISKWRITER_ALIGNMENT, DISKWRITER_BLOCK_SIZE) != 0 ) {
+            delete b;
+            setFailed();
+            return NULL;
+        }
+        blockCount++;
+        return b;
+    }
+
+    // wait for a block to be written (the encoder stalls)
+    if (emptyBlocks.isEmpty()) {
+        QElapsedTimer timer;
+        timer.start();
+        while (emptyBlocks.isEmpty() && !hasFailed())
+            blockEmpty.wait(&mutex);
+        stall += timer.elapsed();
+    }
+
+    if (hasFailed())
+        return NULL;
+
+    return emptyBlocks.takeFirst();
+}
+
+void DiskWriter::pushBlock()
+{
+    QMutexLocker locker(&mutex);
+
+    fullBlocks.enqueue(current);
+    current = NULL;
+    blockFull.wakeAll();
+}
+
+void DiskWriter::freeBlocks()
+{
+    QMutexLocker locker(&mutex);
+
+    if (current)
+        emptyBlocks.append(current);
+    current = NULL;
+    while (!fullBlocks.isEmpty())
+        emptyBlocks.append(fullBlocks.dequeue());
+
+    foreach (DiskBlock *b, emptyBlocks) {
+        free(b->data);
+        delete b;
+    }
+    emptyBlocks.clear();
+    blockCount = 0;
+}
+
+void DiskWriter::run()
+{
+    QElapsedTimer timer;
+
+    while (true) {
+
+        // wait for a block to write
+        mutex.lock();
+        while (fullBlocks.isEmpty() && !_quit)
+            blockFull.wait(&mutex);
+        if (fullBlocks.isEmpty()) {
+            mutex.unlock();
+            break;
+        }
+        DiskBlock *b = fullBlocks.dequeue();
+        mutex.unlock();
+
+        timer.start();
+
+        if (!hasFailed()) {
+            // O_DIRECT requires aligned size (the last block is padded)
+            int64_t size = direct ? ALIGNED_SIZE(b->size) : b->size;
+            if (size > b->size)
+                memset(b->data + b->size, 0, size - b->size);
+
+#ifdef Q_OS_LINUX
+            // allocate disk space in advance
+            if (b->offset + size > allocated) {
+                if ( fallocate(fd, FALLOC_FL_KEEP_SIZE, allocated, DISKWRITER_PREALLOCATION) == 0 )
+                    allocated += DISKWRITER_PREALLOCATION;
+                else
+                    allocated = INT64_MAX; // not supported : do not try again
+            }
+#endif
+            // write the block
+            int64_t done = 0;
+            while (done < size) {
+                ssize_t r = pwrite(fd, b->data + done, size - done, b->offset + done);
+                if (r < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    qWarning() << fileName << QChar(124).toLatin1() << QObject::tr("Disk write error (%1).").arg(strerror(errno));
+                    setFailed();
+                    break;
+                }
+                done += r;
+            }
+        }
+
+        // give back the block
+        mutex.lock();
+        busy += timer.elapsed();
+        written += b->size;
+        emptyBlocks.append(b);
+        blockEmpty.wakeAll();
+        mutex.unlock();
+    }
+}
+
+#endif
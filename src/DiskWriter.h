@@ -0,0 +1,135 @@
+/*
+ * DiskWriter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef DISKWRITER_H
+#define DISKWRITER_H
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QPair>
+#include <QByteArray>
+#include <QString>
+#include <QAtomicInt>
+
+#ifdef Q_OS_UNIX
+
+/**
+ * Size of the blocks written to disk (multiple of the alignment)
+ * and number of blocks waiting to be written
+ * Expressed in bytes
+ */
+#define DISKWRITER_ALIGNMENT 4096
+// 4 MB
+#define DISKWRITER_BLOCK_SIZE 4194304
+// 32 blocks, i.e. 128 MB
+#define DISKWRITER_BLOCK_COUNT 32
+// 256 MB allocated on disk in advance
+#define DISKWRITER_PREALLOCATION 268435456
+
+typedef struct {
+    uint8_t *data;
+    int64_t offset;
+    int size;
+} DiskBlock;
+
+/**
+ * Custom libavformat output writing into a file from a separate thread.
+ *
+ * The muxer writes into blocks of memory which are written to disk by
+ * the thread, bypassing the page cache (O_DIRECT) and in a file allocated
+ * in advance (fallocate) when the system allows it. The encoder only waits
+ * when all the blocks are waiting to be written (stall).
+ *
+ * Data written again by the muxer (e.g. headers updated when closing
+ * the file) is kept aside and written when closing.
+ */
+class DiskWriter: public QThread {
+
+public:
+    DiskWriter(int blockcount = DISKWRITER_BLOCK_COUNT);
+    ~DiskWriter();
+
+    // Create the file and start the writing thread
+    void open(QString filename);
+    // Write remaining data and close the file
+    void close();
+
+    // context to give to the format context (AVFMT_FLAG_CUSTOM_IO)
+    AVIOContext *getIOContext() const { return context; }
+
+    // status
+    bool isDirect() const { return direct; }
+    qint64 bytesWritten();
+    double throughput();
+    qint64 stallTime();
+
+protected:
+    void run();
+
+private:
+    // AVIO callbacks
+    static int writePacket(void *opaque, uint8_t *buf, int size);
+    static int64_t seek(void *opaque, int64_t offset, int whence);
+
+    void append(const uint8_t *buf, int size);
+    DiskBlock *getFreeBlock();
+    void pushBlock();
+    void freeBlocks();
+
+    QString fileName;
+    int fd, patchfd;
+    bool direct, _quit;
+
+    // set by the writing thread and read by the encoder
+    QAtomicInt failed;
+    inline bool hasFailed() { return failed.fetchAndAddAcquire(0) != 0; }
+    inline void setFailed() { failed.fetchAndStoreRelease(1); }
+    AVIOContext *context;
+
+    // blocks
+    int maxBlockCount, blockCount;
+    DiskBlock *current;
+    QQueue<DiskBlock *> fullBlocks;
+    QList<DiskBlock *> emptyBlocks;
+    QMutex mutex;
+    QWaitCondition blockFull, blockEmpty;
+
+    // positions in file
+    int64_t position, length, allocated;
+    QList< QPair<int64_t, QByteArray> > patches;
+
+    // statistics
+    qint64 written, busy, stall;
+};
+
+#endif // Q_OS_UNIX
+
+#endif // DISKWRITER_H
@@ -0,0 +1,122 @@
+/*
+ * EncoderBenchmark.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#include "EncoderBenchmark.moc"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+#include <ctime>
+#include <thread>
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+
+// number of different synthetic frames
+#define BENCHMARK_FRAME_COUNT 8
+
+EncoderBenchmark::EncoderBenchmark(int w, int h, int fps, encodingquality q) : QThread(),
+    width(w), height(h), frameRate(fps), quality(q), _quit(false)
+{
+    connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
+}
+
+void EncoderBenchmark::run()
+{
+    // create synthetic frames : moving gradients with noise,
+    // so that encoders have motion and details to compress
+    AVFrame *frames[BENCHMARK_FRAME_COUNT];
+    unsigned int seed = 1;
+    for (int k = 0; k < BENCHMARK_FRAME_COUNT; ++k) {
+        frames[k] = av_frame_alloc();
+        frames[k]->format = AV_PIX_FMT_RGB24;
+        frames[k]->width  = width;
+        frames[k]->height = height;
+        av_frame_get_buffer(frames[k], 32);
+
+        for (int y = 0; y < height; ++y) {
+            uint8_t *line = frames[k]->data[0] + y * frames[k]->linesize[0];
+            for (int x = 0; x < width; ++x) {
+                seed = seed * 1103515245 + 12345;
+                line[3*x]     = (uint8_t) ( (x + k * 16) * 255 / width );
+                line[3*x + 1] = (uint8_t) ( (y + k * 8) * 255 / height );
+                line[3*x + 2] = (uint8_t) ( (seed >> 16) & 0x3F );
+            }
+        }
+    }
+
+    QString filename = QDir::temp().absoluteFilePath("__benchmark__");
+    int processors = qMax(1, (int) std::thread::hardware_concurrency());
+
+    for (int f = FORMAT_MP4_H264; f <= FORMAT_AVI_RAW && !_quit; ++f) {
+
+        double fps = 0.0, cpu = 0.0;
+        QString description;
+        VideoRecorder *recorder = NULL;
+
+        try {
+            recorder = VideoRecorder::getRecorder((encodingformat) f, filename, width, height, frameRate, quality);
+            recorder->open();
+            description = recorder->getFileDescription();
+
+            // encode as many frames as possible during the benchmark duration
+            QElapsedTimer timer;
+            timer.start();
+            std::clock_t cpustart = std::clock();
+            int n = 0;
+            while ( n < BENCHMARK_MAX_FRAMES && timer.elapsed() < BENCHMARK_DURATION && !_quit ) {
+                recorder->addFrame(frames[n % BENCHMARK_FRAME_COUNT]);
+                ++n;
+            }
+            // include the frames delayed by the encoder
+            while ( recorder->addFrame(NULL) );
+
+            double elapsed = qMax( (double) timer.elapsed(), 1.0) / 1000.0;
+            fps = (double) n / elapsed;
+            // NB: processor time of the whole process (rendering included)
+            cpu = 100.0 * ( (double) (std::clock() - cpustart) / (double) CLOCKS_PER_SEC ) / ( elapsed * (double) processors );
+
+            recorder->close();
+        }
+        catch (VideoRecorderException &e){
+            qWarning() << "EncoderBenchmark" << QChar(124).toLatin1() << e.message();
+            fps = 0.0;
+        }
+
+        if (recorder)
+            delete recorder;
+        QDir::temp().remove("__benchmark__");
+
+        if (!_quit) {
+            qDebug() << "EncoderBenchmark" << QChar(124).toLatin1() << tr("%1 : %2 fps (%3 % CPU) at %4 x %5.").arg(description.isEmpty() ? QString::number(f) : description).arg(fps, 0, 'f', 1).arg(cpu, 0, 'f', 0).arg(width).arg(height);
+            emit measured(f, fps, cpu, description);
+        }
+    }
+
+    for (int k = 0; k < BENCHMARK_FRAME_COUNT; ++k)
+        av_frame_free(&frames[k]);
+}
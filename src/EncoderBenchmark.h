@@ -0,0 +1,78 @@
+/*
+ * EncoderBenchmark.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef ENCODERBENCHMARK_H
+#define ENCODERBENCHMARK_H
+
+#include <QThread>
+#include <QString>
+
+#include "VideoRecorder.h"
+
+/**
+ * Maximum duration (ms) and number of frames encoded for each format
+ */
+#define BENCHMARK_DURATION 1000
+#define BENCHMARK_MAX_FRAMES 120
+/**
+ * An encoder is considered realtime if it encodes
+ * this factor faster than the recording frame rate
+ * (the rendering needs its share of the processor)
+ */
+#define BENCHMARK_REALTIME_FACTOR 1.2
+
+typedef struct {
+    double fps;     // frames encoded per second (0 if unavailable)
+    double cpu;     // percent of all processors used
+    QString description;
+} EncoderPerformance;
+
+/**
+ * Thread measuring the performance of every VideoRecorder
+ * by encoding synthetic frames at the given resolution.
+ *
+ * The result for each format is sent with the signal measured().
+ */
+class EncoderBenchmark: public QThread {
+
+    Q_OBJECT
+
+public:
+    EncoderBenchmark(int width, int height, int fps, encodingquality quality);
+
+    void stop() { _quit = true; }
+
+signals:
+    void measured(int format, double fps, double cpu, QString description);
+
+protected:
+    void run();
+
+    int width, height, frameRate;
+    encodingquality quality;
+    bool _quit;
+};
+
+#endif // ENCODERBENCHMARK_H
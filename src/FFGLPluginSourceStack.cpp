@@ -24,8 +24,10 @@
 #include "FFGLPluginSource.h"
 #include "FFGLPluginSourceShadertoy.h"
 #include "FFGLPluginSourceStack.h"
+#include "Profiler.h"
 
 #include <FFGL.h>
+#include <QFileInfo>
 
 
 FFGLPluginSourceStack::FFGLPluginSourceStack( FFGLPluginSource *ffgl_plugin )
@@ -234,10 +236,13 @@ void FFGLPluginSourceStack::update(){
     // update in the staking order, from original to top
     for (FFGLPluginSourceStack::iterator it = begin(); it != end(); ) {
         try {
+            Profiler::getInstance()->begin( QFileInfo((*it)->fileName()).baseName() );
             (*it)->update();
+            Profiler::getInstance()->end();
             ++it;
         }
         catch (FFGLPluginException &e) {
+            Profiler::getInstance()->end();
             // error on the plugin update : remove it
             qCritical() << (*it)->fileName() << QChar(124).toLatin1() <<  e.message() << QObject::tr("\nThe plugin was removed.");
             removePlugin(*it);
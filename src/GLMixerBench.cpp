@@ -0,0 +1,330 @@
+/*
+ * GLMixerBench.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+/*
+ * glmixer-bench : performance of a synthetic session
+ *
+ * Creates a session with video sources (playing a generated clip),
+ * algorithm sources, capture sources and FreeframeGL plugins, renders
+ * it in a widget not shown on screen for a number of frames and writes
+ * the measures in JSON:
+ *
+ *  glmixer-bench [--videos N] [--codec NAME] [--resolution WxH]
+ *                [--algorithms N] [--captures N] [--plugins N]
+ *                [--frames N] [--warmup N] [--output FILE]
+ */
+
+#include "common.h"
+#include "RenderingManager.h"
+#include "ViewRenderWidget.h"
+#include "OutputRenderWindow.h"
+#include "VideoFile.h"
+#include "VideoSource.h"
+#include "VideoRecorder.h"
+#include "AlgorithmSource.h"
+#include "Profiler.h"
+#include "glRenderWidget.h"
+
+#include <QApplication>
+#include <QStringList>
+#include <QVector>
+#include <QtAlgorithms>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QImage>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+#ifndef GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+// duration of the generated clip (frames at 25 fps)
+#define BENCH_CLIP_FRAMES 50
+#define BENCH_CLIP_FPS 25
+
+static QString option(const QStringList &args, const QString &name, const QString &defaultValue)
+{
+    int idx = args.indexOf(name);
+    if (idx > -1 && idx + 1 < args.size())
+        return args.at(idx + 1);
+    return defaultValue;
+}
+
+// free video memory (KB, -1 if the driver does not tell)
+static int freeVideoMemory()
+{
+    GLint kb[4] = {-1, -1, -1, -1};
+
+    if (glSupportedExtensions().contains("GL_NVX_gpu_memory_info"))
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, kb);
+    else if (glSupportedExtensions().contains("GL_ATI_meminfo"))
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kb);
+
+    return kb[0];
+}
+
+static QString jsonString(QString s)
+{
+    s.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+    return QString("\"%1\"").arg(s);
+}
+
+int main(int argc, char **argv)
+{
+#if QT_VERSION >= 0x040800
+    // the texture uploader and output presenter threads use OpenGL (Xlib)
+    QCoreApplication::setAttribute(Qt::AA_X11InitThreads);
+#endif
+    QApplication a(argc, argv);
+    a.setApplicationName("glmixer-bench");
+
+    QStringList args = a.arguments();
+    if (args.contains("-h") || args.contains("--help")) {
+        qDebug("%s [--videos N] [--codec NAME] [--resolution WxH] [--algorithms N] [--captures N] [--plugins N] [--frames N] [--warmup N] [--output FILE]", qPrintable(args.at(0)));
+        qDebug("codecs : %s", qPrintable(VideoRecorder::getCodecNames().join(" ")));
+        return EXIT_SUCCESS;
+    }
+
+    int videos = option(args, "--videos", "4").toInt();
+    QString codec = option(args, "--codec", "h264");
+    QStringList resolution = option(args, "--resolution", "1280x720").split("x");
+    int algorithms = option(args, "--algorithms", "0").toInt();
+    int captures = option(args, "--captures", "0").toInt();
+    int plugins = option(args, "--plugins", "0").toInt();
+    int frames = qMax(1, option(args, "--frames", "600").toInt());
+    int warmup = qMax(0, option(args, "--warmup", "60").toInt());
+    QString output = option(args, "--output", QString());
+
+    int width = resolution.size() == 2 ? resolution[0].toInt() : 0;
+    int height = resolution.size() == 2 ? resolution[1].toInt() : 0;
+    if (width < 16 || height < 16) {
+        qWarning() << "glmixer-bench" << QChar(124).toLatin1() << QObject::tr("Invalid resolution (e.g. 1280x720).");
+        return EXIT_FAILURE;
+    }
+
+    int format = VideoRecorder::getFormatFromCodecName(codec);
+    if (format < 0) {
+        qWarning() << "glmixer-bench" << QChar(124).toLatin1() << QObject::tr("Unknown codec %1.").arg(codec);
+        return EXIT_FAILURE;
+    }
+
+    if (!QGLFormat::hasOpenGL() )
+        qFatal( "%s", qPrintable( QObject::tr("This system does not support OpenGL and this program cannot work without it.")) );
+    initListOfExtension();
+    // same default as the preferences of glmixer
+    RenderingManager::setUsePboExtension(true);
+
+    //
+    // 1. The test clip (decoded by all the video sources)
+    //
+    QString clip = QDir::temp().absoluteFilePath(QString("glmixer-bench-%1").arg(a.applicationPid()));
+    if (videos > 0) {
+        try {
+            VideoRecorder::recordTestClip((encodingformat) format, clip, width, height, BENCH_CLIP_FPS, BENCH_CLIP_FRAMES);
+        }
+        catch (VideoRecorderException &e){
+            qWarning() << "glmixer-bench" << QChar(124).toLatin1() << e.message();
+            return EXIT_FAILURE;
+        }
+    }
+
+    //
+    // 2. The rendering, in widgets not shown on screen
+    //
+    RenderingManager *rm = RenderingManager::getInstance();
+    rm->setDynamicResolution(false);
+
+    ViewRenderWidget *w = RenderingManager::getRenderingWidget();
+    w->setAttribute(Qt::WA_DontShowOnScreen);
+    w->resize(1024, 768);
+    w->show();
+    OutputRenderWindow::getInstance()->setAttribute(Qt::WA_DontShowOnScreen);
+    OutputRenderWindow::getInstance()->show();
+    a.processEvents();
+
+    // frames are rendered by the benchmark, not at each tick of the timer
+    QObject::disconnect(glRenderTimer::getInstance(), SIGNAL(timeout()), 0, 0);
+
+    w->makeCurrent();
+    int vramBefore = freeVideoMemory();
+
+    //
+    // 3. The session
+    //
+    QList<VideoFile *> videoFiles;
+    QList<VideoSource *> videoSources;
+    QList<Source *> sources;
+
+    for (int i = 0; i < videos; ++i) {
+        VideoFile *vf = new VideoFile();
+        if ( !vf->open(clip) ) {
+            qWarning() << clip << QChar(124).toLatin1() << QObject::tr("The file could not be loaded.");
+            delete vf;
+            continue;
+        }
+        Source *s = rm->newMediaSource(vf);
+        if (!s) {
+            delete vf;
+            continue;
+        }
+        vf->setLoop(true);
+        vf->play(true);
+        videoFiles.append(vf);
+        videoSources.append( dynamic_cast<VideoSource *>(s) );
+        sources.append(s);
+    }
+
+    for (int i = 0; i < algorithms; ++i) {
+        // cycle through the algorithms (without NONE)
+        Source *s = rm->newAlgorithmSource(i % AlgorithmSource::NONE, width, height, 0.5, 0, false);
+        if (s)
+            sources.append(s);
+    }
+
+    for (int i = 0; i < captures; ++i) {
+        QImage image(width, height, QImage::Format_ARGB32);
+        image.fill( QColor::fromHsv( (i * 40) % 360, 200, 200).rgba() );
+        Source *s = rm->newCaptureSource(image);
+        if (s)
+            sources.append(s);
+    }
+
+    foreach (Source *s, sources) {
+#ifdef GLM_FFGL
+        for (int p = 0; p < plugins; ++p)
+            s->addFreeframeGLPlugin();
+#endif
+        rm->insertSource(s);
+    }
+#ifndef GLM_FFGL
+    if (plugins > 0)
+        qWarning() << "glmixer-bench" << QChar(124).toLatin1() << QObject::tr("Compiled without FreeframeGL; plugins ignored.");
+#endif
+
+    //
+    // 4. Render
+    //
+    Profiler::getInstance()->setEnabled(true);
+
+    for (int i = 0; i < warmup; ++i) {
+        a.processEvents();
+        w->updateGL();
+    }
+
+    qint64 decodedBefore = 0, uploadedBefore = 0;
+    foreach (VideoFile *vf, videoFiles)
+        decodedBefore += vf->getDecodedFrameCount();
+    foreach (VideoSource *vs, videoSources)
+        uploadedBefore += vs->getUploadedBytes();
+
+    QVector<double> frameTimes;
+    frameTimes.reserve(frames);
+    int vramLowest = vramBefore;
+    QElapsedTimer timer, frameTimer;
+    timer.start();
+    for (int i = 0; i < frames; ++i) {
+        frameTimer.start();
+        a.processEvents();
+        w->updateGL();
+        frameTimes.append( (double) frameTimer.nsecsElapsed() / 1000000.0 );
+
+        if (vramBefore > -1 && i % 30 == 0) {
+            w->makeCurrent();
+            vramLowest = qMin(vramLowest, freeVideoMemory());
+        }
+    }
+    w->makeCurrent();
+    glFinish();
+    double elapsed = qMax( (double) timer.nsecsElapsed(), 1.0) / 1000000000.0;
+
+    qint64 decoded = -decodedBefore, uploaded = -uploadedBefore;
+    foreach (VideoFile *vf, videoFiles)
+        decoded += vf->getDecodedFrameCount();
+    foreach (VideoSource *vs, videoSources)
+        uploaded += vs->getUploadedBytes();
+
+    double mean = 0.0;
+    foreach (double t, frameTimes)
+        mean += t;
+    mean /= (double) frameTimes.size();
+    qSort(frameTimes);
+
+    //
+    // 5. Results
+    //
+    QFile file;
+    if (output.isEmpty())
+        file.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    else {
+        file.setFileName(output);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning() << output << QChar(124).toLatin1() << QObject::tr("Cannot write results.");
+            return EXIT_FAILURE;
+        }
+    }
+
+    QTextStream out(&file);
+    out << "{\n";
+    out << "  \"session\": { \"videos\": " << videoSources.size() << ", \"codec\": " << jsonString(codec)
+        << ", \"width\": " << width << ", \"height\": " << height
+        << ", \"algorithms\": " << algorithms << ", \"captures\": " << captures << ", \"plugins\": " << plugins
+        << ", \"frames\": " << frames << " },\n";
+    out << "  \"renderer\": " << jsonString( QString( (char *) glGetString(GL_RENDERER) ) ) << ",\n";
+    out << "  \"framebuffer\": { \"width\": " << rm->getFrameBufferWidth() << ", \"height\": " << rm->getFrameBufferHeight() << " },\n";
+    out << "  \"composite_fps\": " << QString::number( (double) frames / elapsed, 'f', 2) << ",\n";
+    out << "  \"frame_ms\": { \"mean\": " << QString::number(mean, 'f', 3)
+        << ", \"p95\": " << QString::number(frameTimes[ (int) (0.95 * (frameTimes.size() - 1)) ], 'f', 3)
+        << ", \"max\": " << QString::number(frameTimes.last(), 'f', 3) << " },\n";
+    out << "  \"decode_fps\": " << QString::number( (double) decoded / elapsed, 'f', 2) << ",\n";
+    out << "  \"upload_bytes_per_second\": " << QString::number( (double) uploaded / elapsed, 'f', 0) << ",\n";
+    out << "  \"peak_rss_bytes\": " << getPeakResidentMemory() << ",\n";
+    out << "  \"vram_used_bytes\": " << (vramBefore > -1 ? (qint64) (vramBefore - vramLowest) * 1024 : (qint64) -1) << ",\n";
+    out << "  \"stages\": [";
+    QList<Profiler::Timing> timings = Profiler::getInstance()->timings();
+    for (int i = 0; i < timings.size(); ++i) {
+        out << (i > 0 ? ",\n" : "\n") << "    { \"name\": " << jsonString(timings[i].name)
+            << ", \"depth\": " << timings[i].depth
+            << ", \"gpu_ms\": " << QString::number(timings[i].gpu, 'f', 3)
+            << ", \"cpu_ms\": " << QString::number(timings[i].cpu, 'f', 3) << " }";
+    }
+    out << "\n  ]\n}\n";
+    out.flush();
+    file.close();
+
+    //
+    // 6. Cleanup
+    //
+    Profiler::getInstance()->setEnabled(false);
+    RenderingManager::deleteInstance();
+    OutputRenderWindow::deleteInstance();
+    QDir::temp().remove(clip);
+
+    return EXIT_SUCCESS;
+}
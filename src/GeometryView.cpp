@@ -123,11 +123,12 @@ void GeometryView::paint()
         // 2. Draw it into current view
         //
 
-        // place and scale
-        glPushMatrix();
-        glTranslated(s->getX(), s->getY(), s->getDepth());
-        glRotated(s->getRotationAngle(), 0.0, 0.0, 1.0);
-        glScaled(s->getScaleX(), s->getScaleY(), 1.f);
+        // place and scale (given to the vertex shader)
+        QMatrix4x4 transform;
+        transform.translate(s->getX(), s->getY(), s->getDepth());
+        transform.rotate(s->getRotationAngle(), 0.0, 0.0, 1.0);
+        transform.scale(s->getScaleX(), s->getScaleY());
+        ViewRenderWidget::setSourceTransform(transform);
 
         // Blending Function For mixing like in the rendering window
         s->blend();
@@ -137,7 +138,7 @@ void GeometryView::paint()
             // Draw source in canvas if not exclusive display
             if ( !WorkspaceManager::getInstance()->isExclusiveDisplay() ) {
                 // draw shadow version of the source
-                ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_baseAlpha, (GLfloat) s->getAlpha() * WORKSPACE_MAX_ALPHA);
+                ViewRenderWidget::setBaseAlpha((GLfloat) s->getAlpha() * WORKSPACE_MAX_ALPHA);
                 s->draw();
             }
         }
@@ -145,9 +146,8 @@ void GeometryView::paint()
         // Draw source in canvas
             s->draw();
 
-        // done geometry
-        glPopMatrix();
-
+        // done geometry (the catalog draws the next source without transform)
+        ViewRenderWidget::setSourceTransform();
     }
 
     // Re-Draw frame buffer in the render window
@@ -155,14 +155,13 @@ void GeometryView::paint()
     ViewRenderWidget::resetShaderAttributes(); // switch to drawing mode
     // in exclusive workspace or if rendering is paused, still show the outcome, but faded
     if ( WorkspaceManager::getInstance()->isExclusiveDisplay() || RenderingManager::getInstance()->isPaused())
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_baseAlpha, WORKSPACE_MAX_ALPHA);
+        ViewRenderWidget::setBaseAlpha(WORKSPACE_MAX_ALPHA);
     // draw
     glPushMatrix();
     glScaled( OutputRenderWindow::getInstance()->getAspectRatio()* SOURCE_UNIT, 1.0* SOURCE_UNIT, 1.0);
     glBindTexture(GL_TEXTURE_2D, RenderingManager::getInstance()->getFrameBufferTexture());
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glCallList(ViewRenderWidget::vertex_array_coords);
-    glDrawArrays(GL_QUADS, 0, 4);
+    ViewRenderWidget::drawQuad();
     glPopMatrix();
 
     // unset mode for source
@@ -931,72 +930,46 @@ bool GeometryView::hasObjectAtCoordinates(int mouseX, int mouseY, int objectdisp
 }
 
 
-bool GeometryView::getSourcesAtCoordinates(int mouseX, int mouseY) {
+bool GeometryView::isSourceAtCoordinates(const Source *s, double x, double y, double tolerance) {
 
-    // prepare variables
-    GLuint selectBuf[SELECTBUFSIZE] = { 0 };
-    GLint hits = 0;
+    // vector from the source center to the point
+    x -= s->getX();
+    y -= s->getY();
 
-    // init picking
-    glSelectBuffer(SELECTBUFSIZE, selectBuf);
-    (void) glRenderMode(GL_SELECT);
+    // rotate into the source orientation
+    double cosa = cos(-s->getRotationAngle() / 180.0 * M_PI);
+    double sina = sin(-s->getRotationAngle() / 180.0 * M_PI);
+    double u = x * cosa - y * sina;
+    double v = y * cosa + x * sina;
 
-    // picking in name 0, labels set later
-    glInitNames();
-    glPushName(0);
+    // the source quad spans [-1, 1] scaled (scale can be negative when flipped)
+    return ( ABS(u) <= ABS(s->getScaleX()) + tolerance && ABS(v) <= ABS(s->getScaleY()) + tolerance );
+}
 
-    // use the projection as it is, but remember it.
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    // setup the projection for picking
-    glLoadIdentity();
-    gluPickMatrix((double) mouseX, (double) mouseY, 1.0, 1.0, viewport);
-    glMultMatrixd(projection);
 
-    // rendering for select mode
-    glMatrixMode(GL_MODELVIEW);
+bool GeometryView::getSourcesAtCoordinates(int mouseX, int mouseY) {
+
+    // coordinates of the cursor in the scene (and of the border of the pixel for tolerance)
+    double cursorx = 0.0, cursory = 0.0, borderx = 0.0, bordery = 0.0, dumm = 0.0;
+    gluUnProject((double) mouseX, (double) mouseY, 0.0, modelview, projection, viewport, &cursorx, &cursory, &dumm);
+    gluUnProject((double) mouseX + 0.5, (double) mouseY, 0.0, modelview, projection, viewport, &borderx, &bordery, &dumm);
+    double tolerance = ABS(borderx - cursorx);
+
+    clickedSources.clear();
 
+    // test the oriented quad of every source under the cursor,
+    // same candidates as drawn in the view (without GL_SELECT)
     if ( SelectionManager::getInstance()->hasSelection() ) {
-        glPushMatrix();
-        // place and scale
-        glTranslated(SelectionManager::getInstance()->selectionSource()->getX(), SelectionManager::getInstance()->selectionSource()->getY(), 40);
-        glRotated(SelectionManager::getInstance()->selectionSource()->getRotationAngle(), 0.0, 0.0, 1.0);
-        glScaled(SelectionManager::getInstance()->selectionSource()->getScaleX(), SelectionManager::getInstance()->selectionSource()->getScaleY(), 1.f);
-        SelectionManager::getInstance()->selectionSource()->draw(GL_SELECT);
-        glPopMatrix();
+        Source *s = SelectionManager::getInstance()->selectionSource();
+        if ( isSourceAtCoordinates(s, cursorx, cursory, tolerance) )
+            clickedSources.insert(s);
     }
 
     for(SourceSet::iterator  its = RenderingManager::getInstance()->getBegin(); its != RenderingManager::getInstance()->getEnd(); its++) {
         if ((*its)->isStandby() || !WorkspaceManager::getInstance()->isInCurrent(*its) )
             continue;
-        glPushMatrix();
-        // place and scale
-        glTranslated((*its)->getX(), (*its)->getY(), (*its)->getDepth());
-        glRotated((*its)->getRotationAngle(), 0.0, 0.0, 1.0);
-        glScaled((*its)->getScaleX(), (*its)->getScaleY(), 1.f);
-        (*its)->draw(GL_SELECT);
-        glPopMatrix();
-    }
-
-    // compute picking . return to rendering mode
-    hits = glRenderMode(GL_RENDER);
-
-//    qDebug ("%d hits @ (%d,%d) vp (%d, %d, %d, %d)", hits, mouseX, mouseY, viewport[0], viewport[1], viewport[2], viewport[3]);
-
-    // set the matrices back
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-
-
-    clickedSources.clear();
-    while (hits != 0) {
-        GLuint id = selectBuf[ (hits-1) * 4 + 3];
-        if ( id == SelectionManager::getInstance()->selectionSource()->getId() )
-            clickedSources.insert(SelectionManager::getInstance()->selectionSource());
-        else
-            clickedSources.insert( *(RenderingManager::getInstance()->getById(id)) );
-        hits--;
+        if ( isSourceAtCoordinates(*its, cursorx, cursory, tolerance) )
+            clickedSources.insert(*its);
     }
 
     return sourceClicked();
@@ -64,6 +64,7 @@ public:
     static QRectF getBoundingBox(const SourceList &l, bool invert_y=false);
 
     bool getSourcesAtCoordinates(int mouseX, int mouseY);
+    static bool isSourceAtCoordinates(const Source *s, double x, double y, double tolerance = 0.0);
     void alignSelection(View::Axis a, View::RelativePoint p, View::Reference r);
     void distributeSelection(View::Axis a, View::RelativePoint p);
     void transformSelection(View::Transformation t, View::Axis a, View::Reference r);
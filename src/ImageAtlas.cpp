@@ -117,7 +117,7 @@ bool ImageAtlas::appendImages(QStringList files)
                 glPixelStorei(GL_UNPACK_ROW_LENGTH, p->getRowLength());
                 glTexImage2D(GL_TEXTURE_2D, 0, format, p->getWidth(),
                              p->getHeight(), 0, format, GL_UNSIGNED_BYTE, p->getBuffer());
-                glCallList(ViewRenderWidget::quad_texured);
+                ViewRenderWidget::drawQuad();
                 glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
                 // next index
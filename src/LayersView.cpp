@@ -44,9 +44,8 @@
 #define DEFAULT_LOOKAT 5.0
 #define DEFAULT_PANNING -2.f, 0.f, 0.1f
 #define MAX_PANNING 4.0
-#define PICKING_FBO_FACTOR 8
 
-void drawDepthMap(double width);
+double depthMapAt(const double *origin, const double *direction, double width);
 
 bool LayersSelectionArea::contains(SourceSet::iterator s)
 {
@@ -119,10 +118,7 @@ LayersView::LayersView(): View(View::LAYER), lookatdistance(DEFAULT_LOOKAT), for
     icon.load(QString::fromUtf8(":/glmixer/icons/depth.png"));
     title = " Layers";
 
-    picking_fbo = NULL;
-    picking_fbo_map = NULL;
     picking_map_width = 0.0;
-    picking_map_needsupdate = true;
 }
 
 
@@ -132,8 +128,6 @@ void LayersView::setModelview()
     glTranslatef(getPanningX(), getPanningY(), getPanningZ());
     gluLookAt(lookatdistance, lookatdistance, lookatdistance + zoom, 0.0, 0.0, zoom, 0.0, 1.0, 0.0);
     glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
-
-    picking_map_needsupdate = true;
 }
 
 
@@ -224,7 +218,7 @@ void LayersView::paint()
         if ( WorkspaceManager::getInstance()->isInCurrent(s)) {
 
             //   draw stippled version of the source
-            ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_stippling, (float) ViewRenderWidget::getStipplingMode() / 100.f);
+            ViewRenderWidget::setStippling((float) ViewRenderWidget::getStipplingMode() / 100.f);
 
             s->draw();
 
@@ -316,20 +310,6 @@ void LayersView::resize(int w, int h)
     gluPerspective(50.0f, (double)  viewport[2] / (double)  viewport[3], 0.1f, lookatdistance * 10.0f);
 
     glGetDoublev(GL_PROJECTION_MATRIX, projection);
-
-    // delete previous picking fbo
-    if (picking_fbo)
-        delete picking_fbo;
-    // create a picking fbo of the same size of the window
-    picking_fbo = new QGLFramebufferObject(QSize(w / PICKING_FBO_FACTOR, h / PICKING_FBO_FACTOR));
-
-    // do the same with the image to get the fbo texture into
-    if (picking_fbo_map)
-        delete [] picking_fbo_map;
-    picking_fbo_map = new GLfloat[ 3 * w * h / PICKING_FBO_FACTOR];
-    // inform that the picking map needs to be recomputed
-    picking_map_needsupdate = true;
-
 }
 
 
@@ -457,7 +437,6 @@ bool LayersView::mousePressEvent ( QMouseEvent *event )
     if (forwardSources.size() > 0) {
         forwardSources.clear();
         picking_map_width = 0;
-        picking_map_needsupdate = true;
     }
 
     return false;
@@ -527,7 +506,6 @@ bool LayersView::mouseMoveEvent ( QMouseEvent *event ) {
                 bringForward(clicked);
 
                 picking_map_width = MAXDISPLACEMENT + clicked->getAspectRatio() +  OutputRenderWindow::getInstance()->getAspectRatio();
-                picking_map_needsupdate = true;
                 picking_grab_depth = unProjectDepth(event->x(), viewport[3] - event->y());
             }
 
@@ -570,7 +548,6 @@ bool LayersView::mouseReleaseEvent ( QMouseEvent * event ){
     if (forwardSources.size() > 0) {
         forwardSources.clear();
         picking_map_width = 0;
-        picking_map_needsupdate = true;
     }
 
     // reset list of clicked sources
@@ -781,180 +758,72 @@ void LayersView::coordinatesFromMouse(int mouseX, int mouseY, double *X, double
     *Y = *X;
 }
 
-// the principle of the depth map is to render a gradient of color
-// following the depth of the layers view, and to pick the color to get
-// the depth. The depth map is made so that the RGB sum (R + G + B) is
-// linearily growing from (0,0,0) at deph 0 to (1,1,1) at MAX DEPTH LAYER
+// the principle of the depth map is to cast the ray under the cursor on
+// walls placed around the layers view, and to take the depth of the point hit.
+// The depth is linearily growing with z from 0 to MAX DEPTH LAYER on the walls,
+// except on the upper limit (always MAX DEPTH LAYER) and outside walls (0).
 
-void drawDepthMap(double width)
+bool hitDepthMapWall(const double *origin, const double *direction, int axis, double position,
+                     double min, double max, double minz, double maxz, double *z)
 {
-    glClearColor(0.f, 0.f, 0.f, 1.f);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    //    glEnable(GL_BLEND);
-    glShadeModel(GL_SMOOTH);
-
-    glTranslated(-OutputRenderWindow::getInstance()->getAspectRatio(), 0.0, 0.0);
-
-    glBegin(GL_QUADS);
-    // white upper limit
-    glColor4f(1.0, 1.0, 1.0, 1.0);
-    glVertex3d(0.0, -1.0, MAX_DEPTH_LAYER * 2.0);
-    glVertex3d(0, 10.0, MAX_DEPTH_LAYER * 2.0);
-    glVertex3d(0, 10.0, MAX_DEPTH_LAYER / 2.0);
-    glVertex3d(0, -1.0, MAX_DEPTH_LAYER / 2.0);
-    glVertex3d(0.0, -1.0, MAX_DEPTH_LAYER * 2.0);
-    glVertex3d(10.0, -1.0, MAX_DEPTH_LAYER * 2.0);
-    glVertex3d(10.0, -1.0, MAX_DEPTH_LAYER / 2.0);
-    glVertex3d(0.0, -1.0, MAX_DEPTH_LAYER / 2.0);
-
-    //  WALL on X = 0
-    glVertex3d(0, 1.0, MAX_DEPTH_LAYER);
-    glVertex3d(0, 10.0, MAX_DEPTH_LAYER);
-    glColor4f(1.0, 1.0, 0.0, 1.0);
-    glVertex3d(0, 10.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(0, 1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-
-    glVertex3d(0, 1.0, 2.0 * MAX_DEPTH_LAYER  / 3.0 );
-    glVertex3d(0, 10.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glColor4f(0.0, 0.0, 1.0, 1.0);
-    glVertex3d(0, 10.0, MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(0, 1.0, MAX_DEPTH_LAYER / 3.0);
-
-    glVertex3d(0, 1.0, MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(0, 10.0, MAX_DEPTH_LAYER / 3.0);
-    glColor4f(0.0, 0.0, 0.0, 1.0);
-    glVertex3d(0, 10.0, 0.0);
-    glVertex3d(0, 1.0, 0.0);
-
-    // Border up the bounding box
-    glVertex3d(0.0, 1.0, 0.0);
-    glVertex3d(width, 1.0, 0.0);
-    glColor4f(0.0, 0.0, 1.0, 1.0);
-    glVertex3d(width, 1.0, MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(0.0, 1.0, MAX_DEPTH_LAYER / 3.0);
-
-    glVertex3d(0.0, 1.0, MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(width, 1.0, MAX_DEPTH_LAYER / 3.0);
-    glColor4f(1.0, 1.0, 0.0, 1.0);
-    glVertex3d(width, 1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(0.0, 1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-
-    glVertex3d(0.0, 1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(width, 1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glColor4f(1.0, 1.0, 1.0, 1.0);
-    glVertex3d(width, 1.0, MAX_DEPTH_LAYER);
-    glVertex3d(0.0, 1.0, MAX_DEPTH_LAYER);
+    // ray parallel to the wall
+    if ( ABS(direction[axis]) < EPSILON )
+        return false;
 
-    // Border right of the bounding box
-    glVertex3d(width, -1.0, MAX_DEPTH_LAYER);
-    glVertex3d(width, 1.0, MAX_DEPTH_LAYER);
-    glColor4f(1.0, 1.0, 0.0, 1.0);
-    glVertex3d(width, 1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(width, -1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-
-    glVertex3d(width, -1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(width, 1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glColor4f(0.0, 0.0, 1.0, 1.0);
-    glVertex3d(width, 1.0, MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(width, -1.0, MAX_DEPTH_LAYER / 3.0);
-
-    glVertex3d(width, -1.0, MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(width, 1.0, MAX_DEPTH_LAYER / 3.0);
-    glColor4f(0.0, 0.0, 0.0, 1.0);
-    glVertex3d(width, 1.0, 0.0);
-    glVertex3d(width, -1.0, 0.0);
+    // intersection of the ray (between near and far planes) with the wall
+    double t = (position - origin[axis]) / direction[axis];
+    if ( t < 0.0 || t > 1.0 )
+        return false;
 
-    // wall Y = -1
-    glVertex3d(width, -1.0, 0.0);
-    glVertex3d(10.0, -1.0, 0.0);
-    glColor4f(0.0, 0.0, 1.0, 1.0);
-    glVertex3d(10.0, -1.0, MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(width, -1.0, MAX_DEPTH_LAYER / 3.0);
-
-    glVertex3d(width, -1.0, MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(10.0, -1.0, MAX_DEPTH_LAYER / 3.0);
-    glColor4f(1.0, 1.0, 0.0, 1.0);
-    glVertex3d(10.0, -1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(width, -1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-
-    glVertex3d(width, -1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glVertex3d(10.0, -1.0, 2.0 * MAX_DEPTH_LAYER / 3.0);
-    glColor4f(1.0, 1.0, 1.0, 1.0);
-    glVertex3d(10.0, -1.0, MAX_DEPTH_LAYER);
-    glVertex3d(width, -1.0, MAX_DEPTH_LAYER);
+    // inside the wall ?
+    double u = origin[1 - axis] + t * direction[1 - axis];
+    double w = origin[2] + t * direction[2];
+    if ( u < MINI(min, max) || u > MAXI(min, max) || w < minz || w > maxz )
+        return false;
 
-    glEnd();
+    *z = w;
+    return true;
 }
 
-double LayersView::unProjectDepth(int x, int y)
+double depthMapAt(const double *origin, const double *direction, double width)
 {
-    // cannot perform picking without fbo and its map
-    if (!picking_fbo || !picking_fbo_map)
-        return -1.0;
-
-    if (picking_map_needsupdate)
-    {
-        if (!picking_fbo->bind())
-            qWarning() << "Cound not perform picking";
+    double z = 0.0;
 
-        // make sure we render as in the view settings
-        glPushAttrib( GL_COLOR_BUFFER_BIT  | GL_VIEWPORT_BIT | GL_LIGHTING_BIT );
-        glViewport(0, 0, picking_fbo->width(), picking_fbo->height());
-        glMatrixMode(GL_PROJECTION);
-        glPushMatrix();
-        glLoadMatrixd(projection);
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
-        glLoadMatrixd(modelview);
+    // walls are tested in front to back order of drawing (the last one drawn is visible)
 
-        // draw the depth map into the FBO
-        drawDepthMap(picking_map_width);
-
-        // restore state
-        glMatrixMode(GL_PROJECTION);
-        glPopMatrix();
-        glMatrixMode(GL_MODELVIEW);
-        glPopMatrix();
-        glPopAttrib();
-
-        // done rendering into the fbo
-        picking_fbo->release();
-
-        // access the texture of the picking frame buffer object
-        glBindTexture(GL_TEXTURE_2D, picking_fbo->texture());
-        // store the texture of the picking fbo map into RAM for future use
-        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_FLOAT, picking_fbo_map);
-
-        // unbind texture
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDisable(GL_TEXTURE_2D);
-
-        // done updating the picking map : no need to update it
-        picking_map_needsupdate = false;
-    }
-
-    // convert the picking coordinates to fbo factor
-    x /= PICKING_FBO_FACTOR;
-    y /= PICKING_FBO_FACTOR;
-
-
-    // mean filter around the pixel of coordinates (x, y) in the depth map texture
-    double sum = 0.0;
-    for ( int i = ( y - 1 ) ; i < ( y + 2 ); ++i)
-        for ( int j = ( x - 1 )  ; j < ( x + 2 ) ; ++j) {
-            sum += picking_fbo_map[(picking_fbo->width() * 3) * i + j * 3];
-            sum += picking_fbo_map[(picking_fbo->width() * 3) * i + j * 3 + 1];
-            sum += picking_fbo_map[(picking_fbo->width() * 3) * i + j * 3 + 2];
-        }
+    // wall Y = -1
+    if ( hitDepthMapWall(origin, direction, 1, -1.0, width, 10.0, 0.0, MAX_DEPTH_LAYER, &z) )
+        return z;
+    // Border right of the bounding box
+    if ( hitDepthMapWall(origin, direction, 0, width, -1.0, 1.0, 0.0, MAX_DEPTH_LAYER, &z) )
+        return z;
+    // Border up the bounding box
+    if ( hitDepthMapWall(origin, direction, 1, 1.0, 0.0, width, 0.0, MAX_DEPTH_LAYER, &z) )
+        return z;
+    //  WALL on X = 0
+    if ( hitDepthMapWall(origin, direction, 0, 0.0, 1.0, 10.0, 0.0, MAX_DEPTH_LAYER, &z) )
+        return z;
+    // upper limit
+    if ( hitDepthMapWall(origin, direction, 0, 0.0, -1.0, 10.0, MAX_DEPTH_LAYER / 2.0, MAX_DEPTH_LAYER * 2.0, &z)
+      || hitDepthMapWall(origin, direction, 1, -1.0, 0.0, 10.0, MAX_DEPTH_LAYER / 2.0, MAX_DEPTH_LAYER * 2.0, &z) )
+        return MAX_DEPTH_LAYER;
+
+    return 0.0;
+}
 
-    // depth is encoded in the image as (R + G + B) / 3  (for 9 pixels)
-    return ( MAX_DEPTH_LAYER * sum / 27.0 );
+double LayersView::unProjectDepth(int x, int y)
+{
+    // ray under the cursor, from the near plane to the far plane
+    double origin[3], direction[3];
+    gluUnProject((double) x, (double) y, 0.0, modelview, projection, viewport, origin, origin + 1, origin + 2);
+    gluUnProject((double) x, (double) y, 1.0, modelview, projection, viewport, direction, direction + 1, direction + 2);
+    for (int i = 0; i < 3; ++i)
+        direction[i] -= origin[i];
 
-    // find the index in the depth map of the pixel of coordinates (x, y)
-//    int pixelindex = (picking_fbo->width() * 3) * y  + x * 3;
-//    return ( MAX_DEPTH_LAYER * (picking_fbo_map[pixelindex] + picking_fbo_map[pixelindex+1] + picking_fbo_map[pixelindex+2])/ 3.0 );
+    // the depth map is placed on the left of the frame
+    origin[0] += OutputRenderWindow::getInstance()->getAspectRatio();
 
+    return depthMapAt(origin, direction, picking_map_width);
 }
 
 void LayersView::moveSource(Source *s, double depthchange, bool setcurrent)
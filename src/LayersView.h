@@ -81,9 +81,7 @@ private:
 
     // selection area
     LayersSelectionArea _selectionArea;
-    QGLFramebufferObject *picking_fbo;
-    GLfloat *picking_fbo_map;
-    double picking_map_width, picking_grab_depth, picking_map_needsupdate;
+    double picking_map_width, picking_grab_depth;
 
 };
 
@@ -0,0 +1,294 @@
+/*
+ * MetricsManager.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#include "MetricsManager.moc"
+
+#include "RenderingManager.h"
+#include "RenderingEncoder.h"
+#include "VideoSource.h"
+#include "VideoPicture.h"
+#include "glRenderWidget.h"
+
+#include <QTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QStringList>
+#include <QRegExp>
+#include <QDebug>
+
+MetricsManager *MetricsManager::_instance = 0;
+
+MetricsManager *MetricsManager::getInstance() {
+
+    if (_instance == 0) {
+        _instance = new MetricsManager();
+        Q_CHECK_PTR(_instance);
+    }
+
+    return _instance;
+}
+
+MetricsManager::MetricsManager() : QObject(), _server(0), _port(9464), _previousEncoded(0)
+{
+    _previousHistogram.fill(0, PRESENT_HISTOGRAM_SIZE);
+    _elapsed.start();
+
+    // started by updateTimer()
+    _timer = new QTimer(this);
+    _timer->setInterval(METRICS_INTERVAL);
+    connect(_timer, SIGNAL(timeout()), this, SLOT(update()));
+}
+
+void MetricsManager::updateTimer()
+{
+    bool needed = isEnabled() || receivers(SIGNAL(updated())) > 0;
+
+    if (needed && !_timer->isActive()) {
+        // reference values for the rates of the next update
+        blockSignals(true);
+        update();
+        blockSignals(false);
+        _timer->start();
+    }
+    else if (!needed && _timer->isActive())
+        _timer->stop();
+}
+
+void MetricsManager::connectNotify(const char *signal)
+{
+    if (qstrcmp(signal, SIGNAL(updated())) == 0)
+        updateTimer();
+}
+
+void MetricsManager::disconnectNotify(const char *signal)
+{
+    // (no signal given when all are disconnected)
+    if (!signal || qstrcmp(signal, SIGNAL(updated())) == 0)
+        updateTimer();
+}
+
+bool MetricsManager::isEnabled() const
+{
+    return ( _server != 0 );
+}
+
+void MetricsManager::setEnabled(bool enable, quint16 port)
+{
+    // reset server
+    if ( _server ) {
+        delete _server;
+        _server = 0;
+    }
+
+    _port = port;
+
+    if (enable) {
+        _server = new QTcpServer(this);
+        connect(_server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+
+        // only local clients (e.g. a Prometheus agent on this computer)
+        if ( _server->listen(QHostAddress::LocalHost, _port) )
+            qDebug() << "MetricsManager" << QChar(124).toLatin1() << tr("Metrics served on http://127.0.0.1:%1/metrics").arg(_port);
+        else {
+            qWarning() << "MetricsManager" << QChar(124).toLatin1() << tr("Cannot serve metrics on port %1 (%2).").arg(_port).arg(_server->errorString());
+            delete _server;
+            _server = 0;
+        }
+    }
+    else
+        qDebug() << "MetricsManager" << QChar(124).toLatin1() << tr("Metrics server disabled.");
+
+    updateTimer();
+}
+
+void MetricsManager::add(QString name, QString help, double value, QString source, bool counter)
+{
+    Metric m;
+    m.name = name;
+    m.help = help;
+    m.counter = counter;
+    m.source = source;
+    m.value = value;
+    _metrics.append(m);
+}
+
+// upper limit (ms) of the interval of the given fraction of the frames
+static double percentile(const QVector<int> &histogram, int total, double fraction)
+{
+    int count = 0;
+    for (int i = 0; i < histogram.size(); ++i) {
+        count += histogram[i];
+        if ( (double) count >= fraction * (double) total )
+            return (double) (i + 1);
+    }
+    return (double) histogram.size();
+}
+
+void MetricsManager::update()
+{
+    double seconds = qMax( (double) _elapsed.restart(), 1.0) / 1000.0;
+
+    _metrics.clear();
+
+    // output : frames presented since the last update
+    QVector<int> histogram = glRenderTimer::getInstance()->presentIntervalHistogram();
+    QVector<int> frames(histogram.size(), 0);
+    int total = 0;
+    bool reset = false;
+    for (int i = 0; i < histogram.size() && !reset; ++i)
+        reset = i < _previousHistogram.size() && histogram[i] < _previousHistogram[i];
+    for (int i = 0; i < histogram.size(); ++i) {
+        frames[i] = reset || i >= _previousHistogram.size() ? histogram[i] : histogram[i] - _previousHistogram[i];
+        total += frames[i];
+    }
+    _previousHistogram = histogram;
+
+    add("glmixer_output_fps", "Frames presented per second on the output", (double) total / seconds);
+    if (total > 0) {
+        add("glmixer_output_frame_interval_p50_ms", "Median interval between presented frames", percentile(frames, total, 0.5));
+        add("glmixer_output_frame_interval_p95_ms", "95th percentile of the interval between presented frames", percentile(frames, total, 0.95));
+        add("glmixer_output_frame_interval_p99_ms", "99th percentile of the interval between presented frames", percentile(frames, total, 0.99));
+    }
+
+    // video sources : queue of pictures and frames
+    RenderingManager *rm = RenderingManager::getInstance();
+    QMap<QString, int> decoded;
+    double decodedRate = 0.0;
+    for (SourceSet::const_iterator its = rm->getBegin(); rm->notAtEnd(its); ++its) {
+
+        if ( (*its)->rtti() != Source::VIDEO_SOURCE )
+            continue;
+        VideoFile *vf = ( dynamic_cast<VideoSource *>(*its) )->getVideoFile();
+        if (!vf)
+            continue;
+
+        QString name = (*its)->getName();
+        int count = vf->getPictureQueueCount();
+        int size = vf->getPictureQueueSize();
+
+        add("glmixer_source_pictq_count", "Pictures decoded waiting in the queue of the source", count, name);
+        add("glmixer_source_pictq_size", "Maximum number of pictures in the queue of the source", size, name);
+        add("glmixer_source_pictq_fill", "Ratio of the queue of pictures used", size > 0 ? (double) count / (double) size : 0.0, name);
+        add("glmixer_source_dropped_frames_total", "Frames decoded but not shown", vf->getDroppedFrameCount(), name, true);
+
+        int n = vf->getDecodedFrameCount();
+        int previous = _previousDecoded.value(name, 0);
+        double rate = n < previous ? 0.0 : (double) (n - previous) / seconds;
+        add("glmixer_source_decode_fps", "Frames decoded per second for the source", rate, name);
+        decoded[name] = n;
+        decodedRate += rate;
+    }
+    _previousDecoded = decoded;
+
+    add("glmixer_video_sources", "Number of video sources", decoded.size());
+    add("glmixer_decode_fps", "Frames decoded per second for all sources", decodedRate);
+    add("glmixer_picture_memory_bytes", "Memory allocated for decoded pictures", (double) VideoPicture::getPictureMapsMemory());
+
+    // recorder
+    RenderingEncoder *rec = RenderingManager::getRecorder();
+    if (rec) {
+        int encoded = rec->encodedFrameCount();
+        double rate = encoded < _previousEncoded ? 0.0 : (double) (encoded - _previousEncoded) / seconds;
+        _previousEncoded = encoded;
+
+        add("glmixer_recorder_active", "Recording in progress", rec->isActive() ? 1.0 : 0.0);
+        add("glmixer_recorder_queue_count", "Frames waiting to be encoded", rec->encoderQueueCount());
+        add("glmixer_recorder_queue_size", "Maximum number of frames waiting to be encoded", rec->encoderQueueSize());
+        add("glmixer_recorder_skipped_frames_total", "Frames skipped by the recording because the queue was full", rec->skippedFrameCount(), QString(), true);
+        add("glmixer_encode_fps", "Frames encoded per second", rate);
+    }
+
+    emit updated();
+}
+
+QString MetricsManager::prometheusText() const
+{
+    // the samples of a metric are grouped after its description
+    QStringList names;
+    foreach (const Metric &m, _metrics)
+        if (!names.contains(m.name))
+            names.append(m.name);
+
+    QString text;
+    foreach (const QString &name, names) {
+        bool first = true;
+        foreach (const Metric &m, _metrics) {
+            if (m.name != name)
+                continue;
+            if (first) {
+                text += QString("# HELP %1 %2\n").arg(m.name).arg(m.help);
+                text += QString("# TYPE %1 %2\n").arg(m.name).arg(m.counter ? "counter" : "gauge");
+                first = false;
+            }
+            text += m.name;
+            if (!m.source.isEmpty()) {
+                QString label = m.source;
+                label.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+                text += QString("{source=\"%1\"}").arg(label);
+            }
+            text += QString(" %1\n").arg(m.value, 0, 'g', 10);
+        }
+    }
+
+    return text;
+}
+
+void MetricsManager::newConnection()
+{
+    while (_server && _server->hasPendingConnections()) {
+        QTcpSocket *socket = _server->nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+void MetricsManager::readRequest()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket || !socket->canReadLine())
+        return;
+
+    // request line, e.g. 'GET /metrics HTTP/1.1'
+    QStringList request = QString::fromLatin1(socket->readLine()).split(QRegExp("\\s+"), QString::SkipEmptyParts);
+
+    QByteArray body;
+    QByteArray status = "200 OK";
+    if (request.size() < 2 || request[0] != "GET")
+        status = "405 Method Not Allowed";
+    else if (request[1] != "/metrics" && request[1] != "/")
+        status = "404 Not Found";
+    else
+        body = prometheusText().toUtf8();
+
+    QByteArray response = "HTTP/1.0 " + status + "\r\n";
+    response += "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+
+    disconnect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+    socket->write(response);
+    socket->disconnectFromHost();
+}
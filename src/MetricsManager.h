@@ -0,0 +1,120 @@
+/*
+ * MetricsManager.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef METRICSMANAGER_H
+#define METRICSMANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+
+class QTimer;
+class QTcpServer;
+
+/**
+ * Interval (ms) between two updates of the metrics
+ */
+#define METRICS_INTERVAL 1000
+
+/**
+ * Registry of the health metrics of the program.
+ *
+ * The metrics are updated every second (output frame rate and
+ * intervals, picture queues and dropped frames of video sources,
+ * memory of pictures, decoding and encoding rates), only while
+ * the HTTP server runs or a receiver is connected to updated().
+ *
+ * They are broadcasted over OSC by the OpenSoundControlManager (when enabled)
+ * and served in the Prometheus text format by a HTTP server on localhost:
+ *
+ *      http://127.0.0.1:<port>/metrics
+ */
+class MetricsManager: public QObject
+{
+    Q_OBJECT
+
+public:
+    static MetricsManager *getInstance();
+
+    // HTTP server on localhost
+    void setEnabled(bool enable, quint16 port);
+    bool isEnabled() const;
+    quint16 getPort() const { return _port; }
+
+    typedef struct {
+        QString name;
+        QString help;
+        bool counter;
+        // label 'source' for the metrics of a source (empty otherwise)
+        QString source;
+        double value;
+    } Metric;
+
+    // last values of the metrics
+    QList<Metric> metrics() const { return _metrics; }
+    // text exposition format of Prometheus
+    QString prometheusText() const;
+
+public slots:
+    void update();
+
+signals:
+    void updated();
+
+private slots:
+    void newConnection();
+    void readRequest();
+
+protected:
+    // start or stop the updates with the receivers of updated()
+    void connectNotify(const char *signal);
+    void disconnectNotify(const char *signal);
+
+private:
+    MetricsManager();
+    static MetricsManager *_instance;
+
+    // update only if someone reads the metrics
+    void updateTimer();
+
+    void add(QString name, QString help, double value, QString source = QString(), bool counter = false);
+
+    QTimer *_timer;
+    QTcpServer *_server;
+    quint16 _port;
+
+    QList<Metric> _metrics;
+
+    // previous values to compute rates
+    QElapsedTimer _elapsed;
+    QVector<int> _previousHistogram;
+    QMap<QString, int> _previousDecoded;
+    int _previousEncoded;
+};
+
+#endif // METRICSMANAGER_H
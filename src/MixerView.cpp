@@ -211,12 +211,12 @@ void MixerView::paint()
 
             if (!s->isStandby())  {
                 //   draw stippled version of the source
-                ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_stippling, (GLfloat) ViewRenderWidget::getStipplingMode() / 100.f);
+                ViewRenderWidget::setStippling((GLfloat) ViewRenderWidget::getStipplingMode() / 100.f);
             }
             else {
                 // draw flat version of the source
-                ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_baseAlpha, 1.f);
-                ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_fading, 1.f);
+                ViewRenderWidget::setBaseAlpha(1.f);
+                ViewRenderWidget::setFading(1.f);
             }
 
             s->draw();
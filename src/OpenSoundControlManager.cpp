@@ -10,6 +10,7 @@
 #include "SourcePropertyBrowser.h"
 #include "glmixer.h"
 #include "VideoSource.h"
+#include "MetricsManager.h"
 
 #ifdef GLM_SNAPSHOT
 #include "SnapshotManager.h"
@@ -89,6 +90,7 @@ void OpenSoundControlManager::setEnabled(bool enable, qint16 portreceive, qint16
         delete _udpBroadcast;
         _udpBroadcast = 0;
         disconnect(RenderingManager::getInstance(), SIGNAL(countSourceChanged(int)), this, SLOT(broadcastSourceCount(int)));
+        disconnect(MetricsManager::getInstance(), SIGNAL(updated()), this, SLOT(broadcastMetrics()));
     }
 
     // set ports
@@ -101,6 +103,7 @@ void OpenSoundControlManager::setEnabled(bool enable, qint16 portreceive, qint16
 
         // listen to broadcasting messages
         connect(RenderingManager::getInstance(), SIGNAL(countSourceChanged(int)), this, SLOT(broadcastSourceCount(int)));
+        connect(MetricsManager::getInstance(), SIGNAL(updated()), this, SLOT(broadcastMetrics()));
 
         // bind socket and connect reading slot
         _udpReceive = new QUdpSocket(this);
@@ -134,7 +137,7 @@ void OpenSoundControlManager::setEnabled(bool enable, qint16 portreceive, qint16
 }
 
 
-void OpenSoundControlManager::broadcastDatagram(QString property, QVariantList args)
+void OpenSoundControlManager::broadcastDatagram(QString property, QVariantList args, bool periodic)
 {
     // ignore invalid
     if (!_udpBroadcast || property.isEmpty())
@@ -177,7 +180,8 @@ void OpenSoundControlManager::broadcastDatagram(QString property, QVariantList a
     // broadcast message
     _udpBroadcast->writeDatagram( p.Data(), p.Size(), QHostAddress::Broadcast, _portBroadcast);
 
-    emit log(QString("Broadcast %1").arg(p.Data()) );
+    if (!periodic || _verbose)
+        emit log(QString("Broadcast %1").arg(p.Data()) );
 }
 
 
@@ -680,6 +684,18 @@ void OpenSoundControlManager::executeRender(QString property, QVariantList args)
         
         GLMixer::getInstance()->toggleRender();
     }
+    else if ( property.compare(OSC_RENDER_REPLAY, Qt::CaseInsensitive) == 0 ) {
+        // if argument is given, react only to TRUE value
+        if ( args.size() < 1 || !args[0].isValid() || args[0].toBool() )
+            RenderingManager::getRecorder()->saveReplay();
+    }
+    else if ( property.compare(OSC_RENDER_STREAM, Qt::CaseInsensitive) == 0 ) {
+        bool val = true;
+        // optional argument
+        if (args.size() > 0 && args[0].isValid())
+            val = args[0].toBool();
+        RenderingManager::getRecorder()->setStreamingActive( val );
+    }
 #ifdef GLM_SESSION
     else if ( property.compare(OSC_RENDER_NEXT, Qt::CaseInsensitive) == 0 ) {
         // if argument is given, react only to TRUE value
@@ -709,6 +725,20 @@ void OpenSoundControlManager::broadcastSourceCount(int count)
     broadcastDatagram( OSC_REQUEST_COUNT, args );
 }
 
+void OpenSoundControlManager::broadcastMetrics()
+{
+    // one message per metric, e.g. /glmixer/metrics/output_fps f 60.0
+    // (with the name of the source first for the metrics of a source)
+    foreach (const MetricsManager::Metric &m, MetricsManager::getInstance()->metrics()) {
+        QVariantList args;
+        if (!m.source.isEmpty())
+            args.append(m.source);
+        args.append(m.value);
+        QString name = m.name;
+        broadcastDatagram( QString("%1/%2").arg(OSC_REQUEST_METRICS).arg(name.remove(QRegExp("^glmixer_"))), args, true );
+    }
+}
+
 void OpenSoundControlManager::broadcastCurrentSource()
 {
     // if the current source is valid
@@ -777,6 +807,12 @@ void OpenSoundControlManager::executeRequest(QString property, QVariantList args
 
         broadcastCurrentSource();
     }
+    // Target ATTRIBUTE for request : metrics (health of the program)
+    else if ( property.compare(OSC_REQUEST_METRICS, Qt::CaseInsensitive) == 0 ) {
+
+        MetricsManager::getInstance()->update();
+        emit log(QString("Replied /glmixer/%1 (%2 values)").arg(OSC_REQUEST_METRICS).arg(MetricsManager::getInstance()->metrics().size()) );
+    }
     // Target ATTRIBUTE for request : name (of the source at given index)
     else if ( property.compare(OSC_REQUEST_NAME, Qt::CaseInsensitive) == 0 ) {
         // read the argument : index of source requested
@@ -42,6 +42,8 @@
 #define OSC_RENDER_NEXT "next"
 #define OSC_RENDER_PREVIOUS "previous"
 #define OSC_RENDER_TOGGLE "toggle"
+#define OSC_RENDER_REPLAY "replay"
+#define OSC_RENDER_STREAM "stream"
 #define OSC_SOURCE_PRESET "preset"
 #define OSC_SOURCE_CURRENT "current"
 #define OSC_SOURCE_PLAY "play"
@@ -61,6 +63,7 @@
 #define OSC_REQUEST_NAME "name"
 #define OSC_REQUEST_CURRENT "current"
 #define OSC_REQUEST_CONNECT "connection"
+#define OSC_REQUEST_METRICS "metrics"
 #define OSC_SNAPSHOT "snapshot"
 
 
@@ -115,7 +118,8 @@ public:
     qint16 getPortReceive();
     qint16 getPortBroadcast();
 
-    void broadcastDatagram(QString property, QVariantList args = QVariantList());
+    // periodic messages are logged only in verbose mode
+    void broadcastDatagram(QString property, QVariantList args = QVariantList(), bool periodic = false);
 
     // translator
     void addTranslation(QString before, QString after);
@@ -131,6 +135,7 @@ public slots:
     void readPendingDatagrams();
     void broadcastSourceCount(int count);
     void broadcastCurrentSource();
+    void broadcastMetrics();
 
 signals:
     void log(QString);
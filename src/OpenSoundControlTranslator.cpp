@@ -3,6 +3,7 @@
 
 #include "common.h"
 #include "OpenSoundControlManager.h"
+#include "MetricsManager.h"
 
 #include <QMenu>
 #include <QDesktopServices>
@@ -218,11 +219,15 @@ OpenSoundControlTranslator::OpenSoundControlTranslator(QSettings *settings, QWid
     ui->OSCPort->setValue( OpenSoundControlManager::getInstance()->getPortReceive() );
     ui->OSCBroadcastPort->setValue( OpenSoundControlManager::getInstance()->getPortBroadcast() );
     ui->verboseLogs->setChecked( OpenSoundControlManager::getInstance()->isVerbose() );
+    ui->enableMetrics->setChecked( MetricsManager::getInstance()->isEnabled() );
+    ui->MetricsPort->setValue( MetricsManager::getInstance()->getPort() );
 
     // connect GUI to Manager
     connect(ui->enableOSC, SIGNAL(toggled(bool)), this, SLOT(updateManager()) );
     connect(ui->OSCPort, SIGNAL(valueChanged(int)), this, SLOT(updateManager()) );
     connect(ui->OSCBroadcastPort, SIGNAL(valueChanged(int)), this, SLOT(updateManager()) );
+    connect(ui->enableMetrics, SIGNAL(toggled(bool)), this, SLOT(updateMetrics()) );
+    connect(ui->MetricsPort, SIGNAL(valueChanged(int)), this, SLOT(updateMetrics()) );
     connect(ui->clearLogs, SIGNAL(clicked(bool)), this, SLOT(logStatus()) );
 
     // connect logs
@@ -311,6 +316,13 @@ void OpenSoundControlTranslator::updateManager()
     logStatus();
 }
 
+void OpenSoundControlTranslator::updateMetrics()
+{
+    MetricsManager::getInstance()->setEnabled(ui->enableMetrics->isChecked(), (quint16) ui->MetricsPort->value());
+
+    logStatus();
+}
+
 
 void OpenSoundControlTranslator::on_translationPresets_currentIndexChanged(int i)
 {
@@ -351,6 +363,8 @@ void OpenSoundControlTranslator::logStatus()
     }
     else
         logMessage(tr("Disabled"));
+    if (MetricsManager::getInstance()->isEnabled())
+        logMessage(tr("Metrics served on http://127.0.0.1:%1/metrics").arg(MetricsManager::getInstance()->getPort()) );
     ui->consoleOSC->setTextColor(Qt::white);
 }
 
@@ -62,6 +62,7 @@ public:
 
 public slots:
     void updateManager();
+    void updateMetrics();
     void contextMenu(QPoint);
     void removeSelection();
 
@@ -26,6 +26,7 @@
 #include "OpencvSource.moc"
 
 #include "RenderingManager.h"
+#include "Tracer.h"
 
 #include <opencv2/imgproc/imgproc_c.h>
 #include <opencv2/core/version.hpp>
@@ -41,6 +42,7 @@ class CameraThread: public QThread {
 public:
     CameraThread(OpencvSource *source) :
         QThread(), cvs(source), end(true) {
+        setObjectName("CameraThread");
     }
     ~CameraThread() {
     }
@@ -70,10 +72,13 @@ void CameraThread::run(){
     t.start();
     while (!end) {
 
-        cvs->mutex->lock();
+        TRACE_WAIT("wait mutex", cvs->mutex->lock());
         if (!cvs->frameChanged) {
 
-            if ( cvGrabFrame( cvs->capture )) {
+            bool grabbed = false;
+            TRACE_WAIT("grab frame", grabbed = cvGrabFrame( cvs->capture ));
+            if ( grabbed ) {
+                TRACE_SCOPE("retrieve frame");
                 raw = cvRetrieveFrame( cvs->capture );
 
                 if (cvs->needFrameCopy)
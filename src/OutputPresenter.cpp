@@ -0,0 +1,292 @@
+/*
+ * OutputPresenter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#include "OutputPresenter.h"
+
+#include "RenderingManager.h"
+#include "OutputRenderWindow.h"
+#include "glRenderWidget.h"
+#include "Tracer.h"
+
+#include <QGLFramebufferObject>
+#include <QDebug>
+
+OutputPresenter *OutputPresenter::_instance = 0;
+
+bool OutputPresenter::isSupported()
+{
+    static int supported = -1;
+
+    if (supported < 0) {
+        supported = RenderingManager::useFboBlitExtension() && glewIsSupported("GL_ARB_sync") ? 1 : 0;
+        qDebug() << "OutputPresenter" << QChar(124).toLatin1() << QObject::tr("Output window presented in a thread (GL_ARB_sync) ") << (supported ? "ON" : "OFF");
+    }
+
+    return supported > 0;
+}
+
+OutputPresenter *OutputPresenter::getInstance()
+{
+    if (_instance == 0) {
+        _instance = new OutputPresenter(OutputRenderWindow::getInstance());
+        Q_CHECK_PTR(_instance);
+        _instance->start(QThread::HighPriority);
+    }
+
+    return _instance;
+}
+
+void OutputPresenter::deleteInstance()
+{
+    if (_instance != 0)
+        delete _instance;
+    _instance = 0;
+}
+
+OutputPresenter::OutputPresenter(QGLWidget *window) : QThread(), _window(window), _quit(false), _changed(false),
+    latest(-1), _visible(false), _faded(false), _overlayChanged(false), overlayTexture(0)
+{
+    setObjectName("OutputPresenter");
+
+    for (int i = 0; i < 2; ++i) {
+        frames[i] = NULL;
+        frameTextures[i] = 0;
+        frameWritten[i] = 0;
+        frameRead[i] = 0;
+    }
+
+    // the context of the window is made current in the thread
+    if (QGLContext::currentContext() == _window->context())
+        _window->doneCurrent();
+}
+
+OutputPresenter::~OutputPresenter()
+{
+    // stop the thread
+    mutex.lock();
+    _quit = true;
+    presentRequested.wakeAll();
+    mutex.unlock();
+    wait();
+
+    for (int i = 0; i < 2; ++i) {
+        if (frameWritten[i])
+            glDeleteSync(frameWritten[i]);
+        if (frameRead[i])
+            glDeleteSync(frameRead[i]);
+        if (frames[i])
+            delete frames[i];
+    }
+}
+
+void OutputPresenter::publish(QGLFramebufferObject *fbo)
+{
+    if (!fbo)
+        return;
+
+    QMutexLocker locker(&mutex);
+
+    int next = (latest + 1) % 2;
+
+    // the thread shall be done drawing this frame before it is overwritten
+    if (frameRead[next]) {
+        glWaitSync(frameRead[next], 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(frameRead[next]);
+        frameRead[next] = 0;
+    }
+
+    // frames have the size of the frame buffer
+    if (!frames[next] || frames[next]->size() != fbo->size()) {
+        if (frames[next])
+            delete frames[next];
+        frames[next] = new QGLFramebufferObject(fbo->size());
+        frameTextures[next] = frames[next]->texture();
+    }
+
+    // copy the frame buffer
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo->handle());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frames[next]->handle());
+    glBlitFramebuffer(0, 0, fbo->width(), fbo->height(), 0, 0, fbo->width(), fbo->height(),
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // signal when the copy is done (flushed for the thread to wait for it)
+    if (frameWritten[next])
+        glDeleteSync(frameWritten[next]);
+    frameWritten[next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    latest = next;
+    _changed = true;
+    presentRequested.wakeAll();
+}
+
+void OutputPresenter::setLayout(QSize size, QRect target, bool visible, bool faded)
+{
+    QMutexLocker locker(&mutex);
+
+    if (size != _size || target != _target || visible != _visible || faded != _faded) {
+        _size = size;
+        _target = target;
+        _visible = visible;
+        _faded = faded;
+        _changed = true;
+        presentRequested.wakeAll();
+    }
+}
+
+void OutputPresenter::setOverlay(const QImage &image)
+{
+    QMutexLocker locker(&mutex);
+
+    _overlay = image;
+    _overlayChanged = true;
+    _changed = true;
+    presentRequested.wakeAll();
+}
+
+void OutputPresenter::requestPresent()
+{
+    QMutexLocker locker(&mutex);
+
+    _changed = true;
+    presentRequested.wakeAll();
+}
+
+void OutputPresenter::run()
+{
+    _window->makeCurrent();
+
+    // state for drawing textures without blending by default
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glActiveTexture(GL_TEXTURE0);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glClearColor(0.f, 0.f, 0.f, 1.f);
+    glGenTextures(1, &overlayTexture);
+
+    mutex.lock();
+    while (!_quit) {
+
+        // wait for something new to present
+        if (!_changed) {
+            presentRequested.wait(&mutex);
+            continue;
+        }
+        _changed = false;
+
+        // draw with the lock (short) and swap without (waits for vsync)
+        TRACE_WAIT("present", present());
+        mutex.unlock();
+
+        TRACE_WAIT("swapBuffers", _window->swapBuffers());
+        glRenderTimer::getInstance()->framePresented();
+
+        mutex.lock();
+    }
+    mutex.unlock();
+
+    glDeleteTextures(1, &overlayTexture);
+    _window->doneCurrent();
+}
+
+void OutputPresenter::present()
+{
+    int w = _size.width();
+    int h = _size.height();
+
+    glViewport(0, 0, w, h);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0.0, w, 0.0, h, -1.0, 1.0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // nothing to show
+    if (!_visible || latest < 0)
+        return;
+
+    // wait (on the GPU) for the copy of the frame to be done
+    if (frameWritten[latest]) {
+        glWaitSync(frameWritten[latest], 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(frameWritten[latest]);
+        frameWritten[latest] = 0;
+    }
+
+    // draw the frame in the target area
+    glEnable(GL_TEXTURE_2D);
+    glColor4f(1.f, 1.f, 1.f, 1.f);
+    glBindTexture(GL_TEXTURE_2D, frameTextures[latest]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.f, 0.f); glVertex2i(_target.left(), _target.top());
+    glTexCoord2f(1.f, 0.f); glVertex2i(_target.right(), _target.top());
+    glTexCoord2f(1.f, 1.f); glVertex2i(_target.right(), _target.bottom());
+    glTexCoord2f(0.f, 1.f); glVertex2i(_target.left(), _target.bottom());
+    glEnd();
+
+    // the frame can be overwritten after this
+    if (frameRead[latest])
+        glDeleteSync(frameRead[latest]);
+    frameRead[latest] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    glEnable(GL_BLEND);
+
+    // filter to show it is disabled
+    if (_faded) {
+        glDisable(GL_TEXTURE_2D);
+        glColor4ub(COLOR_FADING, 128);
+        glRecti(0, 0, w, h);
+        glEnable(GL_TEXTURE_2D);
+    }
+
+    // labels (image upside down)
+    if (_overlayChanged) {
+        glBindTexture(GL_TEXTURE_2D, overlayTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        if (!_overlay.isNull())
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _overlay.width(), _overlay.height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, _overlay.constBits());
+        _overlayChanged = false;
+    }
+    if (!_overlay.isNull()) {
+        glColor4f(1.f, 1.f, 1.f, 1.f);
+        glBindTexture(GL_TEXTURE_2D, overlayTexture);
+        glBegin(GL_QUADS);
+        glTexCoord2f(0.f, 0.f); glVertex2i(0, h);
+        glTexCoord2f(1.f, 0.f); glVertex2i(w, h);
+        glTexCoord2f(1.f, 1.f); glVertex2i(w, 0);
+        glTexCoord2f(0.f, 1.f); glVertex2i(0, 0);
+        glEnd();
+    }
+
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,99 @@
+/*
+ * OutputPresenter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef OUTPUTPRESENTER_H
+#define OUTPUTPRESENTER_H
+
+#include "common.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QRect>
+
+class QGLFramebufferObject;
+
+/**
+ * Thread drawing the output window with its OpenGL context.
+ *
+ * After rendering, the frame buffer is copied into one of two frames
+ * given to the thread (with fences in both directions). The thread
+ * draws the most recent frame and swaps buffers; waiting for the
+ * vertical synchronization of the output does not block the GUI thread,
+ * and the output is presented again when exposed even if the GUI is busy.
+ *
+ * The GUI thread only gives the layout of the window and an image
+ * of the labels (no OpenGL call on the output window).
+ */
+class OutputPresenter: public QThread {
+
+public:
+    static OutputPresenter *getInstance();
+    static void deleteInstance();
+    static inline bool isActive() { return _instance != 0; }
+
+    // are blit and sync objects available ?
+    static bool isSupported();
+
+    // rendering context : give the frame to present
+    void publish(QGLFramebufferObject *fbo);
+
+    // GUI thread : geometry of the window, area of the frame and labels
+    void setLayout(QSize size, QRect target, bool visible, bool faded);
+    void setOverlay(const QImage &image);
+    void requestPresent();
+
+protected:
+    void run();
+
+private:
+    OutputPresenter(QGLWidget *window);
+    ~OutputPresenter();
+    static OutputPresenter *_instance;
+
+    void present();
+
+    QGLWidget *_window;
+    QMutex mutex;
+    QWaitCondition presentRequested;
+    bool _quit, _changed;
+
+    // double buffer of frames
+    QGLFramebufferObject *frames[2];
+    GLuint frameTextures[2];
+    GLsync frameWritten[2], frameRead[2];
+    int latest;
+
+    // layout of the window
+    QSize _size;
+    QRect _target;
+    bool _visible, _faded;
+    QImage _overlay;
+    bool _overlayChanged;
+    GLuint overlayTexture;
+};
+
+#endif // OUTPUTPRESENTER_H
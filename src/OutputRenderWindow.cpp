@@ -28,8 +28,10 @@
 #include "RenderingManager.h"
 #include "RenderingEncoder.h"
 #include "ViewRenderWidget.h"
+#include "OutputPresenter.h"
 
 #include <QGLFramebufferObject>
+#include <QPainter>
 #include <QApplication>
 #include <QDesktopWidget>
 
@@ -79,47 +81,8 @@ void OutputRenderWidget::resizeGL(int w, int h)
     glRenderWidget::resizeGL(w, h);
 
     if ( RenderingManager::blit_fbo_extension ) {
-        // respect the aspect ratio of the rendering manager
-        if ( useAspectRatio ) {
-            float renderingAspectRatio = RenderingManager::getInstance()->getFrameBufferAspectRatio();
-            if (aspectRatio < renderingAspectRatio) {
-                int nh = (int)( float(w) / renderingAspectRatio);
-                rx = 0;
-                ry = vcentered_resize ? (h - nh) / 2 : (h - nh) ;
-                rw = w;
-                rh = vcentered_resize ? (h + nh) / 2 : h ;
-            } else {
-                int nw = (int)( float(h) * renderingAspectRatio );
-                rx = (w - nw) / 2;
-                ry = 0;
-                rw = (w + nw) / 2;
-                rh = h;
-            }
-        }
-        // the option 'free aspect ratio' is on ; use the window dimensions
-        // (only valid for widget, not window)
-        else if ( useWindowAspectRatio ) {
-            float windowAspectRatio = OutputRenderWindow::getInstance()->aspectRatio;
-            if ( aspectRatio < windowAspectRatio) {
-                int nh = (int)( float(w) / windowAspectRatio);
-                rx = 0;
-                ry = vcentered_resize ? (h - nh) / 2 : (h - nh) ;
-                rw = w;
-                rh = vcentered_resize ? (h + nh) / 2 : h ;
-
-            } else {
-                int nw = (int)( float(h) * windowAspectRatio );
-                rx = (w - nw) / 2;
-                ry = 0;
-                rw = (w + nw) / 2;
-                rh = h;
-            }
-        } else {
-            rx = 0;
-            ry = 0;
-            rw = w;
-            rh = h;
-        }
+        // area of the widget where to blit the frame buffer
+        resizeTarget(w, h);
     }
     else
     {
@@ -143,14 +106,64 @@ void OutputRenderWidget::resizeGL(int w, int h)
     }
 
     // Adjust size of font
-    labelpointsize = (w*labelwidthpercent/100) / 10;
-    labelfont = QFont(getMonospaceFont(), labelpointsize, QFont::Bold);
-    labelheight = QFontMetrics(labelfont).height();
+    resizeLabels(w);
 
     // done resize
     need_resize = false;
 }
 
+void OutputRenderWidget::resizeTarget(int w, int h)
+{
+    // respect the aspect ratio of the rendering manager
+    if ( useAspectRatio ) {
+        float renderingAspectRatio = RenderingManager::getInstance()->getFrameBufferAspectRatio();
+        if (aspectRatio < renderingAspectRatio) {
+            int nh = (int)( float(w) / renderingAspectRatio);
+            rx = 0;
+            ry = vcentered_resize ? (h - nh) / 2 : (h - nh) ;
+            rw = w;
+            rh = vcentered_resize ? (h + nh) / 2 : h ;
+        } else {
+            int nw = (int)( float(h) * renderingAspectRatio );
+            rx = (w - nw) / 2;
+            ry = 0;
+            rw = (w + nw) / 2;
+            rh = h;
+        }
+    }
+    // the option 'free aspect ratio' is on ; use the window dimensions
+    // (only valid for widget, not window)
+    else if ( useWindowAspectRatio ) {
+        float windowAspectRatio = OutputRenderWindow::getInstance()->aspectRatio;
+        if ( aspectRatio < windowAspectRatio) {
+            int nh = (int)( float(w) / windowAspectRatio);
+            rx = 0;
+            ry = vcentered_resize ? (h - nh) / 2 : (h - nh) ;
+            rw = w;
+            rh = vcentered_resize ? (h + nh) / 2 : h ;
+
+        } else {
+            int nw = (int)( float(h) * windowAspectRatio );
+            rx = (w - nw) / 2;
+            ry = 0;
+            rw = (w + nw) / 2;
+            rh = h;
+        }
+    } else {
+        rx = 0;
+        ry = 0;
+        rw = w;
+        rh = h;
+    }
+}
+
+void OutputRenderWidget::resizeLabels(int w)
+{
+    labelpointsize = (w*labelwidthpercent/100) / 10;
+    labelfont = QFont(getMonospaceFont(), labelpointsize, QFont::Bold);
+    labelheight = QFontMetrics(labelfont).height();
+}
+
 
 void OutputRenderWindow::resizeGL(int w, int h)
 {
@@ -159,6 +172,82 @@ void OutputRenderWindow::resizeGL(int w, int h)
     emit resized();
 }
 
+void OutputRenderWindow::updateGL()
+{
+    // drawn by the presentation thread : no OpenGL here,
+    // only give the layout of the window
+    if ( OutputPresenter::isActive() ) {
+
+        if (need_resize) {
+            aspectRatio = (float) width() / (float) height();
+            resizeTarget(width(), height());
+            resizeLabels(width());
+            need_resize = false;
+            emit resized();
+        }
+
+        OutputPresenter::getInstance()->setLayout(size(), QRect(QPoint(rx, ry), QPoint(rw, rh)), isVisible() && output_active, !isEnabled());
+        updateLabels();
+    }
+    else
+        OutputRenderWidget::updateGL();
+}
+
+void OutputRenderWindow::glDraw()
+{
+    OutputRenderWidget::glDraw();
+
+    // buffers were swapped
+    glRenderTimer::getInstance()->framePresented();
+}
+
+void OutputRenderWindow::updateLabels()
+{
+    int labels = (isEnabled() && info_label_active ? 1 : 0) | (rec_label_active ? 2 : 0);
+
+    if (labels == presentedLabels && size() == presentedLabelsSize)
+        return;
+    presentedLabels = labels;
+    presentedLabelsSize = size();
+
+    // draw the labels in an image (empty if no label)
+    QImage image;
+    if (labels) {
+        static QColor shadow = QColor(50, 50, 50, 100);
+        image = QImage(size(), QImage::Format_ARGB32);
+        image.fill(0);
+        QPainter painter(&image);
+        painter.setFont(labelfont);
+        if (labels & 1) {
+            static QColor white = QColor(250, 250, 250, 230);
+            QString label = " Pause";
+            painter.setPen( shadow );
+            painter.drawText(1, labelheight+1, label);
+            painter.setPen( white );
+            painter.drawText(0, labelheight, label);
+        }
+        if (labels & 2) {
+            static QColor red = QColor(200, 10, 10, 240);
+            QString label = " Rec";
+            painter.setPen( shadow );
+            painter.drawText(1, height() - labelheight / 2 + 1, label);
+            painter.setPen( red );
+            painter.drawText(0, height() - labelheight / 2, label);
+        }
+    }
+
+    OutputPresenter::getInstance()->setOverlay(image);
+}
+
+void OutputRenderWindow::paintEvent ( QPaintEvent *e )
+{
+    // exposed : present again
+    if ( OutputPresenter::isActive() )
+        OutputPresenter::getInstance()->requestPresent();
+    else
+        OutputRenderWidget::paintEvent(e);
+}
+
 void OutputRenderWidget::useFreeAspectRatio(bool on)
 {
     useAspectRatio = !on;
@@ -203,7 +292,7 @@ void OutputRenderWidget::paintGL()
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
         // draw the polygon with texture
-        glCallList(ViewRenderWidget::quad_texured);
+        ViewRenderWidget::drawQuad();
     }
 
     // filter to show it is disabled
@@ -277,6 +366,7 @@ OutputRenderWindow::OutputRenderWindow() : OutputRenderWidget(0, (QGLWidget *)Re
     windowGeometry = QRect(100,100,848,480);
     setGeometry( windowGeometry );
     switching = false;
+    presentedLabels = 0;
 
     // init screen index
     fullscreenMonitorIndex = 0;
@@ -450,7 +540,11 @@ void OutputRenderWindow::keyPressEvent(QKeyEvent * event) {
 
 void OutputRenderWindow::resizeEvent ( QResizeEvent * e )
 {
-    this->OutputRenderWidget::resizeEvent(e);
+    // the presentation thread owns the context
+    if ( OutputPresenter::isActive() )
+        need_resize = true;
+    else
+        this->OutputRenderWidget::resizeEvent(e);
 
     // store the geometry of the window when it is not fullscreen (to revert back to it)
     if ( ! switching )
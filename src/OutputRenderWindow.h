@@ -59,6 +59,9 @@ public slots:
     void displayInformationLabel(bool on) { info_label_active = on; need_resize = true;}
 
 protected:
+    void resizeTarget(int w, int h);
+    void resizeLabels(int w);
+
     bool useAspectRatio, useWindowAspectRatio;
     int rx, ry, rw, rh;
     bool need_resize, vcentered_resize;
@@ -83,8 +86,11 @@ public:
 
     void initializeGL();
     void resizeGL(int w = 0, int h = 0);
+    void updateGL();
+    void glDraw();
     void moveEvent ( QMoveEvent * );
     void resizeEvent ( QResizeEvent * );
+    void paintEvent ( QPaintEvent * );
 
     // events handling
     void keyPressEvent(QKeyEvent * event);
@@ -115,6 +121,11 @@ private:
     int fullscreenMonitorIndex, fullscreenMonitorCount;
     QRect windowGeometry;
     bool switching;
+
+    // labels drawn by the presentation thread
+    void updateLabels();
+    int presentedLabels;
+    QSize presentedLabelsSize;
 };
 
 #endif /* OUTPUTRENDERWINDOW_H_ */
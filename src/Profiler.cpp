@@ -0,0 +1,241 @@
+/*
+ * Profiler.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+
+#include "Profiler.h"
+
+#include <QObject>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+Profiler *Profiler::_instance = 0;
+
+bool Profiler::isSupported()
+{
+    static int supported = -1;
+
+    if (supported < 0) {
+        supported = glewIsSupported("GL_ARB_timer_query") ? 1 : 0;
+        qDebug() << "Profiler" << QChar(124).toLatin1() << QObject::tr("OpenGL timer queries (GL_ARB_timer_query) ") << (supported ? "ON" : "OFF");
+    }
+
+    return supported > 0;
+}
+
+Profiler *Profiler::getInstance()
+{
+    if (_instance == 0) {
+        _instance = new Profiler;
+        Q_CHECK_PTR(_instance);
+    }
+
+    return _instance;
+}
+
+void Profiler::deleteInstance()
+{
+    if (_instance != 0)
+        delete _instance;
+    _instance = 0;
+}
+
+Profiler::Profiler() : enabled(false), frameNumber(0), current(0)
+{
+    for (int i = 0; i < 2; ++i) {
+        frameNumbers[i] = 0;
+        queryCount[i] = 0;
+    }
+
+    cpuTimer.start();
+}
+
+Profiler::~Profiler()
+{
+    for (int i = 0; i < 2; ++i)
+        if (!queries[i].isEmpty())
+            glDeleteQueries(queries[i].size(), queries[i].data());
+}
+
+void Profiler::setEnabled(bool on)
+{
+    enabled = on;
+
+    // forget the frames in flight
+    for (int i = 0; i < 2; ++i) {
+        frames[i].clear();
+        queryCount[i] = 0;
+    }
+    stack.clear();
+    averages.clear();
+}
+
+void Profiler::beginFrame()
+{
+    if (!enabled)
+        return;
+
+    // close a frame not ended
+    endFrame();
+
+    // read the frame issued two frames ago, and use its queries again
+    current = (current + 1) % 2;
+    collect(current);
+    frames[current].clear();
+    queryCount[current] = 0;
+    frameNumbers[current] = ++frameNumber;
+
+    begin(QObject::tr("Frame"));
+}
+
+void Profiler::endFrame()
+{
+    while (!stack.isEmpty())
+        end();
+}
+
+void Profiler::begin(const QString &name)
+{
+    if (!enabled || frames[current].size() >= PROFILER_MAX_SECTIONS)
+        return;
+
+    Section s;
+    s.name = name;
+    s.depth = stack.size();
+    s.begin = 0;
+    s.end = 0;
+
+    // timestamps can be nested (unlike time elapsed queries)
+    if (isSupported()) {
+        if (queries[current].size() < queryCount[current] + 2) {
+            GLuint q[2];
+            glGenQueries(2, q);
+            queries[current].append(q[0]);
+            queries[current].append(q[1]);
+        }
+        s.begin = queries[current][queryCount[current]++];
+        s.end = queries[current][queryCount[current]++];
+        glQueryCounter(s.begin, GL_TIMESTAMP);
+    }
+
+    s.cpubegin = cpuTimer.nsecsElapsed();
+    s.cpuend = s.cpubegin;
+
+    stack.append(frames[current].size());
+    frames[current].append(s);
+}
+
+void Profiler::end()
+{
+    if (!enabled || stack.isEmpty())
+        return;
+
+    Section &s = frames[current][stack.takeLast()];
+
+    s.cpuend = cpuTimer.nsecsElapsed();
+    if (s.end)
+        glQueryCounter(s.end, GL_TIMESTAMP);
+}
+
+void Profiler::collect(int frame)
+{
+    const QList<Section> &f = frames[frame];
+    if (f.isEmpty())
+        return;
+
+    // the first section (whole frame) ended last : if its result is
+    // available, the results of all the sections of the frame are
+    bool gpu = false;
+    if (f.first().end) {
+        GLint available = 0;
+        glGetQueryObjectiv(f.first().end, GL_QUERY_RESULT_AVAILABLE, &available);
+        gpu = available != 0;
+    }
+
+    QList<Timing> timings;
+    foreach (const Section &s, f) {
+        Timing t;
+        t.name = s.name;
+        t.depth = s.depth;
+        t.cpu = (double) (s.cpuend - s.cpubegin) / 1000000.0;
+        t.gpu = -1.0;
+        if (gpu && s.begin) {
+            GLuint64 b = 0, e = 0;
+            glGetQueryObjectui64v(s.begin, GL_QUERY_RESULT, &b);
+            glGetQueryObjectui64v(s.end, GL_QUERY_RESULT, &e);
+            t.gpu = (double) (e - b) / 1000000.0;
+        }
+        timings.append(t);
+    }
+
+    // average with the previous frames (in the order of the last frame)
+    QList<Timing> updated;
+    foreach (Timing t, timings) {
+        foreach (const Timing &a, averages) {
+            if (a.name == t.name && a.depth == t.depth) {
+                t.cpu = 0.9 * a.cpu + 0.1 * t.cpu;
+                if (a.gpu < 0.0)
+                    break;
+                t.gpu = t.gpu < 0.0 ? a.gpu : 0.9 * a.gpu + 0.1 * t.gpu;
+                break;
+            }
+        }
+        updated.append(t);
+    }
+    averages = updated;
+
+    // keep for export
+    history.append( qMakePair(frameNumbers[frame], timings) );
+    while (history.size() > PROFILER_HISTORY)
+        history.removeFirst();
+}
+
+bool Profiler::exportCsv(const QString &filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << filename << QChar(124).toLatin1() << QObject::tr("Cannot write profile.");
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "frame,depth,section,gpu_ms,cpu_ms\n";
+
+    for (int i = 0; i < history.size(); ++i) {
+        foreach (const Timing &t, history[i].second) {
+            QString name = t.name;
+            name.replace("\"", "\"\"");
+            out << history[i].first << "," << t.depth << ",\"" << name << "\","
+                << (t.gpu < 0.0 ? QString() : QString::number(t.gpu, 'f', 3)) << ","
+                << QString::number(t.cpu, 'f', 3) << "\n";
+        }
+    }
+
+    file.close();
+
+    qDebug() << filename << QChar(124).toLatin1() << QObject::tr("Profile of %1 frames exported.").arg(history.size());
+
+    return true;
+}
@@ -0,0 +1,122 @@
+/*
+ * Profiler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "common.h"
+
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QString>
+#include <QElapsedTimer>
+
+/**
+ * Number of frames kept for export
+ */
+#define PROFILER_HISTORY 600
+/**
+ * Maximum number of sections measured in a frame
+ */
+#define PROFILER_MAX_SECTIONS 256
+
+/**
+ * Profiler of the rendering.
+ *
+ * Sections of a frame (possibly nested) are delimited by begin() and end();
+ * the processor time is measured, and the time on the GPU with timestamp
+ * queries (GL_ARB_timer_query). The queries of a frame are read two frames
+ * later, and only if their results are available (never waits for the GPU).
+ *
+ * The averages of the last frames are displayed in the rendering widget,
+ * and the detail of the last frames can be exported to a CSV file.
+ */
+class Profiler {
+
+public:
+    static Profiler *getInstance();
+    static void deleteInstance();
+
+    // are timer queries available ?
+    static bool isSupported();
+
+    void setEnabled(bool on);
+    inline bool isEnabled() const { return enabled; }
+
+    // delimit a frame of the rendering
+    void beginFrame();
+    void endFrame();
+
+    // delimit a section of the current frame
+    void begin(const QString &name);
+    void end();
+
+    // times of a section, in milliseconds (negative if not measured)
+    typedef struct {
+        QString name;
+        int depth;
+        double gpu, cpu;
+    } Timing;
+
+    // averages of the sections measured in the last frames
+    inline QList<Timing> timings() const { return averages; }
+
+    // one line per section of the frames kept
+    bool exportCsv(const QString &filename) const;
+
+private:
+    Profiler();
+    ~Profiler();
+    static Profiler *_instance;
+
+    // read the queries of a frame
+    void collect(int frame);
+
+    typedef struct {
+        QString name;
+        int depth;
+        GLuint begin, end;
+        qint64 cpubegin, cpuend;
+    } Section;
+
+    bool enabled;
+    unsigned int frameNumber;
+    QElapsedTimer cpuTimer;
+
+    // two frames in flight, with their pools of queries
+    QList<Section> frames[2];
+    unsigned int frameNumbers[2];
+    QVector<GLuint> queries[2];
+    int queryCount[2];
+    int current;
+    QList<int> stack;
+
+    QList<Timing> averages;
+    QList< QPair<unsigned int, QList<Timing> > > history;
+};
+
+#endif // PROFILER_H
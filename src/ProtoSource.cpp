@@ -34,7 +34,7 @@ ProtoSource::ProtoSource(QObject *parent) : QObject(parent),
     gamma(1.0), gammaRed(1.0), gammaGreen(1.0), gammaBlue(1.0),
     gammaMinIn(0.0), gammaMaxIn(1.0), gammaMinOut(0.0), gammaMaxOut(1.0),
     hueShift(0.0), chromaKeyTolerance(0.1), luminanceThreshold(0), lumakeyThreshold(0), numberOfColors (0),
-    useChromaKey(false)
+    useChromaKey(false), shaderAttributesChanged(true), colorOperationsChanged(true)
 {
     // default name
     name = QString("Source");
@@ -179,6 +179,7 @@ void ProtoSource::_setAlpha(double a) {
     double da = sqrt((1.0 - texalpha) * (SOURCE_UNIT * SOURCE_UNIT * CIRCLE_SIZE * CIRCLE_SIZE));
     alphax = sin(alphaangle) * da;
     alphay = cos(alphaangle) * da;
+    shaderAttributesChanged = true;
 }
 
 
@@ -194,78 +195,105 @@ void ProtoSource::_setMask(int maskType) {
 
 void ProtoSource::_setColor(QColor c){
     texcolor = c;
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setColor(int r, int g, int b){
     texcolor = QColor(r,g,b);
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setBrightness(int b) {
     brightness  = double(b) / 100.0;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setBrightness(double b) {
     brightness  = CLAMP((b *2.0) - 1.0, -1.0, 1.0);;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setContrast(int c) {
     contrast  = double(c + 100) / 100.0;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setContrast(double c) {
     contrast  = CLAMP(c * 2.0, 0.0, 2.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setSaturation(int s){
     saturation  = double(s + 100) / 100.0;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setSaturation(double s){
     saturation  = CLAMP(s * 2.0, 0.0, 2.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setHueShift(int h){
     hueShift = CLAMP(double(h) / 360.0, 0.0, 1.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setHueShift(double h){
     hueShift = CLAMP(h, 0.0, 1.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setThreshold(int l){
     luminanceThreshold = CLAMP(l, 0, 100);
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setThreshold(double l){
     luminanceThreshold = CLAMP( (int) (l * 100.0), 0, 100);
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setLumakey(int l){
     lumakeyThreshold = CLAMP(l, 0, 100);
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setLumakey(double l){
     lumakeyThreshold = CLAMP( (int) (l * 100.0), 0, 100);
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setPosterized(int n){
     numberOfColors = CLAMP(n, 0, 256);
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setChromaKey(bool on) {
     useChromaKey = on;
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setChromaKeyColor(QColor c) {
     chromaKeyColor = c;
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setChromaKeyColor(int r, int g, int b){
     chromaKeyColor = QColor(r, g, b);
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setChromaKeyTolerance(int t) {
     chromaKeyTolerance = CLAMP( double(t) / 100.0, 0.0, 1.0);
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setGammaColor(double v, double r, double g, double b){
@@ -278,6 +306,8 @@ void ProtoSource::_setGammaColor(double v, double r, double g, double b){
         gammaGreen = CLAMP(g, 0.01, 50.0);
     if (b < std::numeric_limits<double>::max())
         gammaBlue = CLAMP(b, 0.01, 50.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 // non-liniear conversion of control values from 0.0 to 1.0
@@ -286,18 +316,26 @@ void ProtoSource::_setGammaColor(double v, double r, double g, double b){
 
 void ProtoSource::_setGammaValue(double v){
     gamma = CLAMP( exp(v * v * 3.2) - 0.96, 0.03, 23.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setGammaRed(double v){
     gammaRed = CLAMP( exp(v * v * 3.2) - 0.96, 0.03, 23.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setGammaGreen(double v){
     gammaGreen = CLAMP( exp(v * v* 3.2) - 0.96, 0.03, 23.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setGammaBlue(double v){
     gammaBlue = CLAMP( exp(v * v* 3.2) - 0.96, 0.03, 23.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setGammaLevels(double minI, double maxI, double minO, double maxO){
@@ -310,6 +348,8 @@ void ProtoSource::_setGammaLevels(double minI, double maxI, double minO, double
         gammaMinOut = CLAMP(minO, 0.0, 1.0);
     if (maxO < std::numeric_limits<double>::max())
         gammaMaxOut = CLAMP(maxO, 0.0, 1.0);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setPixelated(bool on) {
@@ -324,30 +364,43 @@ void ProtoSource::_setBlending(uint sfactor, uint dfactor, uint eq) {
 
 void ProtoSource::_setInvertMode(invertModeType i) {
     invertMode = i;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setInvertColor(bool i) {
     invertMode = i ? INVERT_COLOR : INVERT_NONE;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setInvertColor(double i) {
     invertMode = i > 0.5 ? INVERT_COLOR : INVERT_NONE;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setInvertLuminance(bool i){
     invertMode = i ? INVERT_LUMINANCE : INVERT_NONE;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setInvertLuminance(double i){
     invertMode = i > 0.5 ? INVERT_LUMINANCE : INVERT_NONE;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setFilter(filterType c) {
     filter = c;
+    shaderAttributesChanged = true;
 }
 
 void ProtoSource::_setInvertMode(int i) {
     invertMode = (invertModeType) CLAMP( i, INVERT_NONE, INVERT_LUMINANCE);
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 }
 
 void ProtoSource::_setInvertMode(double i) {
@@ -356,6 +409,7 @@ void ProtoSource::_setInvertMode(double i) {
 
 void ProtoSource::_setFilter(int c) {
     filter = (filterType) CLAMP( c, FILTER_NONE, FILTER_CUSTOM_GLSL);
+    shaderAttributesChanged = true;
 }
 
 
@@ -387,6 +441,8 @@ void ProtoSource::importProperties(const ProtoSource *source, bool withGeometry)
     chromaKeyColor = source->chromaKeyColor;
     useChromaKey = source->useChromaKey;
     chromaKeyTolerance = source->chromaKeyTolerance;
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
 
     if (withGeometry) {
         x = source->x;
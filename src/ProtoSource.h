@@ -241,7 +241,7 @@ public:
 
 
     // import all the properties of a source
-    void importProperties(const ProtoSource *s, bool withGeometry = true);
+    virtual void importProperties(const ProtoSource *s, bool withGeometry = true);
 
     // get XML config
     QDomElement getConfiguration(QDomDocument &doc);
@@ -357,6 +357,10 @@ protected:
     int luminanceThreshold, lumakeyThreshold, numberOfColors;
     QColor chromaKeyColor;
     bool useChromaKey;
+    // set when a property used by the shader is modified
+    mutable bool shaderAttributesChanged;
+    // set when a property baked in the color table is modified
+    mutable bool colorOperationsChanged;
 };
 
 
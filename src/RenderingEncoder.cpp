@@ -26,10 +26,13 @@
 #include "RenderingEncoder.moc"
 
 #include "common.h"
+#include "ReplayBuffer.h"
+#include "CodecManager.h"
 #include "defines.h"
 #include "RenderingManager.h"
 #include "ViewRenderWidget.h"
 #include "glmixer.h"
+#include "Tracer.h"
 
 #include <QSize>
 #include <QBuffer>
@@ -37,17 +40,18 @@
 #include <QMessageBox>
 #include <QGLFramebufferObject>
 #include <QThread>
+#include <QSettings>
 
 
-EncodingThread::EncodingThread() : QThread(), recorder(NULL), _quit(true), time(0),
+EncodingThread::EncodingThread() : QThread(), recorder(NULL), _quit(true),
     pictq_max_count(0), pictq_size_count(0), pictq_rindex(0), pictq_windex(0),
-    frameq(NULL), framewidth(0), frameheight(0) //, recordingTimeStamp(0)
+    frameq(NULL), skipcount(0), encodecount(0)
 {
+    setObjectName("EncodingThread");
+
     // create mutex
     pictq_mutex = new QMutex;
     Q_CHECK_PTR(pictq_mutex);
-    pictq_cond = new QWaitCondition;
-    Q_CHECK_PTR(pictq_cond);
 }
 
 EncodingThread::~EncodingThread()
@@ -55,13 +59,11 @@ EncodingThread::~EncodingThread()
     clear();
 
     delete pictq_mutex;
-    delete pictq_cond;
 
   //  qDebug() << "EncodingThread" << QChar(124).toLatin1() << tr("Done.");
 }
 
-void EncodingThread::initialize(VideoRecorder *rec, int width, int height, unsigned long bufSize)
-
+void EncodingThread::initialize(VideoRecorder *rec, int maxcount)
 {
     // clear buffer in case its a re-initialization
     clear();
@@ -69,19 +71,19 @@ void EncodingThread::initialize(VideoRecorder *rec, int width, int height, unsig
     // set recorder
     recorder = rec;
 
-    // set frames
-    framewidth = width;
-    frameheight = height;
-
-    // compute buffer count from size of buffer over the size of RGB images
-    // store buffer count as maximum buffer size
-    pictq_max_count = (int) ( (long double) bufSize / (long double) (width * height * 3) );
+    // store maximum number of frames waiting in the queue
+    pictq_max_count = qMax(2, maxcount);
 
     // init variables
     pictq_size_count = pictq_rindex = pictq_windex = 0;
+    skipcount = encodecount = 0;
+    _quit = false;
 
-    // allocate & initialize array to zero
+    // allocate array of frames
+    // (frames only reference the buffers given to pushFrame)
     frameq = (AVFrame **) calloc( pictq_max_count, sizeof(AVFrame *) );
+    for (int i = 0; i < pictq_max_count; ++i)
+        frameq[i] = av_frame_alloc();
 }
 
 void EncodingThread::clear() {
@@ -92,9 +94,10 @@ void EncodingThread::clear() {
         // free buffer
         for (int i = 0; i < pictq_max_count; ++i) {
             if (frameq[i]) {
+                if (frameq[i]->buf[0])
+                    freedmemory++;
                 av_frame_unref(frameq[i]);
                 av_frame_free(&frameq[i]);
-                freedmemory++;
             }
 
         }
@@ -106,7 +109,6 @@ void EncodingThread::clear() {
     }
 
     recorder = NULL;
-    time = 0;
 }
 
 void EncodingThread::stop() {
@@ -116,10 +118,25 @@ void EncodingThread::stop() {
 
 }
 
-void EncodingThread::releaseAndPushFrame(int elapsedtime)
+bool EncodingThread::pushFrame(AVFrame *frame, int64_t pts)
 {
-    // store time
-    time = elapsedtime;
+    TRACE_SCOPE("pushFrame");
+    QMutexLocker locker(pictq_mutex);
+
+    // SKIP if the queue is full : never wait for the encoder
+    if ( !frameq || _quit || frameq_full() ) {
+        skipcount++;
+        return false;
+    }
+
+    // reference the frame buffer (no copy)
+    if ( av_frame_ref(frameq[pictq_windex], frame) < 0 ) {
+        skipcount++;
+        return false;
+    }
+
+    // set presentation time stamp (frame number if not given)
+    frameq[pictq_windex]->pts = pts;
 
     // set to write index to next in queue
     if (++pictq_windex == pictq_max_count)
@@ -127,34 +144,8 @@ void EncodingThread::releaseAndPushFrame(int elapsedtime)
 
     /* now we inform our encoding thread that we have a picture ready */
     pictq_size_count++;
-    pictq_mutex->unlock();
-
-}
-
-AVBufferRef *EncodingThread::lockFrameAndGetBuffer()
-{
-    // wait until we have space for a new picture
-    // (this happens only when the queue is full)
-    pictq_mutex->lock();
-    while ( frameq_full() && !_quit)
-        pictq_cond->wait(pictq_mutex); // the condition is released in run()
-
-    // allocate frame if not already done
-    if (frameq[pictq_windex] == 0) {
 
-        // allocate and setup frame
-        frameq[pictq_windex] = av_frame_alloc();
-        frameq[pictq_windex]->format = AV_PIX_FMT_RGB24;
-        frameq[pictq_windex]->width  = framewidth;
-        frameq[pictq_windex]->height = frameheight;
-
-        // allocate buffer
-        av_frame_get_buffer(frameq[pictq_windex], 24);
-        av_frame_make_writable(frameq[pictq_windex]);
-    }
-
-    // return ref to buffer of frame
-    return av_frame_get_plane_buffer(frameq[pictq_windex], 0);
+    return true;
 }
 
 bool EncodingThread::frameq_full() {
@@ -168,7 +159,6 @@ void EncodingThread::run() {
         return;
 
     // prepare
-    _quit = false;
     int pictq_usage = 0, picq_size_usage = 0;
     double wait_duration =  400.0 / (double) recorder->getFrameRate(); // 40% of fps
 
@@ -184,27 +174,30 @@ void EncodingThread::run() {
         } else {
 
             try {
+                TRACE_SCOPE("encode frame");
                 // add a frame
                 if ( !recorder->addFrame(frameq[pictq_rindex]) )
                     break;
+                encodecount++;
             }
             catch (VideoRecorderException &e){
                 qWarning() << "EncodingThread" << QChar(124).toLatin1() << e.message();
                 break;
             }
 
+            // release the reference to the frame buffer
+            av_frame_unref(frameq[pictq_rindex]);
+
             /* update queue for next picture at the read index */
             if (++pictq_rindex == pictq_max_count)
                 pictq_rindex = 0;
 
-            pictq_mutex->lock();
+            TRACE_WAIT("wait pictq_mutex", pictq_mutex->lock());
             // remember usage
             pictq_usage = MAXI(pictq_usage, pictq_rindex + 1);
             picq_size_usage = MAXI(picq_size_usage, pictq_size_count + 1);
             // decrease the number of frames in the queue
             pictq_size_count--;
-            // tell main process that it can go on (in case it was waiting on a full queue)
-            pictq_cond->wakeAll();
             pictq_mutex->unlock();
 
         }
@@ -255,6 +248,24 @@ RenderingEncoder::RenderingEncoder(QObject * parent): QObject(parent), started(f
     // encoder & recorder not created yet
     encoder = NULL;
     recorder = NULL;
+    record_frame = false;
+    // frames buffer pool created on first frame
+    framePool = NULL;
+    pool_width = 0;
+    pool_height = 0;
+    // instant replay not active
+    replayEncoder = NULL;
+    replayRecorder = NULL;
+    replayBuffer = NULL;
+    replay_duration = DEFAULT_REPLAY_DURATION;
+    replay_pts = -1;
+    replay_frame = false;
+    // network streaming not active
+    streamEncoder = NULL;
+    streaming_url = DEFAULT_STREAMING_URL;
+    streaming_latency = DEFAULT_STREAMING_LATENCY;
+    stream_pts = -1;
+    stream_frame = false;
 }
 
 RenderingEncoder::~RenderingEncoder() {
@@ -262,6 +273,20 @@ RenderingEncoder::~RenderingEncoder() {
     if (encoder)
         delete encoder;
 
+    // stop instant replay & streaming
+    setReplayActive(false);
+    setStreamingActive(false);
+
+    // stop calibration
+    if (benchmark) {
+        benchmark->stop();
+        benchmark->wait();
+    }
+
+    // free frames buffer pool
+    // (buffers still in use are freed when released)
+    av_buffer_pool_uninit(&framePool);
+
     qDebug() << "RenderingEncoder" << QChar(124).toLatin1() << "All clear.";
 }
 
@@ -284,6 +309,33 @@ void RenderingEncoder::setEncodingQuality(encodingquality q) {
 }
 
 
+void RenderingEncoder::addOutput(encodingformat f, encodingquality q, int scale)
+{
+    if (started) {
+        qCritical() << tr ("Cannot change video recording outputs; Recorder is busy.");
+        return;
+    }
+
+    if (outputList.size() >= MAX_RECORDING_OUTPUTS) {
+        qWarning() << "RenderingEncoder" << QChar(124).toLatin1() << tr("Cannot have more than %1 additional outputs.").arg(MAX_RECORDING_OUTPUTS);
+        return;
+    }
+
+    RecordingOutput o;
+    o.format = f;
+    o.quality = q;
+    o.scale = CLAMP(scale, 10, 100);
+    outputList.append(o);
+}
+
+void RenderingEncoder::clearOutputs()
+{
+    if (!started)
+        outputList.clear();
+    else
+        qCritical() << tr ("Cannot change video recording outputs; Recorder is busy.");
+}
+
 void RenderingEncoder::setActive(bool on)
 {
     if (on) {
@@ -315,8 +367,10 @@ void RenderingEncoder::setActive(bool on)
     else {
         // deactivate if previously started
         if (started) {
-            // request stop to encoder
+            // request stop to encoders
             encoder->stop();
+            foreach (EncodingThread *e, outputEncoders)
+                e->stop();
             // stop recording
             started = false;
             // inform GUI the encoder is still processing
@@ -405,6 +459,48 @@ bool RenderingEncoder::start(){
          recording_fps = qBound(1, (int) ( 1000.0 / double(encoding_frame_interval) ), 60);
     }
 
+    // check that the encoder is fast enough on this computer
+    encodingformat recording_format = format;
+    double measured_fps = encoderFramerate(format);
+    if ( measured_fps > 0.0 && measured_fps < BENCHMARK_REALTIME_FACTOR * recording_fps ) {
+
+        // find the first format which can follow
+        int alternative = -1;
+        for (int f = FORMAT_MP4_H264; f <= FORMAT_AVI_RAW && alternative < 0; ++f) {
+            if ( encoderFramerate((encodingformat) f) >= BENCHMARK_REALTIME_FACTOR * recording_fps )
+                alternative = f;
+        }
+
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Warning);
+        msgBox.setText(tr("The encoder is too slow for recording at %1 fps.").arg(recording_fps));
+        msgBox.setInformativeText(tr("%1 was measured at %2 fps on this computer for the current rendering resolution.").arg(performance[format].description).arg(qRound(measured_fps)));
+        msgBox.setDetailedText( tr("Many frames would be lost and the playback of the movie would be jerky.\n\n"
+                                   "You can either record with a faster format, or adjust your preference with :\n"
+                                   "- another recording format\n"
+                                   "- a lower recording quality\n"
+                                   "- a lower recording frame rate\n"
+                                   "- a lower rendering resolution\n") );
+
+        QPushButton *alternativeButton = NULL;
+        if (alternative > -1)
+            alternativeButton = msgBox.addButton(tr("Record %1").arg(performance[alternative].description), QMessageBox::AcceptRole);
+        QPushButton *abortButton = msgBox.addButton(QMessageBox::Discard);
+        msgBox.addButton(tr("Record anyway"), QMessageBox::AcceptRole);
+        msgBox.exec();
+        if (msgBox.clickedButton() == abortButton) {
+            errormessage = "Recording aborted by user.";
+            return false;
+        }
+        // downgrade to the alternative format (only for this recording)
+        if (alternativeButton && msgBox.clickedButton() == alternativeButton)
+            recording_format = (encodingformat) alternative;
+    }
+
+    // do not compete with the calibration
+    if (benchmark)
+        benchmark->stop();
+
     // search for an update interval that has those properties:
     // * is higher than the current display update interval
     // * is a multiple of the encoding interval
@@ -445,7 +541,7 @@ bool RenderingEncoder::start(){
     QSize framesSize = RenderingManager::getInstance()->getFrameBufferResolution();
     try {
         // allocate recorder
-        recorder = VideoRecorder::getRecorder(format, filename, framesSize.width(), framesSize.height(), recording_fps, quality);
+        recorder = VideoRecorder::getRecorder(recording_format, filename, framesSize.width(), framesSize.height(), recording_fps, quality);
         // open recorder
         recorder->open();
     }
@@ -455,11 +551,49 @@ bool RenderingEncoder::start(){
         return false;
     }
 
+    // compute buffer count from size of buffer over the size of RGB images
+    int maxcount = (int) ( (long double) bufferSize / (long double) (framesSize.width() * framesSize.height() * 3) );
+
     // initialize encoder
-    encoder->initialize(recorder, framesSize.width(), framesSize.height(), bufferSize);
+    encoder->initialize(recorder, maxcount);
     // start the encoding thread
     encoder->start();
 
+    // additional outputs, encoded from the same frames
+    // NB: frames are shared by the encoders, so the buffer size
+    // remains the one of the main recording.
+    for (int i = 0; i < outputList.size(); ++i) {
+
+        // dimensions multiple of 2 (required for yuv420p)
+        int w = ( (framesSize.width() * outputList[i].scale) / 200 ) * 2;
+        int h = ( (framesSize.height() * outputList[i].scale) / 200 ) * 2;
+        QString outputfilename = QString("%1%2").arg(filename).arg(i);
+
+        if (temporaryFolder.exists(outputfilename))
+            temporaryFolder.remove(outputfilename);
+
+        VideoRecorder *rec = NULL;
+        try {
+            rec = VideoRecorder::getRecorder(outputList[i].format, outputfilename, w, h, recording_fps, outputList[i].quality);
+            rec->open();
+        }
+        catch (VideoRecorderException &e){
+            // an additional output failing does not stop the recording
+            qWarning() << outputfilename << QChar(124).toLatin1() << tr("Additional output ignored. %1").arg(e.message());
+            if (rec)
+                delete rec;
+            continue;
+        }
+
+        EncodingThread *e = new EncodingThread();
+        Q_CHECK_PTR(e);
+        e->initialize(rec, maxcount);
+        e->start();
+        outputEncoders.append(e);
+
+        qDebug() << outputfilename << QChar(124).toLatin1()  << tr("Additional output (%1 at %2 x %3).").arg(rec->getFileSuffix()).arg(w).arg(h);
+    }
+
     // start the timers
     encoding_duration = 0;
     elapsed_duration = 0;
@@ -468,89 +602,232 @@ bool RenderingEncoder::start(){
     return true;
 }
 
+int RenderingEncoder::encoderQueueCount()
+{
+    return (started && encoder) ? encoder->getFrameQueueCount() : 0;
+}
+
+int RenderingEncoder::encoderQueueSize()
+{
+    return (started && encoder) ? encoder->getFrameQueueSize() : 0;
+}
+
+int RenderingEncoder::encodedFrameCount()
+{
+    return (started && encoder) ? encoder->getEncodedFrameCount() : 0;
+}
+
+int RenderingEncoder::skippedFrameCount()
+{
+    return (started && encoder) ? encoder->getSkippedFrameCount() : 0;
+}
+
 bool RenderingEncoder::acceptFrame()
 {
+    record_frame = false;
+    replay_frame = false;
+    stream_frame = false;
+
     // is the encoder at work?
     if (started && !paused) {
 
-        // SKIP if the recorder cannot follow
-        if ( encoder && encoder->frameq_full() ) {
+        // SKIP if none of the recorders can follow
+        // (each recorder skips the frames it cannot follow)
+        bool full = ( encoder == NULL || encoder->frameq_full() );
+        foreach (EncodingThread *e, outputEncoders)
+            full = full && e->frameq_full();
+
+        if ( full ) {
             // remember amount of skipped frames
             skipframecount++;
-            return false;
         }
+        else {
+            // elapsed time of recording
+            elapsed_duration += elapsed_timer.restart();
+
+            // if time since last encoded frame (encoding duration)
+            // is above the required frame interval, we shall add a frame !
+            if ( elapsed_duration - encoding_duration > encoding_frame_interval)
+                // accept the frame
+                record_frame = true;
+
+            // else SKIP if the time since last encoded frame is less than encoding interval.
+            // NB: this is expected because the recording_update_interval is a
+            // multiple of encoding_frame_interval;
+            // skipping some frames allows recoring at lower frame rate.
+        }
+    }
+
+    // is the instant replay at work?
+    if (replayEncoder) {
 
-        // elapsed time of recording
-        elapsed_duration += elapsed_timer.restart();
+        // SKIP if the replay encoder cannot follow
+        // NB: frames are rescaled by the recorder if the frame buffer was resized
+        if ( !replayEncoder->frameq_full() ) {
 
-        // if time since last encoded frame (encoding duration)
-        // is above the required frame interval, we shall add a frame !
-        if ( elapsed_duration - encoding_duration > encoding_frame_interval)
-            // accept the frame
-            return true;
+            // time stamp of the frame in the replay, in number of frames
+            // NB: the rendering is not slowed down for instant replay; missing
+            // frames are simply skipped in the time line of the replay
+            int64_t pts = ( (int64_t) replay_timer.elapsed() * replayRecorder->getFrameRate() ) / 1000;
 
-        // else SKIP if the time since last encoded frame is less than encoding interval.
-        // NB: this is expected because the recording_update_interval is a
-        // multiple of encoding_frame_interval;
-        // skipping some frames allows recoring at lower frame rate.
+            // accept the frame if its time stamp comes after the previous one
+            if ( pts > replay_pts ) {
+                replay_pts = pts;
+                replay_frame = true;
+            }
+        }
     }
 
-    return false;
-}
+    // is the network streaming at work?
+    if (streamEncoder) {
 
+        // SKIP if the streaming encoder cannot follow : the queue is
+        // short enough to never delay the stream more than the latency
+        if ( !streamEncoder->frameq_full() ) {
 
-// Add a frame to the stream
-// This function is called with the rendering context active
-// by the update method in the ViewRenderWidget
-// it *should* be called at the desired frame rate
-void RenderingEncoder::addFrame(uint8_t *data){
+            // time stamp of the frame in the stream, in number of frames
+            int64_t pts = ( (int64_t) stream_timer.elapsed() * streamEncoder->getRecorder()->getFrameRate() ) / 1000;
 
-    // just to be sure
-    if (!started || encoder == NULL)
-        return;
+            // accept the frame if its time stamp comes after the previous one
+            if ( pts > stream_pts ) {
+                stream_pts = pts;
+                stream_frame = true;
+            }
+        }
+    }
 
-    // lock access to frame and get buffer
-    // (get the pointer to the current writing buffer from the queue of the thread to know where to write)
-    AVBufferRef *buf = encoder->lockFrameAndGetBuffer();
-    if (!buf) {
-        // failed
-        skipframecount++;
-        return;
+    return record_frame || replay_frame || stream_frame;
+}
+
+// Create a frame with the pixels of the rendering
+// The buffer is taken from a pool so that frames are allocated only once,
+// and it is shared (reference counted) by all the encoders.
+AVFrame *RenderingEncoder::createFrame(uint8_t *data)
+{
+    QSize framesSize = RenderingManager::getInstance()->getFrameBufferResolution();
+    int size = framesSize.width() * framesSize.height() * 3;
+
+    // (re)create the pool of buffers if the frame buffer was resized
+    // (buffers of the previous pool are freed when released by the encoders)
+    if ( !framePool || framesSize.width() != pool_width || framesSize.height() != pool_height ) {
+        av_buffer_pool_uninit(&framePool);
+        framePool = av_buffer_pool_init(size, NULL);
+        pool_width = framesSize.width();
+        pool_height = framesSize.height();
+    }
+
+    AVFrame *frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
+
+    // get a buffer from the pool
+    frame->buf[0] = av_buffer_pool_get(framePool);
+    if (!frame->buf[0]) {
+        av_frame_free(&frame);
+        return NULL;
     }
 
+    // setup RGB frame on the buffer
+    frame->format = AV_PIX_FMT_RGB24;
+    frame->width  = pool_width;
+    frame->height = pool_height;
+    frame->data[0] = frame->buf[0]->data;
+    frame->linesize[0] = pool_width * 3;
+
     if (data)
-        // read the pixels from the given buffer and store into the temporary buffer queue
-        memmove( buf->data, data, qMin( buf->size, encoder->getFrameWidth() * encoder->getFrameHeight() * 3) );
+        // read the pixels from the given buffer
+        memmove( frame->data[0], data, size );
     else {
         // read the pixels from the texture
         if (RenderingManager::useGetTextureExtension())
-            glGetTextureSubImage( RenderingManager::getInstance()->getFrameBufferTexture(), 0, 0, 0, 0, encoder->getFrameWidth(), encoder->getFrameHeight(), 1, GL_RGB, GL_UNSIGNED_BYTE, buf->size, buf->data);
+            glGetTextureSubImage( RenderingManager::getInstance()->getFrameBufferTexture(), 0, 0, 0, 0, pool_width, pool_height, 1, GL_RGB, GL_UNSIGNED_BYTE, size, frame->data[0]);
         else {
             glBindTexture(GL_TEXTURE_2D, RenderingManager::getInstance()->getFrameBufferTexture());
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, buf->data);
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, frame->data[0]);
         }
     }
 
-    // record time
-    encoding_duration += encoding_frame_interval;
+    return frame;
+}
+
+
+// Add a frame to the stream
+// This function is called with the rendering context active
+// by the update method in the ViewRenderWidget
+// it *should* be called at the desired frame rate
+void RenderingEncoder::addFrame(uint8_t *data){
+
+    // nothing to do
+    if ( !(record_frame && started && encoder != NULL) && !(replay_frame && replayEncoder != NULL)
+         && !(stream_frame && streamEncoder != NULL) )
+        return;
+
+    // read the pixels once for all encoders
+    AVFrame *frame = createFrame(data);
+
+    // add frame to the recording
+    if (record_frame && started && encoder != NULL) {
+
+        if ( frame ) {
+
+            // time stamp of the frame in the recording, in number of frames
+            // (the same for all outputs, which stay in sync when one skips a frame)
+            int64_t pts = (int64_t) (encoding_duration / encoding_frame_interval);
+
+            // record time
+            encoding_duration += encoding_frame_interval;
+
+            // give the frame to every encoder
+            // (each encoder skips the frame if it cannot follow)
+            encoder->pushFrame(frame, pts);
+            foreach (EncodingThread *e, outputEncoders)
+                e->pushFrame(frame, pts);
 
-    // inform the thread that a picture was pushed into the queue
-    encoder->releaseAndPushFrame( encoding_duration );
+        //    // BHBN : DEBUG  : for tests recording 10s
+        //    if (encoding_duration > 10000)
+        //        setActive(false);
 
-//    // BHBN : DEBUG  : for tests recording 10s
-//    if (encoding_duration > 10000)
-//        setActive(false);
+            // display record time
+            emit timing( getStringFromTime( (double) encoding_duration / 1000.0) );
 
-    // display record time
-    emit timing( getStringFromTime( (double) encoding_duration / 1000.0) );
+            // display disk writing status every second
+            if ( encoding_duration % 1000 < encoding_frame_interval ) {
+                QString writerstatus = recorder->getWriterStatus();
+                if (!writerstatus.isEmpty())
+                    emit status(tr("Recording.. %1").arg(writerstatus), 1000);
+            }
+        }
+        else
+            // failed
+            skipframecount++;
+    }
+
+    // add frame to the instant replay
+    if (replay_frame && replayEncoder != NULL && frame)
+        replayEncoder->pushFrame(frame, replay_pts);
+
+    // add frame to the network stream
+    if (stream_frame && streamEncoder != NULL && frame)
+        streamEncoder->pushFrame(frame, stream_pts);
+
+    // release our reference to the frame
+    av_frame_free(&frame);
+
+    record_frame = false;
+    replay_frame = false;
+    stream_frame = false;
 }
 
 void RenderingEncoder::kill(){
     // deactivate if previously started
     if (started) {
-        // request stop to encoder
+        // request stop to encoders
         encoder->terminate();
         encoder->wait(1000);
+        foreach (EncodingThread *e, outputEncoders) {
+            e->terminate();
+            e->wait(1000);
+        }
     }
 }
 
@@ -565,6 +842,10 @@ void RenderingEncoder::close(bool success){
     QString description_file = recorder->getFileDescription();
     QString duration = getStringFromTime( (double) encoding_duration / 1000.0 );
 
+    // frames skipped by the encoder of the main recording
+    if (encoder)
+        skipframecount += encoder->getSkippedFrameCount();
+
     // stop recorder
     try {
         framecount = recorder->close();
@@ -574,6 +855,31 @@ void RenderingEncoder::close(bool success){
         success = false;
     }
 
+    // stop additional outputs
+    // (keep the temporary files of the ones properly closed)
+    QStringList outputFiles, outputNames;
+    while (!outputEncoders.isEmpty()) {
+        EncodingThread *e = outputEncoders.takeFirst();
+        e->stop();
+        e->wait();
+
+        VideoRecorder *rec = e->getRecorder();
+        QFileInfo info(rec->getFilename());
+        try {
+            int count = rec->close();
+            outputFiles << info.fileName();
+            outputNames << QString("_%1x%2.%3").arg(rec->getWidth()).arg(rec->getHeight()).arg(rec->getFileSuffix());
+            qDebug() << rec->getFilename() << QChar(124).toLatin1() << tr("Additional output finished (%1 frames, %2 skipped).").arg(count).arg(e->getSkippedFrameCount());
+        }
+        catch (VideoRecorderException &ex){
+            qWarning() << rec->getFilename() << QChar(124).toLatin1() << tr("Error closing additional output. %1").arg(ex.message());
+            temporaryFolder.remove(info.fileName());
+        }
+
+        delete rec;
+        delete e;
+    }
+
     // inform we are off
     started = false;
     emit selectAspectRatio(ASPECT_RATIO_ANY);
@@ -625,21 +931,35 @@ void RenderingEncoder::close(bool success){
         }
 
         // save file
+        QString destination;
         if (savefile) {
             if (automaticSaving)
-                saveFile(suffix_file);
+                destination = saveFile(suffix_file);
             else
-                saveFileAs(suffix_file, description_file);
+                destination = saveFileAs(suffix_file, description_file);
         }
         else
             qDebug() << tr("Recording not saved.");
 
+        // save additional outputs next to the recording
+        // e.g. 'myvideo.mp4' and 'myvideo_640x360.mp4'
+        if (!destination.isEmpty()) {
+            QFileInfo info(destination);
+            for (int i = 0; i < outputFiles.size(); ++i)
+                moveTemporaryFile(outputFiles[i], info.dir().absoluteFilePath(info.completeBaseName() + outputNames[i]));
+            outputFiles.clear();
+        }
+
     }
     else {
         // Log
         qCritical() << "RenderingEncoder" << QChar(124).toLatin1() << tr("Recording failed. %1").arg(errormessage);
     }
 
+    // remove temporary files of additional outputs not saved
+    foreach (QString f, outputFiles)
+        temporaryFolder.remove(f);
+
 }
 
 
@@ -669,47 +989,360 @@ void RenderingEncoder::setAutomaticSavingFolder(QString d) {
     setAutomaticSavingMode(automaticSaving);
 }
 
-void RenderingEncoder::saveFile(QString suffix, QString filename){
+bool RenderingEncoder::moveTemporaryFile(QString temporary, QString destination){
 
-    if (filename.isNull())
-        filename = QString("glmixervideo%1%2").arg(QDate::currentDate().toString("yyMMdd")).arg(QTime::currentTime().toString("hhmmss")) + '.' + suffix;
-
-    QFileInfo infoFileDestination(savingFolder, filename);
+    QFileInfo infoFileDestination(destination);
 
     // delete file if exists
     if (infoFileDestination.exists()){
         infoFileDestination.dir().remove(infoFileDestination.fileName());
     }
 
-    // move the temporaryFileName to newFileName
-    if (!temporaryFolder.rename(temporaryFileName, infoFileDestination.fileName()) )
+    // move the temporary file to destination
+    if (!temporaryFolder.rename(temporary, infoFileDestination.absoluteFilePath()) ) {
         qWarning() << infoFileDestination.absoluteFilePath() << QChar(124).toLatin1() << tr("Could not save file (file exists already?).");
-    else {
-        emit status(tr("File %1 saved.").arg(infoFileDestination.absoluteFilePath()), 2000);
-        qDebug() << infoFileDestination.absoluteFilePath() << QChar(124).toLatin1() << tr("File saved.");
+        return false;
     }
+
+    qDebug() << infoFileDestination.absoluteFilePath() << QChar(124).toLatin1() << tr("File saved.");
+    return true;
+}
+
+QString RenderingEncoder::saveFile(QString suffix, QString filename){
+
+    if (filename.isNull())
+        filename = QString("glmixervideo%1%2").arg(QDate::currentDate().toString("yyMMdd")).arg(QTime::currentTime().toString("hhmmss")) + '.' + suffix;
+
+    QFileInfo infoFileDestination(savingFolder, filename);
+
+    // move the temporaryFileName to newFileName
+    if (!moveTemporaryFile(temporaryFileName, infoFileDestination.absoluteFilePath()))
+        return QString::null;
+
+    emit status(tr("File %1 saved.").arg(infoFileDestination.absoluteFilePath()), 2000);
+    return infoFileDestination.absoluteFilePath();
 }
 
-void RenderingEncoder::saveFileAs(QString suffix, QString description){
+QString RenderingEncoder::saveFileAs(QString suffix, QString description){
 
     QString suggestion = QString("glmixervideo%1%2").arg(QDate::currentDate().toString("yyMMdd")).arg(QTime::currentTime().toString("hhmmss"));
 
     QString newFileName = GLMixer::getInstance()->getFileName(tr("Save recorded video"),
                                                               description, suffix, suggestion);
     // if we got a filename, save the file:
-    if (!newFileName.isEmpty()) {
+    if (newFileName.isEmpty() || !moveTemporaryFile(temporaryFileName, newFileName))
+        return QString::null;
+
+    emit status(tr("File %1 saved.").arg(newFileName), 2000);
+    return newFileName;
+}
+
+void RenderingEncoder::setReplayDuration(int seconds)
+{
+    replay_duration = CLAMP(seconds, MIN_REPLAY_DURATION, MAX_REPLAY_DURATION);
+
+    // apply to current instant replay
+    if (replayBuffer)
+        replayBuffer->setDuration(replay_duration);
+}
+
+// Start or stop the instant replay
+// - Create a fast encoder keeping its packets in memory
+// - Encode continuously in a separate thread
+void RenderingEncoder::setReplayActive(bool on)
+{
+    if (on) {
+        // activate if not already active
+        if (!replayEncoder) {
+
+            QSize framesSize = RenderingManager::getInstance()->getFrameBufferResolution();
+            int replay_fps = qBound(1, (int) ( 1000.0 / double(encoding_frame_interval) ), 60);
 
-        // delete file if exists
-        QFileInfo infoFileDestination(newFileName);
-        if (infoFileDestination.exists()){
-            infoFileDestination.dir().remove(infoFileDestination.fileName());
+            try {
+                // ring of encoded pictures
+                replayBuffer = new ReplayBuffer(replay_duration);
+                Q_CHECK_PTR(replayBuffer);
+
+                // H264 is the cheapest encoder (ultrafast, zero latency)
+                // A key frame every second allows trimming the ring by steps of one second
+                replayRecorder = VideoRecorder::getRecorder(FORMAT_MP4_H264, tr("Instant replay"), framesSize.width(), framesSize.height(), replay_fps, quality);
+                replayRecorder->setGroupOfPictureSize(replay_fps);
+                replayRecorder->setReplayBuffer(replayBuffer);
+                replayRecorder->open();
+            }
+            catch (VideoRecorderException &e){
+                qCritical() << "RenderingEncoder" << QChar(124).toLatin1() << tr("Instant replay aborted. %1").arg(e.message());
+
+                if (replayRecorder)
+                    delete replayRecorder;
+                replayRecorder = NULL;
+                delete replayBuffer;
+                replayBuffer = NULL;
+
+                emit replayActivated(false);
+                return;
+            }
+
+            // create encoding thread with a short queue of frames
+            replayEncoder = new EncodingThread();
+            Q_CHECK_PTR(replayEncoder);
+            connect(replayEncoder, SIGNAL(encodingFinished(bool)), this, SLOT(replayFinished(bool)));
+            replayEncoder->initialize(replayRecorder, REPLAY_FRAME_QUEUE_SIZE);
+
+            // start the encoding thread and the timer
+            replay_pts = -1;
+            replay_timer.start();
+            replayEncoder->start();
+
+            qDebug() << "RenderingEncoder" << QChar(124).toLatin1() << tr("Instant replay started (last %1 s at %2 fps).").arg(replay_duration).arg(replay_fps);
         }
-        // move the temporaryFileName to newFileName
-        temporaryFolder.rename(temporaryFileName, newFileName);
-        emit status(tr("File %1 saved.").arg(newFileName), 2000);
-        qDebug() << newFileName << QChar(124).toLatin1() << tr("Recording saved.");
+        emit replayActivated(true);
     }
+    else if (replayEncoder) {
+        // stop the encoding thread and wait for it to finish
+        disconnect(replayEncoder, SIGNAL(encodingFinished(bool)), this, SLOT(replayFinished(bool)));
+        replayEncoder->stop();
+        replayEncoder->wait();
+
+        replayFinished(true);
+    }
+}
+
+void RenderingEncoder::replayFinished(bool success)
+{
+    if (!replayEncoder)
+        return;
+
+    // delete encoding thread
+    replayEncoder->wait();
+    delete replayEncoder;
+    replayEncoder = NULL;
+
+    // close and delete recorder
+    try {
+        replayRecorder->close();
+    }
+    catch (VideoRecorderException &e){
+        qWarning() << "RenderingEncoder" << QChar(124).toLatin1() << e.message();
+    }
+    delete replayRecorder;
+    replayRecorder = NULL;
+
+    // free memory of replay
+    delete replayBuffer;
+    replayBuffer = NULL;
+
+    if (success)
+        qDebug() << "RenderingEncoder" << QChar(124).toLatin1() << tr("Instant replay stopped.");
+    else
+        qWarning() << "RenderingEncoder" << QChar(124).toLatin1() << tr("Instant replay interrupted.");
+
+    emit replayActivated(false);
+}
+
+// Save the content of instant replay into a file
+// This is done in a separate thread with a copy of the
+// replay buffer so the instant replay continues.
+void RenderingEncoder::saveReplay()
+{
+    if (!replayBuffer || !replayRecorder) {
+        emit status(tr("Instant replay is not active."), 2000);
+        return;
+    }
+
+    QString filename = QString("glmixerreplay%1%2").arg(QDate::currentDate().toString("yyMMdd")).arg(QTime::currentTime().toString("hhmmsszzz")) + '.' + replayRecorder->getFileSuffix();
+    QFileInfo infoFileDestination(savingFolder, filename);
+
+    // save a copy of the replay buffer (the packets are shared, not copied)
+    ReplaySavingThread *saving = new ReplaySavingThread(replayBuffer->clone(), infoFileDestination.absoluteFilePath());
+    Q_CHECK_PTR(saving);
+    connect(saving, SIGNAL(saved(QString, int)), this, SLOT(replaySaved(QString, int)));
+    saving->start();
+
+    emit status(tr("Saving instant replay (%1, %2)..").arg(getStringFromTime(replayBuffer->bufferedDuration())).arg(getByteSizeString(replayBuffer->bufferedSize())), 2000);
+}
+
+void RenderingEncoder::replaySaved(QString filename, int framecount)
+{
+    emit status(tr("File %1 saved.").arg(filename), 2000);
+    qDebug() << filename << QChar(124).toLatin1() << tr("Instant replay saved (%1 frames).").arg(framecount);
+}
+
+void RenderingEncoder::setStreamingUrl(QString url)
+{
+    streaming_url = url.isEmpty() ? DEFAULT_STREAMING_URL : url;
+}
+
+void RenderingEncoder::setStreamingLatency(int ms)
+{
+    streaming_latency = CLAMP(ms, MIN_STREAMING_LATENCY, MAX_STREAMING_LATENCY);
+}
+
+// Start or stop the network streaming
+// - Create a low latency encoder sending its packets to the url
+// - Encode continuously in a separate thread, dropping frames
+//   instead of accumulating latency
+void RenderingEncoder::setStreamingActive(bool on)
+{
+    if (on) {
+        // activate if not already active
+        if (!streamEncoder) {
+
+            QSize framesSize = RenderingManager::getInstance()->getFrameBufferResolution();
+            int stream_fps = qBound(1, (int) ( 1000.0 / double(encoding_frame_interval) ), 60);
+
+            VideoRecorder *rec = NULL;
+            try {
+                rec = new VideoRecorderStream(streaming_url, framesSize.width(), framesSize.height(), stream_fps, quality);
+                Q_CHECK_PTR(rec);
+                rec->open();
+            }
+            catch (VideoRecorderException &e){
+                qCritical() << streaming_url << QChar(124).toLatin1() << tr("Streaming aborted. %1").arg(e.message());
+                if (rec)
+                    delete rec;
+                emit streamingActivated(false);
+                return;
+            }
+
+            // create encoding thread with a queue of frames bounded by the latency
+            streamEncoder = new EncodingThread();
+            Q_CHECK_PTR(streamEncoder);
+            connect(streamEncoder, SIGNAL(encodingFinished(bool)), this, SLOT(streamingFinished(bool)));
+            streamEncoder->initialize(rec, 1 + (streaming_latency * stream_fps) / 1000);
+
+            // start the encoding thread and the timer
+            stream_pts = -1;
+            stream_timer.start();
+            streamEncoder->start();
+
+            emit status(tr("Streaming to %1").arg(streaming_url), 2000);
+            qDebug() << streaming_url << QChar(124).toLatin1() << tr("Streaming started (%1 x %2 at %3 fps, %4 ms latency).").arg(rec->getWidth()).arg(rec->getHeight()).arg(stream_fps).arg(streaming_latency);
+        }
+        emit streamingActivated(true);
+    }
+    else if (streamEncoder) {
+        // stop the encoding thread and wait for it to finish
+        disconnect(streamEncoder, SIGNAL(encodingFinished(bool)), this, SLOT(streamingFinished(bool)));
+        streamEncoder->stop();
+        streamEncoder->wait();
+
+        streamingFinished(true);
+    }
+}
+
+void RenderingEncoder::streamingFinished(bool success)
+{
+    if (!streamEncoder)
+        return;
+
+    // delete encoding thread
+    streamEncoder->wait();
+    VideoRecorder *rec = streamEncoder->getRecorder();
+    int skipped = streamEncoder->getSkippedFrameCount();
+    delete streamEncoder;
+    streamEncoder = NULL;
+
+    // close and delete recorder
+    int framecount = 0;
+    try {
+        framecount = rec->close();
+    }
+    catch (VideoRecorderException &e){
+        qWarning() << streaming_url << QChar(124).toLatin1() << e.message();
+    }
+    delete rec;
+
+    if (success)
+        qDebug() << streaming_url << QChar(124).toLatin1() << tr("Streaming stopped (%1 frames sent, %2 dropped).").arg(framecount).arg(skipped);
+    else
+        qWarning() << streaming_url << QChar(124).toLatin1() << tr("Streaming interrupted.");
+
+    emit streamingActivated(false);
+}
+
+// Identify the conditions of the calibration
+// (results are only valid for the same resolution, frame rate,
+// quality, hardware acceleration and libavcodec version)
+QString RenderingEncoder::calibrationKey()
+{
+    QSize framesSize = RenderingManager::getInstance()->getFrameBufferResolution();
+    int fps = qBound(1, (int) ( 1000.0 / double(encoding_frame_interval) ), 60);
+
+    return QString("%1x%2_%3fps_q%4_%5_%6").arg(framesSize.width()).arg(framesSize.height()).arg(fps).arg(quality).arg(CodecManager::useHardwareAcceleration() ? "hw" : "sw").arg(LIBAVCODEC_VERSION_INT);
+}
+
+// Measure the performance of encoders for the current preferences
+// - Use the results cached from a previous calibration on this computer
+// - Otherwise encode synthetic frames in a background thread
+void RenderingEncoder::calibrate(bool force)
+{
+    // already calibrating
+    if (benchmark)
+        return;
+
+    performanceKey = calibrationKey();
+    performance.clear();
+
+    // read cached results
+    QSettings settings;
+    settings.beginGroup("EncoderBenchmark");
+    settings.beginGroup(performanceKey);
+    if (!force) {
+        for (int f = FORMAT_MP4_H264; f <= FORMAT_AVI_RAW; ++f) {
+            if (settings.contains(QString("%1/fps").arg(f))) {
+                EncoderPerformance p;
+                p.fps = settings.value(QString("%1/fps").arg(f)).toDouble();
+                p.cpu = settings.value(QString("%1/cpu").arg(f)).toDouble();
+                p.description = settings.value(QString("%1/description").arg(f)).toString();
+                performance[f] = p;
+            }
+        }
+    }
+    settings.endGroup();
+    settings.endGroup();
+
+    // all known
+    if (performance.size() > FORMAT_AVI_RAW)
+        return;
+
+    // start calibration in background
+    QSize framesSize = RenderingManager::getInstance()->getFrameBufferResolution();
+    int fps = qBound(1, (int) ( 1000.0 / double(encoding_frame_interval) ), 60);
+    benchmark = new EncoderBenchmark(framesSize.width(), framesSize.height(), fps, quality);
+    Q_CHECK_PTR(benchmark);
+    connect(benchmark, SIGNAL(measured(int, double, double, QString)), this, SLOT(setEncoderPerformance(int, double, double, QString)));
+    benchmark->start(QThread::LowestPriority);
+
+    qDebug() << "RenderingEncoder" << QChar(124).toLatin1() << tr("Measuring encoders performance at %1 x %2...").arg(framesSize.width()).arg(framesSize.height());
+}
+
+void RenderingEncoder::setEncoderPerformance(int format, double fps, double cpu, QString description)
+{
+    EncoderPerformance p;
+    p.fps = fps;
+    p.cpu = cpu;
+    p.description = description;
+    performance[format] = p;
+
+    // cache result for this computer
+    QSettings settings;
+    settings.beginGroup("EncoderBenchmark");
+    settings.beginGroup(performanceKey);
+    settings.setValue(QString("%1/fps").arg(format), fps);
+    settings.setValue(QString("%1/cpu").arg(format), cpu);
+    settings.setValue(QString("%1/description").arg(format), description);
+    settings.endGroup();
+    settings.endGroup();
+}
+
+double RenderingEncoder::encoderFramerate(encodingformat f)
+{
+    // results are for other conditions
+    if ( performanceKey != calibrationKey() || !performance.contains(f) )
+        return -1.0;
 
+    return performance[f].fps;
 }
 
 void RenderingEncoder::setBufferSize(unsigned long bytes){
@@ -29,6 +29,9 @@
 #include <QObject>
 #include <QElapsedTimer>
 #include <QString>
+#include <QList>
+#include <QMap>
+#include <QPointer>
 
 /**
  * Minimum and Maximum size of the recording buffer
@@ -41,11 +44,34 @@
 // default 200 MB
 #define DEFAULT_RECORDING_BUFFER_SIZE 209715200
 
+/**
+ * Number of frames waiting for encoding in instant replay
+ * (the replay is kept encoded in memory, see ReplayBuffer)
+ */
+#define REPLAY_FRAME_QUEUE_SIZE 8
+
+/**
+ * Maximum number of additional outputs encoded in parallel
+ * to the main recording
+ */
+#define MAX_RECORDING_OUTPUTS 4
+
+/**
+ * Maximum latency of the network streaming, in milliseconds
+ * (frames older than that are dropped instead of queued)
+ */
+#define MIN_STREAMING_LATENCY 40
+#define MAX_STREAMING_LATENCY 2000
+#define DEFAULT_STREAMING_LATENCY 200
+#define DEFAULT_STREAMING_URL "udp://127.0.0.1:1234?pkt_size=1316"
+
 extern "C" {
 #include <libavutil/frame.h>
+#include <libavutil/buffer.h>
 }
 
 #include "VideoRecorder.h"
+#include "EncoderBenchmark.h"
 #include "RenderingManager.h"
 
 class EncodingThread: public QThread {
@@ -57,17 +83,20 @@ public:
     EncodingThread();
     ~EncodingThread();
 
-    void initialize(VideoRecorder *rec, int width, int height, unsigned long bufSize);
+    void initialize(VideoRecorder *rec, int maxcount);
     void clear();
     void stop();
 
-    void releaseAndPushFrame(int elapsedtime);
-    AVBufferRef *lockFrameAndGetBuffer();
+    // Keep a reference to the frame in the queue (never waits)
+    // Return false if the frame was skipped because the queue is full
+    bool pushFrame(AVFrame *frame, int64_t pts = AV_NOPTS_VALUE);
     bool frameq_full();
 
-    int getFrameWidth() const { return framewidth; }
-    int getFrameHeight() const { return frameheight; }
+    VideoRecorder *getRecorder() const { return recorder; }
     int getFrameQueueSize() const { return pictq_max_count; }
+    int getSkippedFrameCount() const { return skipcount; }
+    int getFrameQueueCount() const { return pictq_size_count; }
+    int getEncodedFrameCount() const { return encodecount; }
 
 signals:
     void encodingFinished(bool);
@@ -83,15 +112,26 @@ protected:
     // execution management
     bool _quit;
     QMutex *pictq_mutex;
-    QWaitCondition *pictq_cond;
-    int time;
 
     // picture queue management
     int pictq_max_count, pictq_size_count, pictq_rindex, pictq_windex;
     AVFrame **frameq;
-    int framewidth, frameheight;
+    int skipcount, encodecount;
 };
 
+/**
+ * Additional output of the recording.
+ *
+ * Each output is encoded in its own thread from the same
+ * frames as the main recording, at a percentage of the
+ * rendering resolution.
+ */
+typedef struct {
+    encodingformat format;
+    encodingquality quality;
+    int scale;
+} RecordingOutput;
+
 class RenderingEncoder: public QObject {
 
     Q_OBJECT
@@ -113,17 +153,44 @@ public:
     void setEncodingQuality(encodingquality q);
     inline const encodingquality encodingQuality() { return quality; }
 
+    // preferences additional outputs
+    void addOutput(encodingformat f, encodingquality q, int scale);
+    void clearOutputs();
+    inline const QList<RecordingOutput> outputs() { return outputList; }
+
     // preferences saving mode
     void setAutomaticSavingMode(bool on);
     inline const bool automaticSavingMode() { return automaticSaving;}
     void setAutomaticSavingFolder(QString d);
     inline const QDir automaticSavingFolder() { return savingFolder; }
 
+    // preferences instant replay
+    void setReplayDuration(int seconds);
+    inline const int replayDuration() { return replay_duration; }
+
+    // preferences network streaming
+    void setStreamingUrl(QString url);
+    inline const QString streamingUrl() { return streaming_url; }
+    void setStreamingLatency(int ms);
+    inline const int streamingLatency() { return streaming_latency; }
+
     // status
     inline const bool isActive() { return started; }
+    inline const bool isReplayActive() { return replayEncoder != NULL; }
+    inline const bool isStreamingActive() { return streamEncoder != NULL; }
     inline const int getRecodingTime() { return encoding_duration; }
     bool acceptFrame();
 
+    // statistics of the main encoder (0 if not recording)
+    int encoderQueueCount();
+    int encoderQueueSize();
+    int encodedFrameCount();
+    int skippedFrameCount();
+
+    // performance of encoders measured on this computer
+    // (frames per second, -1 if unknown)
+    double encoderFramerate(encodingformat f);
+
     // utility
     static unsigned long computeBufferSize(int percent);
     static int computeBufferPercent(unsigned long bytes);
@@ -131,23 +198,41 @@ public:
 public slots:
     void setActive(bool on);
     void setPaused(bool on);
-    void saveFile(QString suffix, QString filename = QString::null);
-    void saveFileAs(QString suffix, QString description);
+    QString saveFile(QString suffix, QString filename = QString::null);
+    QString saveFileAs(QString suffix, QString description);
     void close(bool success);
     void kill();
 
     void setBufferSize(unsigned long bytes);
     unsigned long getBufferSize();
 
+    void setReplayActive(bool on);
+    void saveReplay();
+
+    void setStreamingActive(bool on);
+
+    void calibrate(bool force = false);
+
+private slots:
+    void replayFinished(bool success);
+    void replaySaved(QString filename, int framecount);
+    void streamingFinished(bool success);
+    void setEncoderPerformance(int format, double fps, double cpu, QString description);
+
 signals:
     void activated(bool);
     void processing(bool);
     void status(const QString &, int);
     void timing(const QString &);
     void selectAspectRatio(const standardAspectRatio );
+    void replayActivated(bool);
+    void streamingActivated(bool);
 
 protected:
     bool start();
+    AVFrame *createFrame(uint8_t *data);
+    bool moveTemporaryFile(QString temporary, QString destination);
+    QString calibrationKey();
 
 private:
     // files location
@@ -165,6 +250,37 @@ private:
     // encoder & recorder
     EncodingThread *encoder;
     VideoRecorder *recorder;
+    bool record_frame;
+
+    // additional outputs
+    QList<RecordingOutput> outputList;
+    QList<EncodingThread *> outputEncoders;
+
+    // frames shared by all encoders
+    AVBufferPool *framePool;
+    int pool_width, pool_height;
+
+    // instant replay
+    EncodingThread *replayEncoder;
+    VideoRecorder *replayRecorder;
+    class ReplayBuffer *replayBuffer;
+    QElapsedTimer replay_timer;
+    int64_t replay_pts;
+    int replay_duration;
+    bool replay_frame;
+
+    // network streaming
+    EncodingThread *streamEncoder;
+    QString streaming_url;
+    int streaming_latency;
+    QElapsedTimer stream_timer;
+    int64_t stream_pts;
+    bool stream_frame;
+
+    // encoders calibration
+    QPointer<EncoderBenchmark> benchmark;
+    QString performanceKey;
+    QMap<int, EncoderPerformance> performance;
 
     uint encoding_frame_interval;
     uint encoding_update_interval, display_update_interval;
@@ -40,6 +40,11 @@
 Source::RTTI RenderingSource::type = Source::RENDERING_SOURCE;
 #include "CloneSource.h"
 #include "ViewRenderWidget.h"
+#include "TextureUploader.h"
+#include "OutputPresenter.h"
+#include "glRenderWidget.h"
+#include "Profiler.h"
+#include "Tracer.h"
 #include "CatalogView.h"
 #include "RenderingEncoder.h"
 #include "SourcePropertyBrowser.h"
@@ -77,6 +82,7 @@ Source::RTTI RenderingSource::type = Source::RENDERING_SOURCE;
 #endif
 
 #include <map>
+#include <cstring>
 #include <algorithm>
 #include <QGLFramebufferObject>
 #include <QElapsedTimer>
@@ -85,8 +91,13 @@ Source::RTTI RenderingSource::type = Source::RENDERING_SOURCE;
 RenderingManager *RenderingManager::_instance = 0;
 bool RenderingManager::blit_fbo_extension = true;
 bool RenderingManager::pbo_extension = true;
+// enabled by setUsePboExtension() once the extensions are probed
+bool RenderingManager::persistent_pbo_extension = false;
 bool RenderingManager::get_texture_extension = true;
 
+// scales of the composition in dynamic resolution mode
+static const double dynamicResolutionScale[DYNAMIC_RESOLUTION_LEVELS] = { 1.0, 0.8, 0.65, 0.5 };
+
 // see https://en.wikipedia.org/wiki/Graphics_display_resolution
 QSize RenderingManager::sizeOfFrameBuffer[ASPECT_RATIO_ANY][QUALITY_UNSUPPORTED] = {
     { QSize(1024,768), QSize(1280,960), QSize(1600,1200), QSize(2048,1536), QSize(2560,1920), QSize(3200,2400) },
@@ -95,6 +106,22 @@ QSize RenderingManager::sizeOfFrameBuffer[ASPECT_RATIO_ANY][QUALITY_UNSUPPORTED]
     { QSize(960,540), QSize(1280,720), QSize(1920,1080), QSize(2048,1152), QSize(2560,1440), QSize(3840,2160) }
 };
 
+// what makes a source look different in the frame
+typedef struct {
+    Source *source;
+    GLuint texture;
+    double geometry[5];
+    qreal textureCoordinates[4];
+    uint blending[3];
+    int mask;
+    bool pixelated;
+    uint features;
+    ShaderAttributes attributes;
+} SourceCompositionState;
+
+// minimum number of static sources to pre-compose
+#define PRECOMPOSITION_MIN_SOURCES 2
+
 ViewRenderWidget *RenderingManager::getRenderingWidget() {
 
     return getInstance()->_renderwidget;
@@ -144,6 +171,11 @@ void RenderingManager::setUsePboExtension(bool on){
     }
 
     qDebug() << "RenderingManager" << QChar(124).toLatin1() << tr("OpenGL Pixel Buffer Object (GL_ARB_pixel_buffer_object) ") << (RenderingManager::pbo_extension ? "ON" : "OFF");
+
+    // pixel buffer objects mapped once (no synchronization when mapping at each frame)
+    RenderingManager::persistent_pbo_extension = RenderingManager::pbo_extension && glewIsSupported("GL_ARB_buffer_storage") && glewIsSupported("GL_ARB_sync");
+
+    qDebug() << "RenderingManager" << QChar(124).toLatin1() << tr("OpenGL Persistent Buffer Mapping (GL_ARB_buffer_storage) ") << (RenderingManager::persistent_pbo_extension ? "ON" : "OFF");
 }
 
 RenderingManager *RenderingManager::getInstance() {
@@ -173,7 +205,7 @@ void RenderingManager::deleteInstance() {
 }
 
 RenderingManager::RenderingManager() :
-    QObject(), renderingSize(QSize(1,1)), _fbo(NULL), previousframe_fbo(NULL), pbo_index(0), pbo_nextIndex(0), output_frame_index(0), output_frame_period(1), previous_frame_index(0), previous_frame_period(1), clearWhite(false), renderingQuality(QUALITY_HD), renderingAspectRatio(ASPECT_RATIO_4_3), _scalingMode(Source::SCALE_CROP), _elapsedTime(0), _playOnDrop(true), paused(false), needsUpdate(true), maxSourceCount(0), previous_frame_state(LOOPBACK_NONE)
+    QObject(), renderingSize(QSize(1,1)), _fbo(NULL), previousframe_fbo(NULL), precomposition_fbo(NULL), scaled_fbo(NULL), composition_fbo(NULL), dynamicResolutionMode(false), resolutionLevel(0), resolutionOverload(0), resolutionHeadroom(0), compositionQueryIndex(0), pbo_index(0), pbo_nextIndex(0), output_frame_index(0), output_frame_period(1), previous_frame_index(0), previous_frame_period(1), clearWhite(false), renderingQuality(QUALITY_HD), renderingAspectRatio(ASPECT_RATIO_4_3), _scalingMode(Source::SCALE_CROP), _elapsedTime(0), _playOnDrop(true), paused(false), needsUpdate(true), unchangedFrameCount(0), staticSourceCount(0), precompositionCount(0), maxSourceCount(0), previous_frame_state(LOOPBACK_NONE)
 {
     // idenfity for event
     setObjectName("RenderingManager");
@@ -189,6 +221,12 @@ RenderingManager::RenderingManager() :
     pboIds[0] = 0;
     pboIds[1] = 0;
 
+    // no timer query by default
+    compositionQueries[0] = 0;
+    compositionQueries[1] = 0;
+    compositionQueryPending[0] = false;
+    compositionQueryPending[1] = false;
+
     // create recorder and session switcher
     _recorder = new RenderingEncoder(this);
     _switcher = new SessionSwitcher(this);
@@ -237,6 +275,15 @@ RenderingManager::~RenderingManager() {
     clearSourceSet();
     delete _defaultSource;
 
+    // no more source to upload textures for
+    TextureUploader::deleteInstance();
+    // no more frame to present
+    OutputPresenter::deleteInstance();
+    // no more frame to measure
+    Profiler::deleteInstance();
+    // no more thread to trace
+    Tracer::deleteInstance();
+
     if (_renderwidget)
         delete _renderwidget;
 
@@ -246,9 +293,15 @@ RenderingManager::~RenderingManager() {
     if (previousframe_fbo)
         delete previousframe_fbo;
 
+    if (scaled_fbo)
+        delete scaled_fbo;
+
     if (pboIds[0] || pboIds[1])
         glDeleteBuffers(2, pboIds);
 
+    if (compositionQueries[0])
+        glDeleteQueries(2, compositionQueries);
+
     if (_recorder) {
         _recorder->kill();
         delete _recorder;
@@ -268,6 +321,18 @@ void RenderingManager::resetFrameBuffer()
         delete _fbo;
 
     _fbo = NULL;
+
+    if (precomposition_fbo)
+        delete precomposition_fbo;
+
+    precomposition_fbo = NULL;
+    precompositionCount = 0;
+
+    if (scaled_fbo)
+        delete scaled_fbo;
+
+    scaled_fbo = NULL;
+    composition_fbo = NULL;
 }
 
 bool RenderingManager::setRenderingQuality(frameBufferQuality q)
@@ -348,6 +413,14 @@ void RenderingManager::setFrameBufferResolution(QSize size) {
         delete _fbo;
     if (previousframe_fbo)
         delete previousframe_fbo;
+    if (precomposition_fbo)
+        delete precomposition_fbo;
+    precomposition_fbo = NULL;
+    precompositionCount = 0;
+    if (scaled_fbo)
+        delete scaled_fbo;
+    scaled_fbo = NULL;
+    composition_fbo = NULL;
     if (pboIds[0] || pboIds[1])
         glDeleteBuffers(2, pboIds);
 
@@ -355,6 +428,9 @@ void RenderingManager::setFrameBufferResolution(QSize size) {
     _fbo = new QGLFramebufferObject( qMin(size.width(), maxwidth), qMin(size.height(), maxheight));
     Q_CHECK_PTR(_fbo);
 
+    // new frame buffer has to be drawn
+    compositionState.clear();
+
     // get size
     renderingSize = _fbo->size();
 
@@ -444,8 +520,95 @@ double RenderingManager::getFrameBufferAspectRatio() const
     return ((double) renderingSize.width() / (double) renderingSize.height());
 }
 
+void RenderingManager::setDynamicResolution(bool on)
+{
+    static bool supported = glewIsSupported("GL_ARB_timer_query");
+
+    // the composition is scaled up with a blit
+    dynamicResolutionMode = on && supported && blit_fbo_extension;
+
+    if (dynamicResolutionMode && !compositionQueries[0])
+        glGenQueries(2, compositionQueries);
+    compositionQueryPending[0] = false;
+    compositionQueryPending[1] = false;
+
+    // back to full resolution
+    resolutionLevel = 0;
+    resolutionOverload = 0;
+    resolutionHeadroom = 0;
+    compositionState.clear();
+
+    qDebug() << "RenderingManager" << QChar(124).toLatin1() << tr("Dynamic resolution (GL_ARB_timer_query) ") << (dynamicResolutionMode ? "ON" : "OFF");
+}
+
+double RenderingManager::getRenderingScale() const
+{
+    return dynamicResolutionScale[resolutionLevel];
+}
+
+void RenderingManager::updateResolutionLevel()
+{
+    // result of the query issued two compositions ago (never waits for it)
+    GLuint query = compositionQueries[compositionQueryIndex];
+    if (!compositionQueryPending[compositionQueryIndex])
+        return;
+    compositionQueryPending[compositionQueryIndex] = false;
+
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+    double t = (double) elapsed / 1000000000.0;
+
+    // part of the period of composition given to the GPU
+    double period = glRenderTimer::getInstance()->refreshPeriod();
+    if ( !(period > 0.0) )
+        period = (double) glRenderTimer::getInstance()->interval() / 1000.0;
+    double budget = DYNAMIC_RESOLUTION_BUDGET * period * (double) output_frame_period;
+
+    int level = resolutionLevel;
+
+    // over budget for several frames : lower the resolution
+    if ( t > budget ) {
+        resolutionHeadroom = 0;
+        if ( ++resolutionOverload > DYNAMIC_RESOLUTION_DOWN_FRAMES && level < DYNAMIC_RESOLUTION_LEVELS - 1 )
+            level++;
+    }
+    else {
+        resolutionOverload = 0;
+        // the time at the upper resolution (proportional to the pixels)
+        // shall remain well under the budget for a while to step up
+        if ( level > 0 ) {
+            double r = dynamicResolutionScale[level - 1] / dynamicResolutionScale[level];
+            if ( t * r * r < 0.8 * budget ) {
+                if ( ++resolutionHeadroom > DYNAMIC_RESOLUTION_UP_FRAMES )
+                    level--;
+            }
+            else
+                resolutionHeadroom = 0;
+        }
+    }
+
+    if ( level != resolutionLevel ) {
+        resolutionLevel = level;
+        resolutionOverload = 0;
+        resolutionHeadroom = 0;
+        // ignore the time of the previous resolution
+        compositionQueryPending[0] = false;
+        compositionQueryPending[1] = false;
+        // the pre-composition is at the previous resolution
+        precompositionCount = 0;
+
+        qDebug() << "RenderingManager" << QChar(124).toLatin1() << tr("Dynamic resolution %1 % (composition %2 ms for %3 ms).").arg((int) (dynamicResolutionScale[resolutionLevel] * 100.0)).arg(t * 1000.0, 0, 'f', 1).arg(budget * 1000.0, 0, 'f', 1);
+    }
+}
+
 void RenderingManager::postRenderToFrameBuffer() {
 
+    TRACE_SCOPE("postRenderToFrameBuffer");
+
     if (_renderwidget->_catalogView->visible() ) {
         // finalize catalog view
         _renderwidget->_catalogView->reorganize();
@@ -498,7 +661,7 @@ void RenderingManager::postRenderToFrameBuffer() {
                     glViewport(0, 0, previousframe_fbo->width(), previousframe_fbo->height());
                     glColor4f(1.f, 1.f, 1.f, 1.f);
                     glBindTexture(GL_TEXTURE_2D, _fbo->texture());
-                    glCallList(ViewRenderWidget::quad_texured);
+                    ViewRenderWidget::drawQuad();
                 }
                 else {
                     // clear for init
@@ -526,8 +689,8 @@ void RenderingManager::postRenderToFrameBuffer() {
         _fbo->release();
     }
 
-    // save the frame to file or copy to SHM
-    if ( _recorder->isActive()
+    // save the frame to file, keep it for instant replay, stream it or copy to SHM
+    if ( _recorder->isActive() || _recorder->isReplayActive() || _recorder->isStreamingActive()
      #ifdef GLM_SHM
          || _sharedMemory != NULL
      #endif
@@ -535,9 +698,20 @@ void RenderingManager::postRenderToFrameBuffer() {
 
         if ( _recorder->acceptFrame() )
         {
+            Profiler::getInstance()->begin(tr("Readback"));
 
+            // same frame in both pixel buffer objects : no need to read it again
+            if (pboIds[0] && pboIds[1] && unchangedFrameCount > 1) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[pbo_nextIndex]);
+                uint8_t * ptr = (uint8_t *) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+                if(ptr)  {
+                    _recorder->addFrame(ptr);
+                }
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            }
             // use pixel buffer object if initialized
-            if (pboIds[0] && pboIds[1]) {
+            else if (pboIds[0] && pboIds[1]) {
 
                 // bind a PBO for asynchronous get of buffer
                 glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[pbo_index]);
@@ -571,8 +745,8 @@ void RenderingManager::postRenderToFrameBuffer() {
             }
 
 #ifdef GLM_SHM
-            // share to memory if needed
-            if (_sharedMemory != NULL) {
+            // share to memory if needed (and not already shared)
+            if (_sharedMemory != NULL && unchangedFrameCount < 1) {
                 _sharedMemory->lock();
                 // read the pixels from the texture
                 glGetTexImage(GL_TEXTURE_2D, 0, _sharedMemoryGLFormat, _sharedMemoryGLType, (GLvoid *) _sharedMemory->data());
@@ -581,7 +755,7 @@ void RenderingManager::postRenderToFrameBuffer() {
 #endif // SHM
 
             // restore state if using PBO
-            if (pboIds[0] && pboIds[1]) {
+            if (pboIds[0] && pboIds[1] && unchangedFrameCount < 2) {
                 // back to conventional pixel operation
                 glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
                 glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -591,6 +765,8 @@ void RenderingManager::postRenderToFrameBuffer() {
                 pbo_index = (pbo_index + 1) % 2;
                 pbo_nextIndex = (pbo_index + 1) % 2;
             }
+
+            Profiler::getInstance()->end();
         }
         // end accept frame
     }
@@ -608,6 +784,10 @@ void RenderingManager::postRenderToFrameBuffer() {
 
 #endif // SPOUT
 
+    // give the new frame to the output window thread
+    if ( OutputPresenter::isSupported() && unchangedFrameCount < 1 )
+        OutputPresenter::getInstance()->publish(_fbo);
+
     // restore state
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
@@ -626,7 +806,7 @@ void RenderingManager::preRenderToFrameBuffer()
 
     glPushAttrib( GL_COLOR_BUFFER_BIT );
 
-    // clear frame buffer
+    // render frame buffer
     if (!paused)
     {
         // frame delay
@@ -634,16 +814,15 @@ void RenderingManager::preRenderToFrameBuffer()
         {
             output_frame_index = 0;
 
-            if (_fbo && _fbo->bind())
-            {
-                if (clearWhite)
-                    glClearColor(1.f, 1.f, 1.f, 1.f);
-                else
-                    glClearColor(0.f, 0.f, 0.f, 1.f);
-                glClear(GL_COLOR_BUFFER_BIT);
-
-                _fbo->release();
+            // keep the previous frame if nothing changed
+            if ( frameChanged() ) {
+                Profiler::getInstance()->begin(tr("Composite"));
+                compositeToFrameBuffer();
+                Profiler::getInstance()->end();
+                unchangedFrameCount = 0;
             }
+            else
+                unchangedFrameCount++;
 
             needsUpdate = true;
         }
@@ -656,14 +835,117 @@ void RenderingManager::preRenderToFrameBuffer()
     glPopAttrib();
 }
 
-void RenderingManager::sourceRenderToFrameBuffer(Source *source) {
+bool RenderingManager::frameChanged()
+{
+    // the session switcher is drawn over the frame
+    bool changed = _switcher->alpha() > 0.f || _switcher->overlay() > 0.f;
+
+    // global parameters of the composition
+    QByteArray state;
+    state.append( (const char *) &clearWhite, sizeof(clearWhite) );
+    state.append( (const char *) &ViewRenderWidget::disableFiltering, sizeof(bool) );
+
+    // count the sources at the bottom which did not change
+    bool bottom = compositionState.startsWith(state);
+    int offset = state.size();
+    staticSourceCount = 0;
+
+    // state of the sources drawn (in depth order)
+    for(SourceSet::iterator  its = _front_sources.begin(); its != _front_sources.end(); its++) {
+
+        Source *s = *its;
+        if (!s || s->isStandby() || s->isCulled() || !(s->getAlpha() > 0.0))
+            continue;
+
+        // new content of texture
+        bool newtexture = s->hasChanged();
+        if (newtexture) {
+            changed = true;
+            s->setChanged(false);
+        }
 
-    if (!source)
-        return;
+        SourceCompositionState sc;
+        memset(&sc, 0, sizeof(SourceCompositionState));
+        sc.source = s;
+        sc.texture = s->getTextureIndex();
+        sc.geometry[0] = s->getX();
+        sc.geometry[1] = s->getY();
+        sc.geometry[2] = s->getScaleX();
+        sc.geometry[3] = s->getScaleY();
+        sc.geometry[4] = s->getRotationAngle();
+        QRectF t = s->getTextureCoordinates();
+        t.getCoords(sc.textureCoordinates, sc.textureCoordinates + 1, sc.textureCoordinates + 2, sc.textureCoordinates + 3);
+        sc.blending[0] = s->getBlendEquation();
+        sc.blending[1] = s->getBlendFuncSource();
+        sc.blending[2] = s->getBlendFuncDestination();
+        sc.mask = s->getMask();
+        sc.pixelated = s->isPixelated();
+        sc.attributes = s->getShaderAttributes();
+        sc.features = s->getShaderFeatures();
+
+        // same state as in the previous frame
+        if (bottom) {
+            bottom = !newtexture && compositionState.size() >= offset + (int) sizeof(SourceCompositionState)
+                    && memcmp(compositionState.constData() + offset, &sc, sizeof(SourceCompositionState)) == 0;
+            if (bottom)
+                staticSourceCount++;
+            offset += sizeof(SourceCompositionState);
+        }
+
+        state.append( (const char *) &sc, sizeof(SourceCompositionState) );
+    }
+
+    // the pre-composition is valid until one of its sources changes
+    // (texture, or any field of its SourceCompositionState)
+    if (staticSourceCount < precompositionCount)
+        precompositionCount = 0;
+
+    // any property changed
+    if (state != compositionState) {
+        compositionState = state;
+        changed = true;
+    }
+
+    return changed;
+}
+
+void RenderingManager::compositeToFrameBuffer()
+{
+    TRACE_SCOPE("compositeToFrameBuffer");
+
+    if (!_fbo)
+        qFatal( "%s", qPrintable( tr("OpenGL Frame Buffer Objects is not accessible "
+                                     "(RenderingManager bind failed).")));
+
+    // compose at the scale of the dynamic resolution
+    composition_fbo = _fbo;
+    if (dynamicResolutionMode) {
+        updateResolutionLevel();
+        if (resolutionLevel > 0) {
+            QSize size = QSize( (int) (_fbo->width() * dynamicResolutionScale[resolutionLevel]),
+                                (int) (_fbo->height() * dynamicResolutionScale[resolutionLevel]) );
+            if (scaled_fbo && scaled_fbo->size() != size) {
+                delete scaled_fbo;
+                scaled_fbo = NULL;
+            }
+            if (!scaled_fbo)
+                scaled_fbo = new QGLFramebufferObject(size);
+            composition_fbo = scaled_fbo;
+        }
+    }
+
+    // render to the frame buffer object (bound once for all sources)
+    if (!composition_fbo->bind())
+        qFatal( "%s", qPrintable( tr("OpenGL Frame Buffer Objects is not accessible "
+                                     "(RenderingManager bind failed).")));
+
+    // measure the time of the composition on the GPU
+    if (dynamicResolutionMode)
+        glBeginQuery(GL_TIME_ELAPSED, compositionQueries[compositionQueryIndex]);
 
     glPushAttrib(GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT);
 
-    glViewport(0, 0, _renderwidget->_renderView->viewport[2], _renderwidget->_renderView->viewport[3]);
+    glViewport(0, 0, composition_fbo->width(), composition_fbo->height());
 
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
@@ -673,46 +955,160 @@ void RenderingManager::sourceRenderToFrameBuffer(Source *source) {
     glPushMatrix();
     glLoadIdentity();
 
-    if (needsUpdate)
-    {
-        // render to the frame buffer object
-        if (_fbo && _fbo->bind())
-        {
-            //
-            // 1. Draw into first texture attachment; the final output rendering
-            //
-
-            // draw the source only if not culled and alpha not null
-            if (!source->isCulled() && source->getAlpha() > 0.0) {
-                glTranslated(source->getX(), source->getY(), 0.0);
-                glRotated(source->getRotationAngle(), 0.0, 0.0, 1.0);
-                glScaled(source->getScaleX(), source->getScaleY(), 1.f);
-
-                source->blend();
-                source->draw();
-            }
+    // occlusion culling : front to back, the sources
+    // below the first occluding source are hidden
+    bool hidden = false;
+    for(SourceSet::reverse_iterator  its = _front_sources.rbegin(); its != _front_sources.rend(); its++) {
 
-            _fbo->release();
+        Source *s = *its;
+        if (!s)
+            continue;
+
+        // a source in standby is not decoding anyway
+        if (s->isStandby()) {
+            s->setOccluded(true);
+            continue;
         }
+
+        // culled sources stay visible in the mixing view
+        if (s->isCulled() || !(s->getAlpha() > 0.0)) {
+            s->setOccluded(false);
+            continue;
+        }
+
+        s->setOccluded(hidden);
+
+        // a rendering source shows the sources below it
+        if (!hidden && s->rtti() != Source::RENDERING_SOURCE)
+            hidden = s->isOccluding();
+    }
+
+    // static sources at the bottom can be pre-composed if all are drawn
+    // (hidden sources depend on the sources above)
+    int precomposable = 0;
+    for(SourceSet::iterator  its = _front_sources.begin(); its != _front_sources.end() && precomposable < staticSourceCount; its++) {
+        Source *s = *its;
+        if (!s || s->isStandby() || s->isCulled() || !(s->getAlpha() > 0.0))
+            continue;
+        if (s->isOccluded())
+            break;
+        precomposable++;
+    }
+    if (!RenderingManager::blit_fbo_extension || precompositionCount > precomposable)
+        precompositionCount = 0;
+
+    // start from the pre-composition of the static sources
+    if (precompositionCount > 0) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, precomposition_fbo->handle());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, composition_fbo->handle());
+        glBlitFramebuffer(0, 0, composition_fbo->width(), composition_fbo->height(), 0, 0, composition_fbo->width(), composition_fbo->height(),
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        composition_fbo->bind();
+    }
+    // or clear
+    else {
+        if (clearWhite)
+            glClearColor(1.f, 1.f, 1.f, 1.f);
         else
-            qFatal( "%s", qPrintable( tr("OpenGL Frame Buffer Objects is not accessible "
-                                         "(RenderingManager %1x%2 bind failed).").arg(_fbo->width()).arg(_fbo->height())));
+            glClearColor(0.f, 0.f, 0.f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
 
+    // keep the result of the static sources for the next frames
+    int precompose = 0;
+    if (RenderingManager::blit_fbo_extension && precompositionCount == 0 && precomposable >= PRECOMPOSITION_MIN_SOURCES) {
+        if (precomposition_fbo && precomposition_fbo->size() != composition_fbo->size()) {
+            delete precomposition_fbo;
+            precomposition_fbo = NULL;
+        }
+        if (!precomposition_fbo)
+            precomposition_fbo = new QGLFramebufferObject(composition_fbo->size());
+        precompose = precomposable;
     }
+    int count = 0;
 
+    ViewRenderWidget::setSourceDrawingMode(true);
 
-    //
-    // 2. Draw sources into second texture  attachment ; the catalog (if visible)
-    //
-    if (_renderwidget->_catalogView->visible() ) {
+    // blending of the previous source drawn
+    bool blendchanged = true;
+    uint blend_eq = 0, source_blend = 0, destination_blend = 0;
 
-        // Draw this source into the catalog
-        _renderwidget->_catalogView->drawSource( source );
+    // draw the sources (reversed depth order)
+    for(SourceSet::iterator  its = _front_sources.begin(); its != _front_sources.end(); its++) {
+
+        Source *s = *its;
+
+        // draw the source only if not culled and alpha not null
+        if (!s || s->isStandby() || s->isCulled() || !(s->getAlpha() > 0.0))
+            continue;
+
+        // already drawn in the pre-composition, or hidden
+        if (++count <= precompositionCount || s->isOccluded())
+            continue;
 
+        // bind the source textures
+        s->bind();
+
+        // a rendering source copies the frame buffer when binding
+        if (s->rtti() == Source::RENDERING_SOURCE) {
+            composition_fbo->bind();
+            blendchanged = true;
+        }
+
+        s->setShaderAttributes();
+
+        // placement of the source given to the vertex shader
+        QMatrix4x4 transform;
+        transform.translate(s->getX(), s->getY());
+        transform.rotate(s->getRotationAngle(), 0.0, 0.0, 1.0);
+        transform.scale(s->getScaleX(), s->getScaleY());
+        ViewRenderWidget::setSourceTransform(transform);
+
+        // consecutive sources with the same blending share the blend state
+        if ( blendchanged || s->getBlendEquation() != blend_eq
+             || s->getBlendFuncSource() != source_blend
+             || s->getBlendFuncDestination() != destination_blend ) {
+            s->blend();
+            blend_eq = s->getBlendEquation();
+            source_blend = s->getBlendFuncSource();
+            destination_blend = s->getBlendFuncDestination();
+            blendchanged = false;
+        }
+
+        s->draw();
+
+        // done drawing the static sources
+        if (count == precompose) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, composition_fbo->handle());
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, precomposition_fbo->handle());
+            glBlitFramebuffer(0, 0, composition_fbo->width(), composition_fbo->height(), 0, 0, composition_fbo->width(), composition_fbo->height(),
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            composition_fbo->bind();
+            precompositionCount = precompose;
+        }
     }
 
-    // pop the projection matrix and GL state back for rendering the current view
-    // to the actual widget
+    ViewRenderWidget::setSourceTransform();
+    ViewRenderWidget::setSourceDrawingMode(false);
+
+    // scale up to the frame buffer
+    if (composition_fbo != _fbo) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, composition_fbo->handle());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo->handle());
+        glBlitFramebuffer(0, 0, composition_fbo->width(), composition_fbo->height(), 0, 0, _fbo->width(), _fbo->height(),
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        _fbo->bind();
+    }
+
+    if (dynamicResolutionMode) {
+        glEndQuery(GL_TIME_ELAPSED);
+        compositionQueryPending[compositionQueryIndex] = true;
+        compositionQueryIndex = (compositionQueryIndex + 1) % 2;
+    }
+
+    _fbo->release();
+
+    // restore GL state for rendering the current view
     glPopAttrib();
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
@@ -720,6 +1116,42 @@ void RenderingManager::sourceRenderToFrameBuffer(Source *source) {
     glPopMatrix();
 }
 
+void RenderingManager::sourceRenderToFrameBuffer(Source *source) {
+
+    if (!source)
+        return;
+
+    // NB: the sources are drawn into the frame buffer object
+    // by compositeToFrameBuffer() in preRenderToFrameBuffer()
+
+    //
+    // Draw sources into second texture  attachment ; the catalog (if visible)
+    //
+    if (_renderwidget->_catalogView->visible() ) {
+
+        glPushAttrib(GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT);
+
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadMatrixd(_renderwidget->_renderView->projection);
+
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        // Draw this source into the catalog
+        _renderwidget->_catalogView->drawSource( source );
+
+        // pop the projection matrix and GL state back for rendering the current view
+        // to the actual widget
+        glPopAttrib();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopMatrix();
+    }
+}
+
 Source *RenderingManager::newRenderingSource(bool recursive, double depth) {
 
 #ifndef NDEBUG
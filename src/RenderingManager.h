@@ -38,6 +38,14 @@
 // https://stackoverflow.com/questions/38140527/glreadpixels-vs-glgetteximage
 #define RECORDING_READ_PIXEL 1
 
+// dynamic resolution : number of scales of the composition,
+// fraction of the frame period for the GPU time of the composition,
+// and count of frames before stepping down or up
+#define DYNAMIC_RESOLUTION_LEVELS 4
+#define DYNAMIC_RESOLUTION_BUDGET 0.7
+#define DYNAMIC_RESOLUTION_DOWN_FRAMES 3
+#define DYNAMIC_RESOLUTION_UP_FRAMES 60
+
 typedef enum {
     QUALITY_QUARTER = 0,
     QUALITY_HD,
@@ -189,6 +197,12 @@ public:
     standardAspectRatio getLockedAspectRatio() const;
 
     double getFrameBufferAspectRatio() const;
+
+    // compose in a smaller frame buffer when the GPU is overloaded
+    // (the frame buffer keeps its resolution for output and recording)
+    void setDynamicResolution(bool on);
+    inline bool dynamicResolution() const { return dynamicResolutionMode; }
+    double getRenderingScale() const;
     inline QSize getFrameBufferResolution() const {
             return renderingSize;
     }
@@ -249,6 +263,7 @@ public:
     static void setUseFboBlitExtension(bool on);
 
     static inline bool usePboExtension() { return pbo_extension; }
+    static inline bool usePersistentPboExtension() { return persistent_pbo_extension; }
     static void setUsePboExtension(bool on);
 
     static inline bool useGetTextureExtension() { return get_texture_extension; }
@@ -308,6 +323,11 @@ protected:
 
     // frame buffer
     void setFrameBufferResolution(QSize size);
+    void compositeToFrameBuffer();
+    // true if the frame would differ from the previous one
+    bool frameChanged();
+    // change the scale of the composition from its GPU time
+    void updateResolutionLevel();
 
     // the rendering area
     ViewRenderWidget *_renderwidget;
@@ -318,6 +338,15 @@ protected:
     QSize renderingSize;
     QGLFramebufferObject *_fbo, *_outputfbo;
     QGLFramebufferObject *previousframe_fbo;
+    // result of the static sources at the bottom
+    QGLFramebufferObject *precomposition_fbo;
+    // smaller frame buffer (dynamic resolution) and target of the composition
+    QGLFramebufferObject *scaled_fbo, *composition_fbo;
+    bool dynamicResolutionMode;
+    int resolutionLevel, resolutionOverload, resolutionHeadroom;
+    GLuint compositionQueries[2];
+    bool compositionQueryPending[2];
+    int compositionQueryIndex;
     GLuint pboIds[2];
     int pbo_index, pbo_nextIndex;
     unsigned int output_frame_index, output_frame_period;
@@ -343,6 +372,10 @@ protected:
     Source::scalingMode _scalingMode;
     bool _playOnDrop;
     bool paused, needsUpdate;
+    // state of the sources for the last composition
+    QByteArray compositionState;
+    unsigned int unchangedFrameCount;
+    int staticSourceCount, precompositionCount;
     int maxSourceCount;
     // status for using previousframe_fbo
     typedef enum {LOOPBACK_NONE=0, LOOPBACK_INIT=1, LOOPBACK_RENDER=2 } LoopbackState;
@@ -357,7 +390,7 @@ protected:
     bool _spoutEnabled, _spoutInitialized;
 #endif
 
-    static bool blit_fbo_extension, pbo_extension, get_texture_extension;
+    static bool blit_fbo_extension, pbo_extension, persistent_pbo_extension, get_texture_extension;
     static QSize sizeOfFrameBuffer[ASPECT_RATIO_ANY][QUALITY_UNSUPPORTED];
 };
 
@@ -96,7 +96,10 @@ double RenderingSource::getFrameRate() const {
 
 void RenderingSource::bind()
 {
-    QGLFramebufferObject *fbo = RenderingManager::getInstance()->_fbo;
+    // frame buffer of the composition in progress (may be scaled down)
+    QGLFramebufferObject *fbo = RenderingManager::getInstance()->composition_fbo;
+    if (!fbo)
+        fbo = RenderingManager::getInstance()->_fbo;
     if (!_recursive && fbo) {
         if (_sfbo && _sfbo->size() != fbo->size()) {
             delete _sfbo;
@@ -144,7 +147,7 @@ void RenderingSource::bind()
                 glColor4f(1.f, 1.f, 1.f, 1.f);
                 glEnable(GL_TEXTURE_2D);
                 glBindTexture(GL_TEXTURE_2D, fbo->texture());
-                glCallList(ViewRenderWidget::quad_texured);
+                ViewRenderWidget::drawQuad();
 
                 _sfbo->release();
             }
@@ -141,8 +141,7 @@ void RenderingView::paint()
         glScaled( OutputRenderWindow::getInstance()->getAspectRatio()* SOURCE_UNIT, 1.0* SOURCE_UNIT, 1.0);
         glBindTexture(GL_TEXTURE_2D, RenderingManager::getInstance()->getFrameBufferTexture());
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glCallList(ViewRenderWidget::vertex_array_coords);
-        glDrawArrays(GL_QUADS, 0, 4);
+        ViewRenderWidget::drawQuad();
         glPopMatrix();
     }
 
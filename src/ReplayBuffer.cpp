@@ -0,0 +1,272 @@
+/*
+ * ReplayBuffer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#include "ReplayBuffer.moc"
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+#include <QDebug>
+
+#include "VideoRecorder.h"
+
+
+ReplayBuffer::ReplayBuffer(int seconds) : bytes(0), format(NULL), parameters(NULL)
+{
+    timebase = av_make_q(1, 25);
+    setDuration(seconds);
+}
+
+ReplayBuffer::~ReplayBuffer()
+{
+    clear();
+
+    if (parameters)
+        avcodec_parameters_free(&parameters);
+}
+
+void ReplayBuffer::setup(AVOutputFormat *f, const AVCodecParameters *p, AVRational tb)
+{
+    QMutexLocker locker(&mutex);
+
+    format = f;
+    timebase = tb;
+
+    if (!parameters)
+        parameters = avcodec_parameters_alloc();
+    avcodec_parameters_copy(parameters, p);
+}
+
+void ReplayBuffer::setDuration(int seconds)
+{
+    QMutexLocker locker(&mutex);
+
+    maximumDuration = CLAMP(seconds, MIN_REPLAY_DURATION, MAX_REPLAY_DURATION);
+}
+
+void ReplayBuffer::freeGroup(GroupOfPictures &gop)
+{
+    foreach (AVPacket *p, gop) {
+        bytes -= p->size;
+        av_packet_free(&p);
+    }
+    gop.clear();
+}
+
+void ReplayBuffer::clear()
+{
+    QMutexLocker locker(&mutex);
+
+    while (!groups.isEmpty()) {
+        freeGroup(groups.head());
+        groups.dequeue();
+    }
+
+    bytes = 0;
+}
+
+void ReplayBuffer::push(AVPacket *pkt)
+{
+    // reference the packet data (no copy)
+    AVPacket *p = av_packet_clone(pkt);
+    if (!p)
+        return;
+
+    QMutexLocker locker(&mutex);
+
+    // a key frame starts a new group of pictures
+    if ( groups.isEmpty() || (p->flags & AV_PKT_FLAG_KEY) )
+        groups.enqueue( GroupOfPictures() );
+
+    groups.last().append(p);
+    bytes += p->size;
+
+    // drop the oldest group of pictures while the following ones
+    // are enough to cover the replay duration
+    int64_t maxpts = av_rescale_q( (int64_t) maximumDuration, av_make_q(1, 1), timebase);
+    while ( groups.size() > 1 && (p->pts + p->duration - groups[1].first()->pts) >= maxpts ) {
+        freeGroup(groups.head());
+        groups.dequeue();
+    }
+}
+
+double ReplayBuffer::bufferedDuration()
+{
+    QMutexLocker locker(&mutex);
+
+    if (groups.isEmpty() || groups.last().isEmpty())
+        return 0.0;
+
+    AVPacket *first = groups.first().first();
+    AVPacket *last = groups.last().last();
+
+    return (double) (last->pts + last->duration - first->pts) * av_q2d(timebase);
+}
+
+qint64 ReplayBuffer::bufferedSize()
+{
+    QMutexLocker locker(&mutex);
+
+    return bytes;
+}
+
+ReplayBuffer *ReplayBuffer::clone()
+{
+    QMutexLocker locker(&mutex);
+
+    ReplayBuffer *copy = new ReplayBuffer(maximumDuration);
+    Q_CHECK_PTR(copy);
+
+    copy->format = format;
+    copy->timebase = timebase;
+    if (parameters) {
+        copy->parameters = avcodec_parameters_alloc();
+        avcodec_parameters_copy(copy->parameters, parameters);
+    }
+
+    foreach (const GroupOfPictures &gop, groups) {
+        GroupOfPictures g;
+        foreach (AVPacket *p, gop) {
+            AVPacket *c = av_packet_clone(p);
+            if (c) {
+                g.append(c);
+                copy->bytes += c->size;
+            }
+        }
+        copy->groups.enqueue(g);
+    }
+
+    return copy;
+}
+
+int ReplayBuffer::save(QString filename)
+{
+    int retcd = 0;
+    char errstr[128];
+    int framecount = 0;
+
+    QMutexLocker locker(&mutex);
+
+    if (!format || !parameters)
+        VideoRecorderException("Instant replay not initialized.").raise();
+
+    if (groups.isEmpty() || groups.first().isEmpty())
+        VideoRecorderException("Instant replay is empty.").raise();
+
+    // allocate output context
+    AVFormatContext *oc = NULL;
+    retcd = avformat_alloc_output_context2(&oc, format, NULL, qPrintable(filename));
+    if (retcd < 0 || !oc)
+        VideoRecorderException("Cannot allocate format context.").raise();
+
+    try {
+        // create video stream with the parameters of the encoder
+        AVStream *stream = avformat_new_stream(oc, NULL);
+        if (!stream)
+            VideoRecorderException("Cannot allocate stream.").raise();
+
+        retcd = avcodec_parameters_copy(stream->codecpar, parameters);
+        if (retcd < 0)
+            VideoRecorderException(QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+        stream->codecpar->codec_tag = 0;
+        stream->time_base = timebase;
+
+        // open file
+        retcd = avio_open(&oc->pb, qPrintable(filename), AVIO_FLAG_WRITE);
+        if (retcd < 0)
+            VideoRecorderException("File open " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+
+        retcd = avformat_write_header(oc, NULL);
+        if (retcd < 0)
+            VideoRecorderException("Write header " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+
+        // timestamps start at zero in the file
+        AVPacket *first = groups.first().first();
+        int64_t offset = first->dts != AV_NOPTS_VALUE ? first->dts : first->pts;
+
+        foreach (const GroupOfPictures &gop, groups) {
+            foreach (AVPacket *p, gop) {
+                AVPacket *pkt = av_packet_clone(p);
+                if (!pkt)
+                    continue;
+                if (pkt->pts != AV_NOPTS_VALUE)
+                    pkt->pts -= offset;
+                if (pkt->dts != AV_NOPTS_VALUE)
+                    pkt->dts -= offset;
+                av_packet_rescale_ts(pkt, timebase, stream->time_base);
+                pkt->stream_index = stream->index;
+
+                retcd = av_write_frame(oc, pkt);
+                av_packet_free(&pkt);
+                if (retcd < 0)
+                    VideoRecorderException(QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+
+                framecount++;
+            }
+        }
+
+        retcd = av_write_trailer(oc);
+        if (retcd < 0)
+            VideoRecorderException("Write trailer " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+    }
+    catch (VideoRecorderException &) {
+        avio_closep(&oc->pb);
+        avformat_free_context(oc);
+        throw;
+    }
+
+    // close file
+    avio_closep(&oc->pb);
+    avformat_free_context(oc);
+
+    return framecount;
+}
+
+
+ReplaySavingThread::ReplaySavingThread(ReplayBuffer *content, QString filename) : QThread(), buffer(content), fileName(filename)
+{
+    connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
+}
+
+ReplaySavingThread::~ReplaySavingThread()
+{
+    if (buffer)
+        delete buffer;
+}
+
+void ReplaySavingThread::run()
+{
+    if (!buffer)
+        return;
+
+    try {
+        int framecount = buffer->save(fileName);
+        emit saved(fileName, framecount);
+    }
+    catch (VideoRecorderException &e){
+        qWarning() << fileName << QChar(124).toLatin1() << e.message();
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ * ReplayBuffer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef REPLAYBUFFER_H
+#define REPLAYBUFFER_H
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include <QThread>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+
+/**
+ * Minimum and Maximum duration of the instant replay
+ * Expressed in seconds
+ */
+#define MIN_REPLAY_DURATION 5
+#define MAX_REPLAY_DURATION 300
+#define DEFAULT_REPLAY_DURATION 30
+
+typedef QList<AVPacket *> GroupOfPictures;
+
+/**
+ * In-memory ring of encoded packets, organized in groups of pictures.
+ *
+ * A VideoRecorder attached to a ReplayBuffer pushes its packets here
+ * instead of writing them into a file. The oldest groups of pictures
+ * are dropped as soon as the others cover the replay duration, so that
+ * the memory used is bounded by the duration times the encoder bitrate.
+ *
+ * The content can be saved into a movie file at any time (see clone()
+ * and ReplaySavingThread) without interrupting the recorder.
+ */
+class ReplayBuffer
+{
+public:
+    ReplayBuffer(int seconds = DEFAULT_REPLAY_DURATION);
+    ~ReplayBuffer();
+
+    // Set the muxer and stream parameters (called by VideoRecorder::open)
+    void setup(AVOutputFormat *format, const AVCodecParameters *parameters, AVRational timebase);
+
+    // Keep a reference to the packet and drop the oldest groups of pictures
+    void push(AVPacket *pkt);
+    void clear();
+
+    void setDuration(int seconds);
+    int duration() const { return maximumDuration; }
+
+    // status
+    double bufferedDuration();
+    qint64 bufferedSize();
+
+    // Create a copy of the current content (packets are referenced, not copied)
+    ReplayBuffer *clone();
+
+    // Write the content into a movie file
+    // Return number of frames saved
+    int save(QString filename);
+
+private:
+    void freeGroup(GroupOfPictures &gop);
+
+    QMutex mutex;
+    QQueue<GroupOfPictures> groups;
+    qint64 bytes;
+    int maximumDuration;
+
+    // muxing
+    AVOutputFormat *format;
+    AVCodecParameters *parameters;
+    AVRational timebase;
+};
+
+/**
+ * Thread saving a ReplayBuffer into a file.
+ *
+ * Takes ownership of the given buffer (usually obtained with ReplayBuffer::clone())
+ * and deletes itself when finished.
+ */
+class ReplaySavingThread: public QThread {
+
+    Q_OBJECT
+
+public:
+    ReplaySavingThread(ReplayBuffer *content, QString filename);
+    ~ReplaySavingThread();
+
+signals:
+    void saved(QString, int);
+
+protected:
+    void run();
+
+    ReplayBuffer *buffer;
+    QString fileName;
+};
+
+#endif // REPLAYBUFFER_H
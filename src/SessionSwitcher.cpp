@@ -71,7 +71,7 @@ void SessionSwitcher::render() {
 
         glColor4f(0.0, 0.0, 0.0, currentAlpha);
         glBindTexture(GL_TEXTURE_2D, ViewRenderWidget::black_texture);
-        glCallList(ViewRenderWidget::quad_texured);
+        ViewRenderWidget::drawQuad();
     }
 
     // if we shall render the overlay, do it !
@@ -86,7 +86,7 @@ void SessionSwitcher::render() {
             glBindTexture(GL_TEXTURE_2D, ViewRenderWidget::white_texture);
         }
 
-        glCallList(ViewRenderWidget::quad_texured);
+        ViewRenderWidget::drawQuad();
     }
 
 }
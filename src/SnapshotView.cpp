@@ -254,7 +254,7 @@ void SnapshotView::paint()
     ViewRenderWidget::setSourceDrawingMode(true);
     ViewRenderWidget::resetShaderAttributes();
     // draw flat version of sources
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_baseAlpha, 1.f);
+    ViewRenderWidget::setBaseAlpha(1.f);
 
     // show the interpolation line only if activating a target
     float alpha_drawing = 0.4;
@@ -33,6 +33,7 @@
 #include "RenderingManager.h"
 #include "PropertyBrowser.h"
 #include "Tag.h"
+#include "ColorLookupTable.h"
 
 #include <QtProperty>
 #include <QtVariantPropertyManager>
@@ -49,9 +50,11 @@ bool Source::playable = false;
 
 // source constructor.
 Source::Source(GLuint texture, double depth): ProtoSource(),
-    standby(NOT_STANDBY), culled(false),
+    standby(NOT_STANDBY), culled(false), occluded(false),
+    changed(true), trackChanges(false),
     clones(NULL), textureIndex(texture),
-    customMaskTextureIndex(0), workspace(0), fade(1.0)
+    customMaskTextureIndex(0), workspace(0), fade(1.0),
+    shaderFeatures(ViewRenderWidget::SHADER_ALL), colorTable(NULL)
 {
     // give it a unique identifier
     id = Source::lastid++;
@@ -79,6 +82,9 @@ Source::~Source() {
     if (textureIndex > 0)
         // free the OpenGL texture
         glDeleteTextures(1, &textureIndex);
+
+    if (colorTable)
+        delete colorTable;
 }
 
 QString Source::getInfo() const {
@@ -352,6 +358,14 @@ QDomElement Source::getConfiguration(QDomDocument &doc, QDir current)
         sourceElem.appendChild(m);
     }
 
+    // store the filename of the color table
+    if ( !getColorTable().isEmpty() ) {
+        QDomElement t = doc.createElement("ColorTable");
+        QDomText filename = doc.createTextNode( getColorTable() );
+        t.appendChild(filename);
+        sourceElem.appendChild(t);
+    }
+
 #ifdef GLM_TAG
     sourceElem.setAttribute("tag", Tag::get(this)->getIndex());
 #endif
@@ -369,6 +383,16 @@ QDomElement Source::getConfiguration(QDomDocument &doc, QDir current)
 }
 
 
+void Source::importProperties(const ProtoSource *s, bool withGeometry)
+{
+    ProtoSource::importProperties(s, withGeometry);
+
+    // the color table is not a property of proto sources
+    const Source *source = qobject_cast<const Source *>(s);
+    if (source)
+        setColorTable( source->getColorTable() );
+}
+
 bool Source::setConfiguration(QDomElement xmlconfig, QDir current)
 {
     // apply proto configuration
@@ -389,6 +413,10 @@ bool Source::setConfiguration(QDomElement xmlconfig, QDir current)
     if (!m.isNull())
         setCustomMaskTexture(m.text());
 
+    // read the configuration of the color table
+    QDomElement t = xmlconfig.firstChildElement("ColorTable");
+    setColorTable( t.isNull() ? QString::null : t.text() );
+
 #ifdef GLM_TAG
     // set tag
     if ( xmlconfig.hasAttribute("tag") )
@@ -578,6 +606,49 @@ void Source::testGeometryCulling() {
 
 }
 
+bool Source::isOccluding() const {
+
+    // draws opaque pixels only
+    if ( !isOpaque() || texalpha < 1.0 || texcolor.alpha() < 255 || mask_type != 0
+         || useChromaKey || lumakeyThreshold > 0 )
+        return false;
+
+    // replaces the pixels below
+    if ( blend_eq != GL_FUNC_ADD
+         || ( source_blend != GL_SRC_ALPHA && source_blend != GL_ONE )
+         || ( destination_blend != GL_ONE_MINUS_SRC_ALPHA && destination_blend != GL_ZERO ) )
+        return false;
+
+    // the corners of the rendering area are all inside the quad of the source
+    double ar = OutputRenderWindow::getInstance()->getAspectRatio();
+    double c = cos( rotangle * M_PI / 180.0 );
+    double s = sin( rotangle * M_PI / 180.0 );
+    for (int i = 0; i < 4; ++i) {
+        double px = (i & 1 ? SOURCE_UNIT : -SOURCE_UNIT) * ar - x;
+        double py = (i & 2 ? SOURCE_UNIT : -SOURCE_UNIT) - y;
+        // corner in the coordinates of the source (inverse rotation)
+        if ( ABS( c * px + s * py) > ABS(scalex) || ABS( -s * px + c * py) > ABS(scaley) )
+            return false;
+    }
+
+    return true;
+}
+
+void Source::setOccluded(bool on) {
+
+    // ignore non changing calls
+    if ( on == occluded )
+        return;
+
+    occluded = on;
+
+#ifdef GLM_FFGL
+    // do not run the plugins of a hidden source
+    if (! _ffgl_plugins.isEmpty() && !isStandby())
+        _ffgl_plugins.play( !occluded );
+#endif
+}
+
 void Source::setDepth(double v) {
     z = CLAMP(v, MIN_DEPTH_LAYER, MAX_DEPTH_LAYER);
 }
@@ -696,61 +767,142 @@ void Source::draw(GLenum mode) const {
     // set id in select mode, avoid texturing if not rendering.
     if (mode == GL_SELECT) {
         glLoadName(id);
-        glCallList(ViewRenderWidget::quad_texured);
+        ViewRenderWidget::drawQuad();
     }
     else {
 
         // texture coordinate
-        ViewRenderWidget::texc[0] = ViewRenderWidget::texc[6] = textureCoordinates.left();
-        ViewRenderWidget::texc[1] = ViewRenderWidget::texc[3] = textureCoordinates.top();
-        ViewRenderWidget::texc[2] = ViewRenderWidget::texc[4] = textureCoordinates.right();
-        ViewRenderWidget::texc[5] = ViewRenderWidget::texc[7] = textureCoordinates.bottom();
+        ViewRenderWidget::setTextureCoordinates(textureCoordinates.left(), textureCoordinates.top(), textureCoordinates.right(), textureCoordinates.bottom());
 
         // draw vertex array
-        glCallList(ViewRenderWidget::vertex_array_coords);
-        glDrawArrays(GL_QUADS, 0, 4);
+        ViewRenderWidget::drawQuad();
     }
 }
 
 
-void Source::setShaderAttributes() const {
+bool Source::hasChanged() const {
 
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_baseColor, texcolor);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_fading, (GLfloat) fade);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_baseAlpha, (GLfloat) texalpha);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_stippling, 0.f);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_gamma, (GLfloat) gammaRed, (GLfloat) gammaGreen, (GLfloat) gammaBlue, (GLfloat) gamma);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_levels, (GLfloat) gammaMinIn, (GLfloat) gammaMaxIn, (GLfloat) gammaMinOut, (GLfloat) gammaMaxOut);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_contrast, (GLfloat) contrast);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_brightness, (GLfloat) brightness);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_saturation, (GLfloat) saturation);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_hueshift, (GLfloat) hueShift);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_invertMode, (GLint) invertMode);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_nbColors, (GLint) numberOfColors);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_lumakey, (GLfloat) lumakeyThreshold / 100.f);
-
-    if (luminanceThreshold > 0 )
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_threshold, (GLfloat) luminanceThreshold / 100.f);
-    else
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_threshold, -1.f);
-
-    if (useChromaKey) {
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_chromakey, (GLfloat) chromaKeyColor.redF(), (GLfloat) chromaKeyColor.greenF(), (GLfloat) chromaKeyColor.blueF(), 1.f );
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_chromadelta, (GLfloat) chromaKeyTolerance );
-    } else {
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_chromakey, 0.f, 0.f, 0.f, 0.f );
-        ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_chromadelta, 0.f );
+#ifdef GLM_FFGL
+    // plugins render at every update
+    if (! _ffgl_plugins.isEmpty())
+        return true;
+#endif
+
+    // without tracking, the texture is considered always new
+    return changed || !trackChanges;
+}
+
+const ShaderAttributes &Source::getShaderAttributes() const {
+
+    // update the uniform values only when a property changed
+    if (shaderAttributesChanged) {
+        shaderAttributes.baseColor[0] = texcolor.redF();
+        shaderAttributes.baseColor[1] = texcolor.greenF();
+        shaderAttributes.baseColor[2] = texcolor.blueF();
+        shaderAttributes.baseColor[3] = texcolor.alphaF();
+        shaderAttributes.baseAlpha = (GLfloat) texalpha;
+        shaderAttributes.stippling = 0.f;
+        shaderAttributes.gamma[0] = (GLfloat) gammaRed;
+        shaderAttributes.gamma[1] = (GLfloat) gammaGreen;
+        shaderAttributes.gamma[2] = (GLfloat) gammaBlue;
+        shaderAttributes.gamma[3] = (GLfloat) gamma;
+        shaderAttributes.levels[0] = (GLfloat) gammaMinIn;
+        shaderAttributes.levels[1] = (GLfloat) gammaMaxIn;
+        shaderAttributes.levels[2] = (GLfloat) gammaMinOut;
+        shaderAttributes.levels[3] = (GLfloat) gammaMaxOut;
+        shaderAttributes.contrast = (GLfloat) contrast;
+        shaderAttributes.brightness = (GLfloat) brightness;
+        shaderAttributes.saturation = (GLfloat) saturation;
+        shaderAttributes.hueshift = (GLfloat) hueShift;
+        shaderAttributes.invertMode = (GLint) invertMode;
+        shaderAttributes.nbColors = (GLint) numberOfColors;
+        shaderAttributes.lumakey = (GLfloat) lumakeyThreshold / 100.f;
+        shaderAttributes.threshold = luminanceThreshold > 0 ? (GLfloat) luminanceThreshold / 100.f : -1.f;
+
+        if (useChromaKey) {
+            shaderAttributes.chromakey[0] = (GLfloat) chromaKeyColor.redF();
+            shaderAttributes.chromakey[1] = (GLfloat) chromaKeyColor.greenF();
+            shaderAttributes.chromakey[2] = (GLfloat) chromaKeyColor.blueF();
+            shaderAttributes.chromakey[3] = 1.f;
+            shaderAttributes.chromadelta = (GLfloat) chromaKeyTolerance;
+        } else {
+            shaderAttributes.chromakey[0] = shaderAttributes.chromakey[1] = 0.f;
+            shaderAttributes.chromakey[2] = shaderAttributes.chromakey[3] = 0.f;
+            shaderAttributes.chromadelta = 0.f;
+        }
+
+        shaderAttributes.filter_type = (GLint) filter;
+
+        // select the shader operations actually needed
+        shaderFeatures = ViewRenderWidget::SHADER_NONE;
+        if (filter > FILTER_NONE && filter < FILTER_CUSTOM_GLSL)
+            shaderFeatures |= ViewRenderWidget::SHADER_FILTER;
+        if (useChromaKey)
+            shaderFeatures |= ViewRenderWidget::SHADER_CHROMAKEY;
+        if (contrast != 1.0 || brightness != 0.0 || invertMode == INVERT_COLOR
+                || gamma != 1.0 || gammaRed != 1.0 || gammaGreen != 1.0 || gammaBlue != 1.0
+                || gammaMinIn != 0.0 || gammaMaxIn != 1.0 || gammaMinOut != 0.0 || gammaMaxOut != 1.0)
+            shaderFeatures |= ViewRenderWidget::SHADER_COLOR;
+        if (saturation != 1.0 || hueShift != 0.0 || invertMode == INVERT_LUMINANCE
+                || numberOfColors > 0 || lumakeyThreshold > 0 || luminanceThreshold > 0)
+            shaderFeatures |= ViewRenderWidget::SHADER_HSL;
+
+        // continuous color operations (and color table) baked in a 3D texture
+        // ; posterize, threshold and lumakey are steps which the interpolation
+        // of the table would blur, they are kept in the shader
+        bool colorOperations = shaderFeatures & (ViewRenderWidget::SHADER_COLOR | ViewRenderWidget::SHADER_HSL);
+        if ( ColorLookupTable::isSupported() && (colorOperations || !getColorTable().isEmpty()) ) {
+            if (!colorTable)
+                colorTable = new ColorLookupTable;
+            // bake again only if an operation of the table changed
+            if (colorOperationsChanged) {
+                ShaderAttributes baked = shaderAttributes;
+                baked.nbColors = 0;
+                baked.lumakey = 0.f;
+                baked.threshold = -1.f;
+                colorTable->bake(baked);
+                colorOperationsChanged = false;
+            }
+            shaderFeatures &= ~(ViewRenderWidget::SHADER_COLOR | ViewRenderWidget::SHADER_HSL);
+            shaderFeatures |= ViewRenderWidget::SHADER_LUT;
+
+            // the shader only applies the steps after the table
+            if (numberOfColors > 0 || lumakeyThreshold > 0 || luminanceThreshold > 0) {
+                shaderFeatures |= ViewRenderWidget::SHADER_HSL;
+                shaderAttributes.invertMode = (GLint) INVERT_NONE;
+                shaderAttributes.hueshift = 0.f;
+                shaderAttributes.saturation = 1.f;
+            }
+        }
+
+        shaderAttributesChanged = false;
     }
 
-    // done if no filtering
-    if (ViewRenderWidget::disableFiltering)
-        return;
+    // values not set by properties
+    shaderAttributes.fading = (GLfloat) fade;
+    shaderAttributes.filter_step[0] = 1.f / (GLfloat) getFrameWidth();
+    shaderAttributes.filter_step[1] = 1.f / (GLfloat) getFrameHeight();
+
+    return shaderAttributes;
+}
+
+void Source::setShaderAttributes() const {
 
-    // enable filtering
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_filter_type, (GLint) filter);
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_filter_step, 1.f / (GLfloat)  getFrameWidth(), 1.f / (GLfloat)  getFrameHeight());
-    ViewRenderWidget::program->setUniformValue(ViewRenderWidget::_filter_kernel, ViewRenderWidget::filter_kernel[filter]);
+    // update the values of the uniforms
+    getShaderAttributes();
 
+    // use the program variant for these features
+    ViewRenderWidget::setShaderFeatures(shaderFeatures);
+
+    // bind the color table (texture unit 2)
+    if (shaderFeatures & ViewRenderWidget::SHADER_LUT) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_3D, colorTable->texture());
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // send the values which differ from the previous source
+    ViewRenderWidget::setShaderAttributes(shaderAttributes);
 }
 
 void Source::setCustomMaskTexture(QString filename)
@@ -780,6 +932,33 @@ void Source::setCustomMaskTexture(QString filename)
                    << tr("Could not set custom texture ") << filename;
     }
 
+    // the mask type may be the same with a different image
+    changed = true;
+}
+
+void Source::setColorTable(QString filename)
+{
+    if (!colorTable) {
+        if (filename.isEmpty())
+            return;
+        colorTable = new ColorLookupTable;
+        CHECK_PTR_EXCEPTION(colorTable);
+    }
+
+    if (!colorTable->setCubeFile(filename))
+        qWarning() << name << QChar(124).toLatin1()
+                   << tr("Could not set color table ") << filename;
+
+    // the table has to be baked again
+    shaderAttributesChanged = true;
+    colorOperationsChanged = true;
+    // the table may be different with the same attributes
+    changed = true;
+}
+
+QString Source::getColorTable() const
+{
+    return colorTable ? colorTable->cubeFile() : QString::null;
 }
 
 void Source::bind() {
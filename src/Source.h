@@ -45,10 +45,31 @@ public:
 
 class QtProperty;
 class QGLFramebufferObject;
+class ColorLookupTable;
 
 class Source;
 typedef std::set<Source *> SourceList;
 
+/**
+ * Values of the uniform variables of the image processing shader.
+ *
+ * Each source keeps its own block (updated only when its properties
+ * change) and the ViewRenderWidget keeps the block currently loaded
+ * in the program, so that only the values which differ are sent.
+ */
+typedef struct {
+    GLfloat baseColor[4];
+    GLfloat baseAlpha, stippling, fading;
+    GLfloat gamma[4], levels[4];
+    GLfloat contrast, brightness, saturation, hueshift;
+    GLint invertMode, nbColors;
+    GLfloat threshold, lumakey;
+    GLfloat chromakey[4];
+    GLfloat chromadelta;
+    GLint filter_type;
+    GLfloat filter_step[2];
+} ShaderAttributes;
+
 /**
  * Base class for every source mixed in GLMixer.
  *
@@ -113,6 +134,8 @@ public:
 
     QDomElement getConfiguration(QDomDocument &doc, QDir current);
     bool setConfiguration(QDomElement xmlconfig, QDir current = QDir());
+    // import properties, including the color table of a source
+    void importProperties(const ProtoSource *s, bool withGeometry = true);
 
     /**
      *  Rendering
@@ -126,6 +149,10 @@ public:
     void blend() const;
     // begin and end the section which applies the various effects (convolution, color tables, etc).
     void setShaderAttributes() const;
+    // values given to the shader (updated if properties changed)
+    const ShaderAttributes &getShaderAttributes() const;
+    // program variant selected by getShaderAttributes()
+    inline uint getShaderFeatures() const { return shaderFeatures; }
     // to be called in the OpenGL loop to draw this source
     void draw(GLenum mode = GL_RENDER) const;
     //OpenGL access to the texture index
@@ -161,6 +188,9 @@ public:
     // custom mask
     void setCustomMaskTexture(QString filename);
     inline QString getCustomMaskTexture() const { return customMaskFilename; }
+    // color table (.cube file) applied before color corrections
+    void setColorTable(QString filename);
+    QString getColorTable() const;
 
     /**
      *  Geometry and deformation
@@ -168,6 +198,25 @@ public:
     inline bool isCulled() const {
         return culled;
     }
+    // hidden by an occluding source above (not drawn)
+    inline bool isOccluded() const {
+        return occluded;
+    }
+    virtual void setOccluded(bool on);
+    // covers the whole rendering area with opaque pixels
+    bool isOccluding() const;
+    // all the pixels of the texture are opaque
+    virtual bool isOpaque() const {
+        return false;
+    }
+
+    /**
+     * Changes of the texture (since the last composition of the frame)
+     */
+    virtual bool hasChanged() const;
+    inline void setChanged(bool on) {
+        changed = on;
+    }
 
     typedef enum {
         SCALE_CROP= 0,
@@ -311,7 +360,9 @@ protected:
     StandbyMode standby;
 
     // flags for updating (or not)
-    bool culled;
+    bool culled, occluded;
+    // the texture changed (only if the subclass tracks changes)
+    bool changed, trackChanges;
 
     // clone list
     SourceList *clones;
@@ -339,6 +390,13 @@ protected:
     inline void setFading(double f) { fade = f; }
     inline double fading() { return fade; }
 
+    // values of the shader uniforms for this source
+    mutable ShaderAttributes shaderAttributes;
+    // features of the shader used by this source
+    mutable uint shaderFeatures;
+    // color corrections baked in a table
+    mutable ColorLookupTable *colorTable;
+
 private:
     // identity counter
     static GLuint lastid;
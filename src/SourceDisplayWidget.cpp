@@ -91,7 +91,7 @@ void SourceDisplayWidget::paintGL()
         // draw the background
         glScalef(2.f * aspectRatio, 2.f * aspectRatio, 1.f);
         glBindTexture(GL_TEXTURE_2D, _bgTexture);
-        glCallList(ViewRenderWidget::quad_texured);
+        ViewRenderWidget::drawQuad();
         glLoadIdentity();
     }
 
@@ -125,7 +125,7 @@ void SourceDisplayWidget::paintGL()
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, s->isPixelated() ? GL_NEAREST : GL_LINEAR);
 
         // draw a quad with the texture
-        glCallList(ViewRenderWidget::quad_texured);
+        ViewRenderWidget::drawQuad();
 
         // display effect on the right
         if (_effects) {
@@ -136,7 +136,7 @@ void SourceDisplayWidget::paintGL()
             s->bind();
 
             // draw a quad with the texture
-            glCallList(ViewRenderWidget::quad_texured);
+            ViewRenderWidget::drawQuad();
 
             glDisable(GL_SCISSOR_TEST);
         }
@@ -330,6 +330,11 @@ void SourcePropertyBrowser::createSourcePropertyTree(){
     intManager->setRange(property, 0, 256);
     intManager->setSingleStep(property, 1);
     root->addSubProperty(property);
+    // color table on/off
+    property = boolManager->addProperty("ColorTable");
+    property->setToolTip("Apply a 3D color lookup table (.cube file)");
+    idToProperty[property->propertyName()] = property;
+    root->addSubProperty(property);
 
     // enum list of filters
     property = enumManager->addProperty("Filter");
@@ -600,6 +605,14 @@ void SourcePropertyBrowser::valueChanged(QtProperty *property,  bool value){
         idToProperty["ChromaKeyColor"]->setEnabled(value);
         idToProperty["ChromaKeyTolerance"]->setEnabled(value);
     }
+    else if ( property == idToProperty["ColorTable"] ) {
+        QString filename;
+        if (value)
+            filename = GLMixer::getInstance()->getColorTableFileName( currentItem->getColorTable() );
+        currentItem->setColorTable( filename );
+        if ( value && currentItem->getColorTable().isEmpty() )
+            updateProperty("ColorTable", currentItem);
+    }
 
 }
 
@@ -784,6 +797,8 @@ void SourcePropertyBrowser::updateProperty(QString name, Source *s)
         colorManager->setValue(idToProperty["Color"], QColor( s->getColor()));
     else if ( name.compare("Pixelated") == 0)
         boolManager->setValue(idToProperty["Pixelated"], s->isPixelated());
+    else if ( name.compare("ColorTable") == 0)
+        boolManager->setValue(idToProperty["ColorTable"], !s->getColorTable().isEmpty());
     else if ( name.compare("Invert") == 0)
         enumManager->setValue(idToProperty["Invert"], (int) s->getInvertMode() );
     else if ( name.compare("Saturation") == 0)
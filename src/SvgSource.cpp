@@ -79,6 +79,9 @@ SvgSource::SvgSource(QByteArray content, GLuint texture, double d): Source(textu
                     0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, _rendered.bits() );
 #endif
 
+    // the texture never changes
+    trackChanges = true;
+
 }
 
 SvgSource::~SvgSource()
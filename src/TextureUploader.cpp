@@ -0,0 +1,338 @@
+/*
+ * TextureUploader.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#include "TextureUploader.h"
+
+#include "VideoPicture.h"
+#include "RenderingManager.h"
+#include "ViewRenderWidget.h"
+#include "Tracer.h"
+
+#include <QDebug>
+
+TextureUploader *TextureUploader::_instance = 0;
+
+bool TextureUploader::isSupported()
+{
+    static int supported = -1;
+
+    if (supported < 0) {
+        supported = glewIsSupported("GL_ARB_sync") && glewIsSupported("GL_ARB_copy_image") ? 1 : 0;
+        qDebug() << "TextureUploader" << QChar(124).toLatin1() << QObject::tr("OpenGL texture upload thread (GL_ARB_sync, GL_ARB_copy_image) ") << (supported ? "ON" : "OFF");
+    }
+
+    return supported > 0;
+}
+
+TextureUploader *TextureUploader::getInstance()
+{
+    if (_instance == 0) {
+        _instance = new TextureUploader;
+        Q_CHECK_PTR(_instance);
+        _instance->start(QThread::HighPriority);
+    }
+
+    return _instance;
+}
+
+void TextureUploader::deleteInstance()
+{
+    if (_instance != 0)
+        delete _instance;
+    _instance = 0;
+}
+
+TextureUploader::TextureUploader() : QThread(), busy(NULL), _quit(false)
+{
+    setObjectName("TextureUploader");
+
+    // keep the context of the caller
+    const QGLContext *current = QGLContext::currentContext();
+
+    // hidden widget giving an OpenGL context sharing textures with the rendering
+    _glwidget = new QGLWidget(glRenderWidgetFormat(), 0, RenderingManager::getRenderingWidget());
+    Q_CHECK_PTR(_glwidget);
+    if (!_glwidget->isSharing())
+        qWarning() << "TextureUploader" << QChar(124).toLatin1() << QObject::tr("OpenGL context not shared; textures cannot be uploaded in a thread.");
+
+    // the context is made current in the thread
+    _glwidget->doneCurrent();
+    if (current)
+        const_cast<QGLContext *>(current)->makeCurrent();
+}
+
+TextureUploader::~TextureUploader()
+{
+    // stop the thread
+    mutex.lock();
+    _quit = true;
+    uploadRequested.wakeAll();
+    mutex.unlock();
+    wait();
+
+    delete _glwidget;
+}
+
+void TextureUploader::cancel(TextureRing *r)
+{
+    QMutexLocker locker(&mutex);
+
+    for (int i = uploads.size() - 1; i > -1; --i)
+        if (uploads[i].first == r)
+            uploads.removeAt(i);
+
+    while (busy == r)
+        uploadDone.wait(&mutex);
+}
+
+void TextureUploader::run()
+{
+    _glwidget->makeCurrent();
+
+    mutex.lock();
+    while (!_quit) {
+
+        // wait for a picture to upload
+        if (uploads.isEmpty()) {
+            uploadRequested.wait(&mutex);
+            continue;
+        }
+
+        QPair<TextureRing *, int> u = uploads.takeFirst();
+        busy = u.first;
+        busy->slots[u.second].state = TextureRing::SLOT_UPLOADING;
+        mutex.unlock();
+
+        // the ring cannot change the slot while uploading
+        TRACE_WAIT("upload", busy->upload(u.second));
+
+        mutex.lock();
+        busy->slots[u.second].state = TextureRing::SLOT_UPLOADED;
+        busy = NULL;
+        uploadDone.wakeAll();
+    }
+    mutex.unlock();
+
+    _glwidget->doneCurrent();
+}
+
+
+TextureRing::TextureRing(int w, int h, GLenum f, GLint internalformat, int r) :
+    width(w), height(h), rowlength(r), format(f), sequence(0), discarded(0)
+{
+    // size of the pictures (see VideoPicture::getBufferSize)
+    buffersize = height * qMax(rowlength, width) * (format == GL_RGBA ? 4 : 3);
+
+    // keep the texture of the caller
+    GLint previous = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+
+    for (int i = 0; i < TEXTURERING_SIZE; ++i) {
+        glGenTextures(1, &slots[i].texture);
+        glBindTexture(GL_TEXTURE_2D, slots[i].texture);
+        // complete texture (required for copy)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        // same format as the texture of the source
+        glTexImage2D(GL_TEXTURE_2D, 0, internalformat, width, height, 0, format, GL_UNSIGNED_BYTE, NULL);
+
+        // pixel buffer object mapped for the lifetime of the ring
+        slots[i].pbo = 0;
+        slots[i].pointer = NULL;
+        if (RenderingManager::usePersistentPboExtension()) {
+            glGenBuffers(1, &slots[i].pbo);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slots[i].pbo);
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, buffersize, 0, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+            slots[i].pointer = (GLubyte*) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, buffersize, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            // upload from the picture if mapping failed
+            if (!slots[i].pointer) {
+                glDeleteBuffers(1, &slots[i].pbo);
+                slots[i].pbo = 0;
+            }
+        }
+
+        slots[i].fence = 0;
+        slots[i].picture = NULL;
+        slots[i].state = SLOT_FREE;
+        slots[i].sequence = 0;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, previous);
+}
+
+TextureRing::~TextureRing()
+{
+    // make sure the thread is not using the ring
+    TextureUploader::getInstance()->cancel(this);
+
+    for (int i = 0; i < TEXTURERING_SIZE; ++i) {
+        if (slots[i].state == SLOT_QUEUED && slots[i].picture->hasAction(VideoPicture::ACTION_DELETE))
+            delete slots[i].picture;
+        if (slots[i].fence)
+            glDeleteSync(slots[i].fence);
+        glDeleteTextures(1, &slots[i].texture);
+        if (slots[i].pbo) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slots[i].pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &slots[i].pbo);
+        }
+    }
+}
+
+bool TextureRing::push(VideoPicture *vp)
+{
+    TextureUploader *u = TextureUploader::getInstance();
+    QMutexLocker locker(&u->mutex);
+
+    // replace the picture waiting to be uploaded
+    // or take a free texture
+    int s = -1;
+    for (int i = 0; i < TEXTURERING_SIZE && s < 0; ++i)
+        if (slots[i].state == SLOT_QUEUED)
+            s = i;
+    for (int i = 0; i < TEXTURERING_SIZE && s < 0; ++i)
+        if (slots[i].state == SLOT_FREE)
+            s = i;
+
+    // all textures are being used
+    if (s < 0)
+        return false;
+
+    if (slots[s].state == SLOT_QUEUED) {
+        // drop the previous picture
+        if (slots[s].picture->hasAction(VideoPicture::ACTION_DELETE))
+            delete slots[s].picture;
+    }
+    else {
+        // request upload
+        u->uploads.append( qMakePair(this, s) );
+        u->uploadRequested.wakeAll();
+    }
+
+    slots[s].picture = vp;
+    slots[s].state = SLOT_QUEUED;
+    slots[s].sequence = ++sequence;
+
+    return true;
+}
+
+bool TextureRing::pull(GLuint texture)
+{
+    TextureUploader *u = TextureUploader::getInstance();
+    QMutexLocker locker(&u->mutex);
+
+    // most recent texture uploaded and ready on the GPU
+    int latest = -1;
+    for (int i = 0; i < TEXTURERING_SIZE; ++i) {
+        if (slots[i].state != SLOT_UPLOADED || slots[i].sequence <= discarded)
+            continue;
+        GLenum r = glClientWaitSync(slots[i].fence, 0, 0);
+        if ( (r == GL_ALREADY_SIGNALED || r == GL_CONDITION_SATISFIED)
+             && (latest < 0 || slots[i].sequence > slots[latest].sequence) )
+            latest = i;
+    }
+
+    // free the textures older than the latest (fences are signaled in order)
+    unsigned int last = latest < 0 ? discarded : qMax(discarded, slots[latest].sequence);
+    for (int i = 0; i < TEXTURERING_SIZE; ++i) {
+        if (slots[i].state != SLOT_UPLOADED || slots[i].sequence > last)
+            continue;
+        // (a discarded upload may still read its pixel buffer : the thread
+        // waits for the fence before writing into it again)
+        if (slots[i].fence && !slots[i].pointer) {
+            glDeleteSync(slots[i].fence);
+            slots[i].fence = 0;
+        }
+        slots[i].state = SLOT_FREE;
+    }
+
+    if (latest < 0)
+        return false;
+
+    // copy in GPU memory
+    glCopyImageSubData(slots[latest].texture, GL_TEXTURE_2D, 0, 0, 0, 0,
+                       texture, GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+
+    // the thread shall not overwrite the texture before the copy
+    if (slots[latest].fence)
+        glDeleteSync(slots[latest].fence);
+    slots[latest].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    return true;
+}
+
+void TextureRing::discard()
+{
+    TextureUploader *u = TextureUploader::getInstance();
+    QMutexLocker locker(&u->mutex);
+
+    discarded = sequence;
+}
+
+void TextureRing::upload(int s)
+{
+    // wait for the previous copy from this texture
+    if (slots[s].fence) {
+        // the pixel buffer is written by the CPU : wait until the GPU
+        // is done with it (previous upload, and copy from the texture)
+        if (slots[s].pointer) {
+            while ( glClientWaitSync(slots[s].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED );
+        }
+        else
+            glWaitSync(slots[s].fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(slots[s].fence);
+        slots[s].fence = 0;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, slots[s].texture);
+    if (rowlength)
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, rowlength);
+
+    if (slots[s].pointer) {
+        // copy into the mapped buffer, then transfer by the GPU
+        memmove(slots[s].pointer, slots[s].picture->getBuffer(), qMin(buffersize, slots[s].picture->getBufferSize()));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slots[s].pbo);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, slots[s].picture->getBuffer());
+
+    if (rowlength)
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // signal when the upload is over
+    slots[s].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    // the pixels are copied
+    if (slots[s].picture->hasAction(VideoPicture::ACTION_DELETE))
+        delete slots[s].picture;
+    slots[s].picture = NULL;
+}
@@ -0,0 +1,135 @@
+/*
+ * TextureUploader.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef TEXTUREUPLOADER_H
+#define TEXTUREUPLOADER_H
+
+#include "common.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <QPair>
+
+/**
+ * Number of textures in the ring of each source
+ */
+#define TEXTURERING_SIZE 3
+
+class VideoPicture;
+class TextureRing;
+
+/**
+ * Thread uploading pictures into textures, with its own
+ * OpenGL context shared with the rendering widget.
+ *
+ * The uploads are requested by the TextureRing of each source,
+ * and a fence is placed after each of them.
+ */
+class TextureUploader: public QThread {
+
+    friend class TextureRing;
+
+public:
+    static TextureUploader *getInstance();
+    static void deleteInstance();
+
+    // are sync objects and texture copy available ?
+    static bool isSupported();
+
+protected:
+    void run();
+
+private:
+    TextureUploader();
+    ~TextureUploader();
+    static TextureUploader *_instance;
+
+    // remove the uploads of a ring and wait for the current one
+    void cancel(TextureRing *r);
+
+    QGLWidget *_glwidget;
+    QMutex mutex;
+    QWaitCondition uploadRequested, uploadDone;
+    QList< QPair<TextureRing *, int> > uploads;
+    TextureRing *busy;
+    bool _quit;
+};
+
+/**
+ * Textures of a source filled by the TextureUploader thread.
+ *
+ * The rendering thread gives the pictures with push() and, when
+ * rendering, pull() copies the most recent texture ready into the
+ * texture of the source (a copy in GPU memory). A picture waiting
+ * to be uploaded is replaced by a newer one.
+ *
+ * With persistent buffer mapping, each texture has its own pixel buffer
+ * object mapped once; the thread copies the picture into it and the
+ * transfer to the texture is done by the GPU (DMA).
+ */
+class TextureRing {
+
+    friend class TextureUploader;
+
+public:
+    TextureRing(int width, int height, GLenum format, GLint internalformat, int rowlength = 0);
+    ~TextureRing();
+
+    // request upload of the picture (false if all textures are in use)
+    bool push(VideoPicture *vp);
+    // copy the most recent uploaded picture into the texture (false if none)
+    bool pull(GLuint texture);
+    // ignore the pictures pushed so far
+    void discard();
+
+private:
+    // called by the upload thread
+    void upload(int slot);
+
+    typedef enum {
+        SLOT_FREE = 0,
+        SLOT_QUEUED,
+        SLOT_UPLOADING,
+        SLOT_UPLOADED
+    } slotState;
+
+    struct {
+        GLuint texture;
+        GLuint pbo;
+        GLubyte *pointer;
+        GLsync fence;
+        VideoPicture *picture;
+        slotState state;
+        unsigned int sequence;
+    } slots[TEXTURERING_SIZE];
+
+    int width, height, rowlength, buffersize;
+    GLenum format;
+    unsigned int sequence, discarded;
+};
+
+#endif // TEXTUREUPLOADER_H
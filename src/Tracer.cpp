@@ -0,0 +1,221 @@
+/*
+ * Tracer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#include "Tracer.h"
+
+#include <QObject>
+#include <QThread>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <QDebug>
+
+Tracer *Tracer::_instance = 0;
+volatile bool Tracer::enabled = false;
+QMutex Tracer::mutex;
+QList<Tracer::Buffer *> Tracer::buffers;
+int Tracer::lastTid = 0;
+
+Tracer *Tracer::getInstance()
+{
+    if (_instance == 0) {
+        _instance = new Tracer;
+        Q_CHECK_PTR(_instance);
+    }
+
+    return _instance;
+}
+
+void Tracer::deleteInstance()
+{
+    if (_instance != 0)
+        delete _instance;
+    _instance = 0;
+}
+
+Tracer::Tracer()
+{
+    clock.start();
+}
+
+Tracer::~Tracer()
+{
+    enabled = false;
+
+    // free the buffers of the threads which ended
+    // (the others are still referenced by their thread)
+    QMutexLocker locker(&mutex);
+    QList<Buffer *>::iterator it = buffers.begin();
+    while (it != buffers.end()) {
+        if (!(*it)->alive) {
+            delete *it;
+            it = buffers.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+void Tracer::setEnabled(bool on)
+{
+    enabled = on;
+
+    qDebug() << "Tracer" << QChar(124).toLatin1() << QObject::tr("Tracing of threads ") << (on ? "ON" : "OFF");
+}
+
+// releases the buffer when its thread ends
+class ThreadBuffer {
+public:
+    ThreadBuffer() : buffer(0) { }
+    ~ThreadBuffer() {
+        if (buffer)
+            Tracer::releaseBuffer(buffer);
+    }
+    Tracer::Buffer *buffer;
+};
+
+Tracer::Buffer *Tracer::threadBuffer()
+{
+    static thread_local ThreadBuffer local;
+
+    if (!local.buffer) {
+
+        // name of the thread in the timeline
+        QString name;
+        QThread *t = QThread::currentThread();
+        if (QCoreApplication::instance() && t == QCoreApplication::instance()->thread())
+            name = "Main";
+        else if (t && !t->objectName().isEmpty())
+            name = t->objectName();
+        else
+            name = "Thread";
+
+        QMutexLocker locker(&mutex);
+
+        // reuse the buffer of a thread which ended
+        Buffer *buffer = 0;
+        foreach (Buffer *b, buffers) {
+            if (!b->alive) {
+                buffer = b;
+                break;
+            }
+        }
+        if (!buffer) {
+            buffer = new Buffer;
+            Q_CHECK_PTR(buffer);
+            buffers.append(buffer);
+        }
+
+        buffer->count.fetchAndStoreRelease(0);
+        buffer->tid = ++lastTid;
+        buffer->thread = name;
+        buffer->alive = true;
+        local.buffer = buffer;
+    }
+
+    return local.buffer;
+}
+
+void Tracer::releaseBuffer(Buffer *b)
+{
+    QMutexLocker locker(&mutex);
+
+    // keep the events for export until another thread takes the buffer
+    b->alive = false;
+
+    // nobody will free it after the tracer is deleted
+    if (!_instance) {
+        buffers.removeOne(b);
+        delete b;
+    }
+}
+
+void Tracer::record(const char *name, qint64 begin, qint64 end)
+{
+    Buffer *b = threadBuffer();
+
+    // write the event before making it visible
+    unsigned int c = (unsigned int) (int) b->count;
+    Event &e = b->events[c % TRACE_BUFFER_SIZE];
+    e.name = name;
+    e.begin = begin;
+    e.end = end;
+    b->count.fetchAndStoreRelease( (int) (c + 1) );
+}
+
+bool Tracer::exportJson(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << filename << QChar(124).toLatin1() << QObject::tr("Cannot write trace.");
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GLMixer\"}}";
+
+    int total = 0;
+    foreach (Buffer *b, buffers) {
+
+        QString thread = b->thread;
+        thread.replace("\\", "\\\\").replace("\"", "\\\"");
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+            << ",\"args\":{\"name\":\"" << thread << "\"}}";
+
+        // copy the events while the thread may be writing
+        unsigned int last = (unsigned int) b->count.fetchAndAddAcquire(0);
+        unsigned int first = last > TRACE_BUFFER_SIZE ? last - TRACE_BUFFER_SIZE : 0;
+        QVector<Event> events;
+        events.reserve(last - first);
+        for (unsigned int i = first; i != last; ++i)
+            events.append(b->events[i % TRACE_BUFFER_SIZE]);
+
+        // ignore the events overwritten during the copy
+        unsigned int now = (unsigned int) b->count.fetchAndAddAcquire(0);
+        // (the event at index 'now' is possibly being written)
+        unsigned int overwritten = 0;
+        if (now - first >= TRACE_BUFFER_SIZE)
+            overwritten = now - first - TRACE_BUFFER_SIZE + 1;
+
+        for (int i = (int) qMin(overwritten, (unsigned int) events.size()); i < events.size(); ++i) {
+            const Event &e = events[i];
+            out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                << ",\"ts\":" << QString::number((double) e.begin / 1000.0, 'f', 3)
+                << ",\"dur\":" << QString::number((double) (e.end - e.begin) / 1000.0, 'f', 3) << "}";
+            ++total;
+        }
+    }
+
+    out << "\n]}\n";
+    file.close();
+
+    qDebug() << filename << QChar(124).toLatin1() << QObject::tr("Trace of %1 events in %2 threads exported.").arg(total).arg(buffers.size());
+
+    return true;
+}
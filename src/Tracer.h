@@ -0,0 +1,139 @@
+/*
+ * Tracer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: bh
+ *
+ *  This file is part of GLMixer.
+ *
+ *   GLMixer is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   GLMixer is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with GLMixer.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Copyright 2009, 2012 Bruno Herbelin
+ *
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QMutex>
+#include <QList>
+#include <QString>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+/**
+ * Number of events kept for each thread (the oldest are overwritten)
+ */
+#define TRACE_BUFFER_SIZE 16384
+
+/**
+ * Timeline of the events of all threads.
+ *
+ * Each thread records its events in its own buffer, without lock;
+ * only the first event of a thread registers its buffer. The events
+ * are recorded only when the tracer is enabled (a test of a flag otherwise).
+ *
+ * The buffers are not owned by the instance: a thread keeps its buffer
+ * until it ends, then the buffer is given to the next thread registered.
+ *
+ * The timeline is exported in the Chrome trace event format (JSON),
+ * which can be opened with Perfetto (ui.perfetto.dev) or chrome://tracing.
+ */
+class Tracer {
+
+    friend class TraceScope;
+    friend class ThreadBuffer;
+
+public:
+    static Tracer *getInstance();
+    static void deleteInstance();
+
+    static inline bool isEnabled() { return enabled; }
+    void setEnabled(bool on);
+
+    // events of all threads (complete events in microseconds)
+    bool exportJson(const QString &filename);
+
+private:
+    Tracer();
+    ~Tracer();
+    static Tracer *_instance;
+    static volatile bool enabled;
+
+    typedef struct {
+        const char *name;
+        qint64 begin, end;
+    } Event;
+
+    typedef struct {
+        Event events[TRACE_BUFFER_SIZE];
+        // number of events written (only the thread writes)
+        QAtomicInt count;
+        int tid;
+        QString thread;
+        // false once the thread ended (buffer free for another thread)
+        bool alive;
+    } Buffer;
+
+    // buffer of the calling thread (registered on first call)
+    static Buffer *threadBuffer();
+    // called when the thread owning the buffer ends
+    static void releaseBuffer(Buffer *b);
+    static void record(const char *name, qint64 begin, qint64 end);
+    static inline qint64 now() { return _instance ? _instance->clock.nsecsElapsed() : 0; }
+
+    QElapsedTimer clock;
+
+    // buffers of all threads (protected by the mutex)
+    static QMutex mutex;
+    static QList<Buffer *> buffers;
+    static int lastTid;
+};
+
+/**
+ * Event lasting for the scope of the object.
+ *
+ * The name must be a string constant (only the pointer is recorded).
+ */
+class TraceScope {
+
+public:
+    inline TraceScope(const char *name) : _name(Tracer::isEnabled() ? name : 0), _begin(0) {
+        if (_name)
+            _begin = Tracer::now();
+    }
+    inline ~TraceScope() {
+        if (_name && Tracer::isEnabled())
+            Tracer::record(_name, _begin, Tracer::now());
+    }
+
+private:
+    const char *_name;
+    qint64 _begin;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/**
+ * Trace the current scope, e.g. TRACE_SCOPE("paintGL");
+ */
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(_trace_scope_, __LINE__)(name)
+
+/**
+ * Trace the time of a statement, e.g. TRACE_WAIT("wait mutex", mutex->lock());
+ */
+#define TRACE_WAIT(name, statement) { TRACE_SCOPE(name); statement; }
+
+#endif // TRACER_H
@@ -30,7 +30,9 @@
 #include "Source.h"
 #include "OutputRenderWindow.h"
 #include "VideoFile.h"
+#include "RenderingManager.h"
 #include "RenderingEncoder.h"
+#include "ReplayBuffer.h"
 #include "CodecManager.h"
 
 #include <QFileDialog>
@@ -50,6 +52,7 @@ UserPreferencesDialog::UserPreferencesDialog(QWidget *parent): QDialog(parent)
     // the rendering option for BLIT of frame buffer makes no sense if the computer does not supports it
     disableBlitFrameBuffer->setEnabled( glewIsSupported("GL_EXT_framebuffer_blit GL_EXT_framebuffer_multisample") );
     disablePixelBufferObject->setEnabled( glewIsSupported("GL_ARB_pixel_buffer_object") );
+    dynamicResolution->setEnabled( glewIsSupported("GL_ARB_timer_query") );
 
     // add a validator for folder selection in recording preference
     recordingFolderLine->setValidator(new folderValidator(this));
@@ -68,6 +71,10 @@ UserPreferencesDialog::UserPreferencesDialog(QWidget *parent): QDialog(parent)
     sharedMemoryBox->setVisible(false);
 #endif
 
+    // same list of formats for the additional recording output
+    for (int i = 0; i < recordingFormatSelection->count(); ++i)
+        additionalOutputFormat->addItem(recordingFormatSelection->itemText(i));
+
     // fill in list of modes of update intervals
     updateIntervalModes.append(16);
     updateIntervalModes.append(20);
@@ -166,6 +173,7 @@ void UserPreferencesDialog::restoreDefaultPreferences() {
         disableFiltering->setChecked(false);
         disableBlitFrameBuffer->setChecked(!GLEW_EXT_framebuffer_blit);
         disablePixelBufferObject->setChecked(!GLEW_EXT_pixel_buffer_object);
+        dynamicResolution->setChecked(false);
         disableHWCodec->setChecked(false);
     }
 
@@ -182,6 +190,13 @@ void UserPreferencesDialog::restoreDefaultPreferences() {
         sharedMemoryColorDepth->setCurrentIndex(0);
         recordingBufferSize->setValue(10);
         outputFadingDuration->setValue(500);
+        replayDuration->setValue(DEFAULT_REPLAY_DURATION);
+        additionalOutputBox->setChecked(false);
+        additionalOutputFormat->setCurrentIndex(0);
+        additionalOutputQuality->setCurrentIndex(0);
+        additionalOutputScale->setCurrentIndex(2);
+        streamingUrl->setText(DEFAULT_STREAMING_URL);
+        streamingLatency->setValue(DEFAULT_STREAMING_LATENCY);
     }
 
     if (stackedPreferences->currentWidget() == PageSources) {
@@ -220,6 +235,7 @@ void UserPreferencesDialog::restoreDefaultPreferences() {
         snapTool->setChecked(false);
         allowOneInstance->setChecked(true);
         useCustomTimer->setChecked(false);
+        useFramePacing->setChecked(true);
     }
 }
 
@@ -285,6 +301,7 @@ void UserPreferencesDialog::showPreferences(const QByteArray & state){
     uint rtfr = 40;
     stream >> rtfr;
     recordingFramerateMode->setValue( getModeFromRecordingUpdateInterval(rtfr) );
+    updateEncoderPerformance();
 
     // h. recording folder
     bool automaticSave = false;
@@ -409,6 +426,47 @@ void UserPreferencesDialog::showPreferences(const QByteArray & state){
     int duration = 500;
     stream >> duration;
     outputFadingDuration->setValue(duration);
+
+    // (the following sections are missing in the preferences saved by
+    // previous versions : keep the defaults when the stream ends)
+
+    // ad. Instant replay duration
+    int replayduration = DEFAULT_REPLAY_DURATION;
+    if (!stream.atEnd())
+        stream >> replayduration;
+    replayDuration->setValue(replayduration);
+
+    // ae. Additional recording output
+    bool addoutput = false;
+    uint addformat = 0, addquality = 0;
+    int addscale = 50;
+    if (!stream.atEnd())
+        stream >> addoutput >> addformat >> addquality >> addscale;
+    additionalOutputBox->setChecked(addoutput);
+    additionalOutputFormat->setCurrentIndex(addformat);
+    additionalOutputQuality->setCurrentIndex(addquality);
+    additionalOutputQuality->setEnabled(addformat < 5);
+    additionalOutputScale->setCurrentIndex( qBound(0, (100 - addscale) / 25, 3) );
+
+    // af. Network streaming
+    QString streamurl = DEFAULT_STREAMING_URL;
+    int streamlatency = DEFAULT_STREAMING_LATENCY;
+    if (!stream.atEnd())
+        stream >> streamurl >> streamlatency;
+    streamingUrl->setText(streamurl);
+    streamingLatency->setValue(streamlatency);
+
+    // ag. Frame pacing
+    bool framepacing = true;
+    if (!stream.atEnd())
+        stream >> framepacing;
+    useFramePacing->setChecked(framepacing);
+
+    // ah. Dynamic resolution
+    bool dynamicresolution = false;
+    if (!stream.atEnd())
+        stream >> dynamicresolution;
+    dynamicResolution->setChecked(dynamicresolution);
 }
 
 QByteArray UserPreferencesDialog::getUserPreferences() const {
@@ -513,6 +571,25 @@ QByteArray UserPreferencesDialog::getUserPreferences() const {
     // ac. Output fading duration
     stream << outputFadingDuration->value();
 
+    // ad. Instant replay duration
+    stream << replayDuration->value();
+
+    // ae. Additional recording output
+    stream << additionalOutputBox->isChecked();
+    stream << (uint) additionalOutputFormat->currentIndex();
+    stream << (uint) additionalOutputQuality->currentIndex();
+    stream << 100 - 25 * additionalOutputScale->currentIndex();
+
+    // af. Network streaming
+    stream << streamingUrl->text();
+    stream << streamingLatency->value();
+
+    // ag. Frame pacing
+    stream << useFramePacing->isChecked();
+
+    // ah. Dynamic resolution
+    stream << dynamicResolution->isChecked();
+
     return data;
 }
 
@@ -526,6 +603,11 @@ void UserPreferencesDialog::on_updatePeriod_valueChanged(int period)
 }
 
 
+void UserPreferencesDialog::on_additionalOutputFormat_currentIndexChanged(int i)
+{
+    additionalOutputQuality->setEnabled(i < 5);
+}
+
 void UserPreferencesDialog::on_recordingFormatSelection_currentIndexChanged(int i)
 {
     recordingQualitySelection->setEnabled(i < 5);
@@ -536,6 +618,30 @@ void UserPreferencesDialog::on_recordingFramerateMode_valueChanged(int mode)
     int interval = getRecordingUpdateIntervalFromMode(mode);
     double fps = qBound(1.0, 1000.0 / double(interval), 60.0);
     recordingFrameRateString->setText(QString("%1 fps").arg(qRound(fps)) );
+    updateEncoderPerformance();
+}
+
+// Show the performance of encoders measured on this computer
+// and highlight the formats too slow for the recording frame rate
+void UserPreferencesDialog::updateEncoderPerformance()
+{
+    int interval = getRecordingUpdateIntervalFromMode(recordingFramerateMode->value());
+    double fps = qBound(1.0, 1000.0 / double(interval), 60.0);
+
+    for (int i = 0; i < recordingFormatSelection->count(); ++i) {
+        double measured = RenderingManager::getRecorder()->encoderFramerate((encodingformat) i);
+        if (measured < 0.0) {
+            recordingFormatSelection->setItemData(i, QVariant(), Qt::ToolTipRole);
+            recordingFormatSelection->setItemData(i, QVariant(), Qt::ForegroundRole);
+        }
+        else {
+            recordingFormatSelection->setItemData(i, tr("Measured %1 fps on this computer").arg(qRound(measured)), Qt::ToolTipRole);
+            if (measured < BENCHMARK_REALTIME_FACTOR * fps)
+                recordingFormatSelection->setItemData(i, QColor(Qt::red), Qt::ForegroundRole);
+            else
+                recordingFormatSelection->setItemData(i, QVariant(), Qt::ForegroundRole);
+        }
+    }
 }
 
 
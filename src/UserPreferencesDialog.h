@@ -56,6 +56,7 @@ public slots:
     // GUI actions
     void on_updatePeriod_valueChanged(int period);
     void on_recordingFormatSelection_currentIndexChanged(int i);
+    void on_additionalOutputFormat_currentIndexChanged(int i);
     void on_recordingFramerateMode_valueChanged(int mode);
     void on_recordingBufferSize_valueChanged(int percent);
     void on_recordingFolderButton_clicked();
@@ -70,6 +71,7 @@ public slots:
 protected:
 
     uint getRecordingUpdateIntervalFromMode(int m) const;
+    void updateEncoderPerformance();
     int getModeFromRecordingUpdateInterval(uint u) const;
 
     void showEvent(QShowEvent *);
@@ -40,6 +40,7 @@ extern "C"
 #include "VideoFile.moc"
 
 #include "CodecManager.h"
+#include "Tracer.h"
 
 #include <QtGui/QButtonGroup>
 #include <QtGui/QDialog>
@@ -146,6 +147,8 @@ class DecodingThread: public videoFileThread
 public:
     DecodingThread(VideoFile *video) : videoFileThread(video)
     {
+        setObjectName("DecodingThread");
+
         // allocate a frame to fill
         _pFrame = av_frame_alloc();
         Q_CHECK_PTR(_pFrame);
@@ -186,6 +189,8 @@ VideoFile::VideoFile(QObject *parent, bool generatePowerOfTwo,
     firstPicture = NULL;
     blackPicture = NULL;
     pictq_max_count = 0;
+    decoded_frame_count = 0;
+    dropped_frame_count = 0;
     duration = 0.0;
     frame_rate = 0.0;
     frame_period = 0.0;
@@ -225,6 +230,7 @@ VideoFile::VideoFile(QObject *parent, bool generatePowerOfTwo,
     stop_to_black = false;          // by default do not stop to black
     ignoreAlpha = false;            // by default do not ignore alpha channel
     hasHwCodec = false;             // by default do not use hardware codec
+    frame_pacing = false;           // by default frames are shown by the timer
 
 #if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(58,0,0)
     pHardwareCodec = NULL;
@@ -420,7 +426,8 @@ void VideoFile::start()
         parsing_mode = VideoFile::SEEKING_PARSING;
 
         // start timer and decoding threads
-        ptimer->start();
+        if (!frame_pacing)
+            ptimer->start();
         decod_tid->start();
 
 #ifdef VIDEOFILE_DEBUG
@@ -951,8 +958,12 @@ void VideoFile::video_refresh_timer()
     // empty pointers
     VideoPicture *currentvp = NULL, *nextvp = NULL;
 
+    TRACE_SCOPE("video_refresh_timer");
+
     // lock the thread to operate on the queue
-    if ( pictq_mutex->tryLock(LOCKING_TIMEOUT) )
+    bool locked = false;
+    TRACE_WAIT("wait pictq_mutex", locked = pictq_mutex->tryLock(LOCKING_TIMEOUT));
+    if ( locked )
     {
 
         // if all is in order, deal with the picture in the queue
@@ -1056,6 +1067,7 @@ void VideoFile::video_refresh_timer()
         else {
             // delete the picture
             delete currentvp;
+            dropped_frame_count++;
         }
 
         if (fast_forward) {
@@ -1069,12 +1081,107 @@ void VideoFile::video_refresh_timer()
     if (quit_after_frame)
         stop();
     // normal behavior : restart the ptimer for next frame
-    else
+    else if (!frame_pacing)
         ptimer->start( ptimer_delay );
 
 //        fprintf(stderr, "video_refresh_timer update in %d \n", ptimer_delay);
 }
 
+void VideoFile::setFramePacing(bool on)
+{
+    frame_pacing = on;
+
+    // the timer is replaced by calls to present()
+    if (frame_pacing)
+        ptimer->stop();
+    else if (!quit)
+        ptimer->start();
+}
+
+void VideoFile::present(double delay)
+{
+    if (quit || !frame_pacing)
+        return;
+
+    TRACE_SCOPE("present");
+
+    // deal with speed change before choosing the frame
+    pclock->applyRequestedSpeed();
+
+    // time of the video when the display will be refreshed
+    double presentation_time = pclock->time() + delay * pclock->speed();
+
+    bool quit_after_frame = false;
+    VideoPicture *currentvp = NULL;
+
+    // lock the thread to operate on the queue
+    bool locked = false;
+    TRACE_WAIT("wait pictq_mutex", locked = pictq_mutex->tryLock(LOCKING_TIMEOUT));
+    if ( locked )
+    {
+        // take the most recent picture due at presentation time
+        // NB: if paused, only the pictures tagged for ACTION_RESET_PTS
+        while ( video_st && !pictq.empty() ) {
+
+            VideoPicture *vp = pictq.head();
+            bool seeking = vp->hasAction(VideoPicture::ACTION_RESET_PTS);
+
+            if ( !seeking && ( pclock->paused() || (!fast_forward && vp->getPts() > presentation_time) ) )
+                break;
+
+            // skip the previous picture
+            if (currentvp) {
+                delete currentvp;
+                dropped_frame_count++;
+            }
+            currentvp = pictq.dequeue();
+
+            // show the stopping frame, the seeking frame (before the clock is reset)
+            // or one frame at each refresh in fast forward
+            if ( seeking || fast_forward || currentvp->hasAction(VideoPicture::ACTION_STOP) )
+                break;
+        }
+
+        // unblock the queue for the decoding thread
+        pictq_cond->wakeAll();
+
+        // release lock
+        pictq_mutex->unlock();
+    }
+
+    if (!currentvp)
+        return;
+
+    // store time of this current frame
+    current_frame_pts = currentvp->getPts();
+
+    // request to stop the video after this frame
+    if ( currentvp->hasAction(VideoPicture::ACTION_STOP) )
+        quit_after_frame = true;
+
+    // reset clock to the time of the seeking frame
+    if ( currentvp->hasAction(VideoPicture::ACTION_RESET_PTS) ) {
+        pclock->reset(current_frame_pts);
+        emit seekEnabled(true);
+    }
+
+    // ask to show the current picture (and to delete it when done)
+    if ( currentvp->hasAction(VideoPicture::ACTION_SHOW) ) {
+        currentvp->addAction(VideoPicture::ACTION_DELETE);
+        emit frameReady(currentvp);
+        emit timeChanged(current_frame_pts);
+    }
+    else
+        delete currentvp;
+
+    if (fast_forward)
+        pclock->reset(current_frame_pts);
+
+    // quit if requested
+    if (quit_after_frame)
+        stop();
+}
+
 double VideoFile::getCurrentFrameTime() const
 {
     return current_frame_pts;
@@ -1198,7 +1305,7 @@ void VideoFile::clean_until_time_picture_queue(double time) {
         time = getEnd();
 
     // get hold on the picture queue
-    pictq_mutex->lock();
+    TRACE_WAIT("wait pictq_mutex", pictq_mutex->lock());
 
     // loop to find a mark frame in the queue
     int i =  0;
@@ -1391,9 +1498,16 @@ void VideoFile::clear_picture_queue() {
     }
 }
 
+int VideoFile::getPictureQueueCount() const
+{
+    QMutexLocker locker(pictq_mutex);
+
+    return pictq.count();
+}
+
 void VideoFile::flush_picture_queue()
 {
-    pictq_mutex->lock();
+    TRACE_WAIT("wait pictq_mutex", pictq_mutex->lock());
     clear_picture_queue();
     pictq_cond->wakeAll();
     pictq_mutex->unlock();
@@ -1405,7 +1519,7 @@ void VideoFile::requestSeek(double time, bool lock)
     if ( parsing_mode != VideoFile::SEEKING_PARSING )
     {
 
-        seek_mutex->lock();
+        TRACE_WAIT("wait seek_mutex", seek_mutex->lock());
         seek_pos = time;
         video_pts = 0.0;
 
@@ -1433,7 +1547,7 @@ bool VideoFile::jump_in_picture_queue(double time)
     // now for sure the seek time is in the queue
     // get hold on the picture queue
 
-    pictq_mutex->lock();
+    TRACE_WAIT("wait pictq_mutex", pictq_mutex->lock());
 
     // does the queue loop ?
     bool loopingbuffer = pictq.first()->getPts() > pictq.last()->getPts();
@@ -1469,6 +1583,8 @@ void VideoFile::queue_picture(AVFrame *pFrame, double pts, VideoPicture::Action
 {
     VideoPicture *vp = NULL;
 
+    TRACE_SCOPE("queue_picture");
+
     try {
         // convert given frame
         if ( pFrame && av_buffersrc_add_frame_flags(in_video_filter, pFrame, AV_BUFFERSRC_FLAG_KEEP_REF) >= 0 ) {
@@ -1492,9 +1608,10 @@ void VideoFile::queue_picture(AVFrame *pFrame, double pts, VideoPicture::Action
         vp->addAction(a);
 
         /* now we inform our display thread that we have a pic ready */
-        pictq_mutex->lock();
+        TRACE_WAIT("wait pictq_mutex", pictq_mutex->lock());
         // enqueue this picture in the queue
         pictq.enqueue(vp);
+        decoded_frame_count++;
         // inform about the new size of the queue
         pictq_mutex->unlock();
 
@@ -1553,7 +1670,7 @@ void DecodingThread::run()
 
         // seek stuff goes here
         int64_t seek_target = AV_NOPTS_VALUE;
-        is->seek_mutex->lock();
+        TRACE_WAIT("wait seek_mutex", is->seek_mutex->lock());
         if (is->parsing_mode == VideoFile::SEEKING_PARSING) {
             // compute dts of seek target from seek position
             seek_target = av_rescale_q(is->seek_pos, (AVRational){1, 1}, is->video_st->time_base);
@@ -1587,7 +1704,8 @@ void DecodingThread::run()
 
 
         // Read packet
-        int ret = av_read_frame(is->pFormatCtx, pkt);
+        int ret = 0;
+        TRACE_WAIT("read packet", ret = av_read_frame(is->pFormatCtx, pkt));
         if ( ret < 0 )
         {
             // not an error : read_frame have reached the end of file
@@ -1622,7 +1740,9 @@ void DecodingThread::run()
         if ( pkt->stream_index == is->videoStream ) {
 
             // send the packet to the decoder
-            if ( avcodec_send_packet(is->video_dec, pkt) < 0 ) {
+            int sent = 0;
+            TRACE_WAIT("send packet", sent = avcodec_send_packet(is->video_dec, pkt));
+            if ( sent < 0 ) {
 #ifdef VIDEOFILE_DEBUG
                 fprintf(stderr, "\n%s - Could not send packet.", qPrintable(is->filename));
 #endif
@@ -1635,7 +1755,7 @@ void DecodingThread::run()
             while (frameFinished >= 0) {
 
                 // get the packet from the decoder
-                frameFinished = avcodec_receive_frame(is->video_dec, _pFrame);
+                TRACE_WAIT("decode frame", frameFinished = avcodec_receive_frame(is->video_dec, _pFrame));
 
                 // no error, just try again
                 if ( frameFinished == AVERROR(EAGAIN) ) {
@@ -1732,7 +1852,7 @@ void DecodingThread::run()
                         actionFrame |= VideoPicture::ACTION_RESET_PTS;
 
                         // reached the seeked frame! : can say we are not seeking anymore
-                        is->seek_mutex->lock();
+                        TRACE_WAIT("wait seek_mutex", is->seek_mutex->lock());
                         is->parsing_mode = VideoFile::SEEKING_NONE;
                         is->seek_mutex->unlock();
 
@@ -1751,10 +1871,13 @@ void DecodingThread::run()
                     // wait until we have space for a new pic
                     // to add a picture in the queue
                     // (the condition is released in video_refresh_timer() )
-                    is->pictq_mutex->lock();
-                    while ( !is->quit && (is->pictq.count() > is->pictq_max_count) )
-                        is->pictq_cond->wait(is->pictq_mutex);
-                    is->pictq_mutex->unlock();
+                    {
+                        TRACE_SCOPE("wait pictq space");
+                        TRACE_WAIT("wait pictq_mutex", is->pictq_mutex->lock());
+                        while ( !is->quit && (is->pictq.count() > is->pictq_max_count) )
+                            is->pictq_cond->wait(is->pictq_mutex);
+                        is->pictq_mutex->unlock();
+                    }
 
                     // ignore frame if seek has been asked while waiting
                     // (appens when user asks for seek)
@@ -375,6 +375,21 @@ public:
      */
     void setFastForward(bool on) { fast_forward = on; }
 
+    /**
+     * Frame pacing : instead of the internal timer, the frames are chosen by
+     * calls to present() with the delay until the next display.
+     */
+    inline bool framePacing() const { return frame_pacing; }
+
+    /**
+     * Statistics of decoding : number of pictures in the queue (and its maximum),
+     * total count of frames decoded and of frames dropped instead of being shown.
+     */
+    int getPictureQueueCount() const;
+    inline int getPictureQueueSize() const { return pictq_max_count; }
+    inline int getDecodedFrameCount() const { return decoded_frame_count; }
+    inline int getDroppedFrameCount() const { return dropped_frame_count; }
+
     /**
      * Sets the memory usage policy to define the bounding size of internal
      * buffers (both packet queue and video picture queue) used for decoding.
@@ -493,6 +508,20 @@ public slots:
 
 
     void pause(bool pause, PauseMode mode = PAUSE_INSTANTANEOUS, int duration = 0);
+    /**
+     * Activates the frame pacing (see present()).
+     * The internal timer is stopped when frame pacing is on.
+     */
+    void setFramePacing(bool on);
+    /**
+     * Shows the most recent picture of the queue due when the display will
+     * be refreshed, skipping the previous ones (only in frame pacing mode).
+     *
+     * Emits a frameReady signal if a new picture is due.
+     *
+     * @param delay Time until the next refresh of the display, in second.
+     */
+    void present(double delay);
     /**
      *  Set the IN mark to the movie first frame.
      */
@@ -742,7 +771,7 @@ protected:
     double  fade_in;
     double  fade_out;
     double  mark_stop;
-    bool fast_forward, first_picture_changed;
+    bool fast_forward, first_picture_changed, frame_pacing;
 
     // time management
     double video_pts;
@@ -754,6 +783,7 @@ protected:
 
     // picture queue management
     int pictq_max_count;
+    int decoded_frame_count, dropped_frame_count;
     QQueue<VideoPicture*> pictq;
     QMutex *pictq_mutex;
     QWaitCondition *pictq_cond;
@@ -197,6 +197,7 @@ private:
         bool isEmpty();
         bool isFull();
         int getPageSize() { return _pageSize; }
+        static long int getTotalMemory() { return _totalmemory; }
     };
     PictureMap *_pictureMap;
 
@@ -208,6 +209,8 @@ private:
 public:
     static void clearPictureMaps();
     static int count;
+    // bytes allocated by all picture maps
+    static long int getPictureMapsMemory() { return PictureMap::getTotalMemory(); }
 
 };
 
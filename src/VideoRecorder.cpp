@@ -14,6 +14,9 @@ extern "C"
 #include <thread>
 
 #include "VideoRecorder.h"
+#include "ReplayBuffer.h"
+#include "DiskWriter.h"
+#include "common.h"
 #include "CodecManager.h"
 
 // HOWTO avconv command
@@ -79,6 +82,67 @@ VideoRecorder *VideoRecorder::getRecorder(encodingformat f, QString filename, in
     return rec;
 }
 
+// short names of the codecs, in the order of encodingformat
+static const char *codecShortNames[] = { "h264", "hevc", "webm", "prores", "mpeg4", "mpeg2",
+                                         "mpeg1", "wmv2", "flv1", "ffv3", "raw" };
+
+QStringList VideoRecorder::getCodecNames()
+{
+    QStringList names;
+    for (int f = FORMAT_MP4_H264; f <= FORMAT_AVI_RAW; ++f)
+        names << codecShortNames[f];
+    return names;
+}
+
+int VideoRecorder::getFormatFromCodecName(QString name)
+{
+    return getCodecNames().indexOf(name.toLower());
+}
+
+void VideoRecorder::recordTestClip(encodingformat f, QString filename, int w, int h, int fps, int frames)
+{
+    AVFrame *testframe = av_frame_alloc();
+    testframe->format = AV_PIX_FMT_RGB24;
+    testframe->width  = w;
+    testframe->height = h;
+    av_frame_get_buffer(testframe, 32);
+
+    VideoRecorder *rec = NULL;
+    try {
+        rec = getRecorder(f, filename, w, h, fps, QUALITY_MEDIUM);
+        rec->open();
+
+        // moving gradients with noise (motion and details to encode)
+        unsigned int seed = 1;
+        for (int k = 0; k < frames; ++k) {
+            av_frame_make_writable(testframe);
+            for (int y = 0; y < h; ++y) {
+                uint8_t *line = testframe->data[0] + y * testframe->linesize[0];
+                for (int x = 0; x < w; ++x) {
+                    seed = seed * 1103515245 + 12345;
+                    line[3*x]     = (uint8_t) ( (x + k * 16) * 255 / w );
+                    line[3*x + 1] = (uint8_t) ( (y + k * 8) * 255 / h );
+                    line[3*x + 2] = (uint8_t) ( (seed >> 16) & 0x3F );
+                }
+            }
+            rec->addFrame(testframe);
+        }
+        // frames delayed by the encoder
+        while ( rec->addFrame(NULL) );
+
+        rec->close();
+    }
+    catch (VideoRecorderException &e){
+        if (rec)
+            delete rec;
+        av_frame_free(&testframe);
+        throw;
+    }
+
+    delete rec;
+    av_frame_free(&testframe);
+}
+
 VideoRecorder::VideoRecorder(QString filename, int w, int h, int fps) : fileName(filename), frameRate(fps), framenum(0)
 {
     /* resolution must be a multiple of two */
@@ -94,7 +158,12 @@ VideoRecorder::VideoRecorder(QString filename, int w, int h, int fps) : fileName
     in_video_filter = NULL;
     out_video_filter = NULL;
     graph = NULL;
+    filter_width = 0;
+    filter_height = 0;
     opts = NULL;
+    replay = NULL;
+    asynchronousWriting = false;
+    writer = NULL;
 
 }
 
@@ -118,6 +187,11 @@ VideoRecorder::~VideoRecorder()
         av_frame_free(&frame);
     }
 
+#ifdef Q_OS_UNIX
+    if (writer)
+        delete writer;
+#endif
+
     qDebug() << "VideoRecorder" << QChar(124).toLatin1() << "cleared.";
 }
 
@@ -294,6 +368,84 @@ VideoRecorderH264::VideoRecorderH264(QString filename, int w, int h, int fps, en
 }
 
 
+VideoRecorderStream::VideoRecorderStream(QString url, int w, int h, int fps, encodingquality quality) : VideoRecorder(url, w, h, fps)
+{
+    // specifics for this recorder
+    suffix = "ts";
+    description = "MPEG Transport Stream";
+
+    // bit rate in kbit/s for 1080p at 30fps, scaled to resolution and frame rate
+    int64_t br = 4500;
+    switch (quality) {
+    case QUALITY_LOW:
+        br = 2500;
+        break;
+    case QUALITY_MEDIUM:
+        br = 6000;
+        break;
+    case QUALITY_HIGH:
+        br = 9000;
+        break;
+    case QUALITY_AUTO:
+        break;
+    }
+    br = FFMAX( (br * 1000 * width * height * fps) / (1920 * 1080 * 30), 500000);
+
+    // allocate context
+    // (rtp needs the rtp_mpegts muxer, other protocols take the mpegts packets)
+    QStringList codeclist;
+    if (CodecManager::useHardwareAcceleration() ) {
+#ifdef Q_OS_MAC
+        codeclist << "h264_videotoolbox";
+#else
+        codeclist << "h264_nvenc";
+#endif
+    }
+    codeclist << "libx264";
+    setupContext(codeclist, url.startsWith("rtp://", Qt::CaseInsensitive) ? "rtp_mpegts" : "mpegts", AV_PIX_FMT_YUV420P);
+
+    // low latency : no B frames and a key frame every half second
+    // so that a receiver can join quickly
+    codec_context->max_b_frames = 0;
+    codec_context->gop_size = FFMAX(1, fps / 2);
+    codec_context->profile = FF_PROFILE_H264_MAIN;
+
+    // constant bit rate, with a buffer of one frame
+    codec_context->bit_rate = br;
+    codec_context->rc_max_rate = br;
+    codec_context->rc_buffer_size = (int) (br / fps);
+
+    if ((strcmp(codec->name, "libx264") == 0)) {
+        av_dict_set(&opts, "preset", "ultrafast", 0);
+        av_dict_set(&opts, "tune", "zerolatency", 0);
+        // repeat SPS/PPS with every key frame
+        av_dict_set(&opts, "x264-params", "repeat-headers=1:nal-hrd=cbr", 0);
+    }
+    else if ((strcmp(codec->name, "h264_nvenc") == 0)) {
+        av_dict_set(&opts, "preset", "llhq", 0); // low latency high quality
+        av_dict_set(&opts, "zerolatency", "1", 0);
+        av_dict_set(&opts, "rc", "cbr", 0);
+    }
+    else if ((strcmp(codec->name, "h264_videotoolbox") == 0))
+        av_dict_set(&opts, "realtime", "1", 0);
+
+    // send packets immediately
+    format_context->flags |= AVFMT_FLAG_FLUSH_PACKETS;
+    format_context->max_delay = 0;
+
+    // OPTIONNAL
+    codec_context->thread_count = FFMIN(8, std::thread::hardware_concurrency());
+
+    setupFiltering();
+
+    char *buffer = NULL;
+    av_dict_get_string(opts, &buffer, '=', ',');
+
+    qDebug() << url << QChar(124).toLatin1() << "Encoder" << avcodec_descriptor_get(codec_context->codec_id)->long_name << " ( "<< QString(codec->name)  << buffer << codec_context->bit_rate / 1024 << "kbit/s )";
+
+    av_freep(&buffer);
+}
+
 VideoRecorderHEVC::VideoRecorderHEVC(QString filename, int w, int h, int fps, encodingquality quality) : VideoRecorder(filename, w, h, fps)
 {
     // specifics for this recorder
@@ -399,6 +551,9 @@ VideoRecorderFFV::VideoRecorderFFV(QString filename, int w, int h, int fps) : Vi
     av_dict_set(&opts, "threads", "6", 0);
     av_dict_set(&opts, "g", "6", 0);
 
+    // very high data rate : bypass the page cache
+    asynchronousWriting = true;
+
     setupFiltering();
 
     qDebug() << filename << QChar(124).toLatin1() << "Encoder" << avcodec_descriptor_get(codec_context->codec_id)->long_name ;
@@ -415,6 +570,9 @@ VideoRecorderRAW::VideoRecorderRAW(QString filename, int w, int h, int fps) : Vi
     codeclist << "rawvideo";
     setupContext(codeclist, "avi", AV_PIX_FMT_BGR24);
 
+    // very high data rate : bypass the page cache
+    asynchronousWriting = true;
+
     setupFiltering();
 
     qDebug() << filename << QChar(124).toLatin1() << "Encoder" << avcodec_descriptor_get(codec_context->codec_id)->long_name ;
@@ -678,7 +836,15 @@ bool VideoRecorder::addFrame(AVFrame *f)
 
     if (f != NULL ) {
 
-        // convert frame format & flip
+        // re-create the conversion filter if the frame size changed
+        if ( in_video_filter && (f->width != filter_width || f->height != filter_height) ) {
+            avfilter_graph_free(&graph);
+            in_video_filter = NULL;
+            out_video_filter = NULL;
+            setupFiltering(f->width, f->height);
+        }
+
+        // convert frame format, flip & scale
         if (in_video_filter) {
 
             retcd = av_buffersrc_add_frame_flags(in_video_filter, f, AV_BUFFERSRC_FLAG_KEEP_REF);
@@ -693,7 +859,8 @@ bool VideoRecorder::addFrame(AVFrame *f)
             av_frame_ref(frame, f);
 
         // set Presentation time Stamp as frame number
-        frame->pts = framenum;
+        // (unless given by the caller)
+        frame->pts = f->pts != AV_NOPTS_VALUE ? f->pts : framenum;
 
         // send frame to codec encoder
         retcd = avcodec_send_frame(codec_context, frame);
@@ -737,10 +904,15 @@ bool VideoRecorder::addFrame(AVFrame *f)
         pkt.pts = av_rescale_q_rnd(pkt.pts, codec_context->time_base, video_stream->time_base, AV_ROUND_NEAR_INF);
         pkt.duration = av_rescale_q(1, codec_context->time_base, video_stream->time_base);
 
-        // write frame
-        retcd = av_write_frame(format_context, &pkt);
-        if (retcd < 0)
-            VideoRecorderException(QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+        // keep packet in memory for instant replay
+        if (replay)
+            replay->push(&pkt);
+        // or write frame
+        else {
+            retcd = av_write_frame(format_context, &pkt);
+            if (retcd < 0)
+                VideoRecorderException(QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+        }
 
         av_packet_unref(&pkt);
     }
@@ -769,17 +941,36 @@ void VideoRecorder::open()
     if (retcd < 0)
         VideoRecorderException(QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
 
-    // open file corresponding to the format context
-    retcd = avio_open(&format_context->pb, qPrintable(fileName), AVIO_FLAG_WRITE);
-    if (retcd < 0)
-        VideoRecorderException("File open " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+    framenum = 0;
+
+    // no file for instant replay : the replay buffer muxes on demand
+    if (replay) {
+        replay->setup(format_context->oformat, video_stream->codecpar, video_stream->time_base);
+        return;
+    }
+
+#ifdef Q_OS_UNIX
+    // write file from a separate thread
+    if (asynchronousWriting) {
+        writer = new DiskWriter();
+        Q_CHECK_PTR(writer);
+        writer->open(fileName);
+        format_context->pb = writer->getIOContext();
+        format_context->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+    else
+#endif
+    {
+        // open file corresponding to the format context
+        retcd = avio_open(&format_context->pb, qPrintable(fileName), AVIO_FLAG_WRITE);
+        if (retcd < 0)
+            VideoRecorderException("File open " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+    }
 
     // start recording
     retcd = avformat_write_header(format_context, NULL);
     if (retcd < 0)
         VideoRecorderException("Write header " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
-
-    framenum = 0;
 }
 
 int VideoRecorder::close()
@@ -790,19 +981,49 @@ int VideoRecorder::close()
     if (!format_context)
         VideoRecorderException("Cannot close recording without format context.").raise();
 
+    // nothing written in file for instant replay
+    if (replay)
+        return framenum;
+
     // end recording
     retcd = av_write_trailer(format_context);
     if (retcd < 0)
         VideoRecorderException("Write trailer " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
 
     // close file
-    retcd = avio_close(format_context->pb);
-    if (retcd < 0)
-        VideoRecorderException("File close " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+#ifdef Q_OS_UNIX
+    if (writer) {
+        avio_flush(format_context->pb);
+        format_context->pb = NULL;
+        writer->close();
+    }
+    else
+#endif
+    {
+        retcd = avio_close(format_context->pb);
+        if (retcd < 0)
+            VideoRecorderException("File close " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
+    }
 
     return framenum;
 }
 
+QString VideoRecorder::getWriterStatus()
+{
+#ifdef Q_OS_UNIX
+    if (writer)
+        return QString("Disk %1/s, stalled %2 ms").arg(getByteSizeString(writer->throughput())).arg(writer->stallTime());
+#endif
+
+    return QString();
+}
+
+void VideoRecorder::setGroupOfPictureSize(int gop)
+{
+    if (codec_context)
+        codec_context->gop_size = qMax(1, gop);
+}
+
 int VideoRecorder::estimateGroupOfPictureSize()
 {
     // see http://www2.acti.com/download_file/Product/support/DesignSpec_Note_GOP_20091120.pdf
@@ -874,11 +1095,16 @@ void VideoRecorder::setupContext(QStringList codecnames, QString formatname, AVP
         codec_context->flags     |= AV_CODEC_FLAG_GLOBAL_HEADER;
 }
 
-void VideoRecorder::setupFiltering()
+void VideoRecorder::setupFiltering(int inputwidth, int inputheight)
 {
     int retcd = 0;
     char errstr[128];
 
+    // by default, input frames have the size of the recording
+    filter_width = inputwidth > 0 ? inputwidth : width;
+    filter_height = inputheight > 0 ? inputheight : height;
+    bool scaling = (filter_width != width || filter_height != height);
+
     // create conversion context
     const AVFilter *buffersrc  = avfilter_get_by_name("buffer");
     const AVFilter *buffersink = avfilter_get_by_name("buffersink");
@@ -889,7 +1115,8 @@ void VideoRecorder::setupFiltering()
     if (!outputs || !inputs || !graph)
         VideoRecorderException("cannot allocate filtering graph.").raise();
 
-    int64_t conversionAlgorithm = SWS_POINT; // optimal speed scaling for videos
+    // optimal speed scaling for videos
+    int64_t conversionAlgorithm = scaling ? SWS_FAST_BILINEAR : SWS_POINT;
     char sws_flags_str[128];
     snprintf(sws_flags_str, sizeof(sws_flags_str), "flags=%d", (int) conversionAlgorithm);
     graph->scale_sws_opts = av_strdup(sws_flags_str);
@@ -898,7 +1125,7 @@ void VideoRecorder::setupFiltering()
     char buffersrc_args[256];
     snprintf(buffersrc_args, sizeof(buffersrc_args),
              "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=0/1",
-             width, height, AV_PIX_FMT_RGB24, video_stream->time_base.num, video_stream->time_base.den);
+             filter_width, filter_height, AV_PIX_FMT_RGB24, video_stream->time_base.num, video_stream->time_base.den);
 
     retcd = avfilter_graph_create_filter(&in_video_filter, buffersrc,
                                          "in", buffersrc_args, NULL, graph);
@@ -927,9 +1154,12 @@ void VideoRecorder::setupFiltering()
     outputs->pad_idx    = 0;
     outputs->next       = NULL;
 
-    // no scaling to target size is necessary
+    // flip, and scale to target size if necessary
     char filter_str[128];
-    snprintf(filter_str, sizeof(filter_str), "vflip");
+    if (scaling)
+        snprintf(filter_str, sizeof(filter_str), "vflip,scale=%d:%d:flags=fast_bilinear", width, height);
+    else
+        snprintf(filter_str, sizeof(filter_str), "vflip");
     retcd = avfilter_graph_parse_ptr(graph, filter_str, &inputs, &outputs, NULL);
     if (retcd < 0)
         VideoRecorderException("Add vflip " + QString(av_make_error_string(errstr, sizeof(errstr),retcd))).raise();
@@ -9,6 +9,7 @@ extern "C" {
 
 #include "defines.h"
 #include <QString>
+#include <QStringList>
 
 class VideoRecorderException : public AllocationException {
     QString text;
@@ -48,11 +49,20 @@ class VideoRecorder
 public:
 
     static VideoRecorder *getRecorder(encodingformat f, QString filename, int w, int h, int fps, encodingquality quality);
+
+    // Short names of the codecs of the formats (h264, hevc, webm, ...)
+    static QStringList getCodecNames();
+    // Format of a codec short name (-1 if unknown)
+    static int getFormatFromCodecName(QString name);
+    // Record a clip of synthetic frames (e.g. for benchmarks)
+    static void recordTestClip(encodingformat f, QString filename, int w, int h, int fps, int frames);
     virtual ~VideoRecorder();
 
     QString getFileSuffix() const { return suffix; }
     QString getFileDescription() const { return description; }
     int getFrameRate() const { return frameRate; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
     QString getFilename() const { return fileName; }
 
     // Open the encoder and file for recording
@@ -64,14 +74,28 @@ public:
     int close();
 
     // Record one frame
+    // (frames of a size different from the recording are rescaled)
     bool addFrame(AVFrame *frame);
 
+    // Send encoded packets to the replay buffer instead of a file
+    // (to be called before open)
+    void setReplayBuffer(class ReplayBuffer *r) { replay = r; }
+    // Change the maximum interval between key frames
+    // (to be called before open)
+    void setGroupOfPictureSize(int gop);
+
+    // Write the file from a separate thread (see DiskWriter)
+    // (to be called before open)
+    void setAsynchronousWriting(bool on) { asynchronousWriting = on; }
+    // Disk writing throughput and stall time (empty if not asynchronous)
+    QString getWriterStatus();
+
 protected:
     VideoRecorder(QString filename, int w, int h, int fps );
 
     int estimateGroupOfPictureSize();
     void setupContext(QStringList codecnames, QString formatname, enum AVPixelFormat pixelformat);
-    void setupFiltering();
+    void setupFiltering(int inputwidth = 0, int inputheight = 0);
 
     // properties
     QString fileName;
@@ -96,7 +120,14 @@ protected:
     AVFilterContext *in_video_filter;
     AVFilterContext *out_video_filter;
     AVFilterGraph *graph;
+    int filter_width, filter_height;
+
+    // instant replay
+    class ReplayBuffer *replay;
 
+    // asynchronous file writing
+    bool asynchronousWriting;
+    class DiskWriter *writer;
 };
 
 class VideoRecorderMP4 : public VideoRecorder
@@ -129,6 +160,13 @@ public:
     VideoRecorderProRes(QString filename, int w, int h, int fps, encodingquality quality);
 };
 
+class VideoRecorderStream : public VideoRecorder
+{
+public:
+    // Low latency H264 in MPEG-TS to a udp://, rtp:// or srt:// url
+    VideoRecorderStream(QString url, int w, int h, int fps, encodingquality quality);
+};
+
 class VideoRecorderMPEG1 : public VideoRecorder
 {
 public:
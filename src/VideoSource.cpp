@@ -26,6 +26,7 @@
 #include "VideoSource.moc"
 
 #include "RenderingManager.h"
+#include "glRenderWidget.h"
 
 #include <QGLFramebufferObject>
 
@@ -33,19 +34,27 @@ Source::RTTI VideoSource::type = Source::VIDEO_SOURCE;
 
 VideoSource::VideoSource(VideoFile *f, GLuint texture, double d) :
     Source(texture, d), format(GL_RGBA), is(f), vp(NULL),
-    internalFormat(AV_PIX_FMT_RGB24), imgsize(0), unpackrowlenght(0), pboNeedsUpdate(false)
+    internalFormat(AV_PIX_FMT_RGB24), imgsize(0), unpackrowlenght(0), pboNeedsUpdate(false),
+    uploadRing(NULL), occlusionPaused(false), uploadedBytes(0)
 {
     if (!is || !is->isOpen())
         SourceConstructorException().raise();
 
+    // texture changes only with new frames
+    trackChanges = true;
+
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, textureIndex);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
     // no PBO by default
-    pboIds[0] = 0;
-    pboIds[1] = 0;
+    for (int i = 0; i < VIDEOSOURCE_PBO_COUNT; ++i) {
+        pboIds[i] = 0;
+        pboPointers[i] = NULL;
+        pboFences[i] = 0;
+    }
+    pboCount = 2;
     index = nextIndex = 0;
 
     // fills in the first frame
@@ -60,6 +69,13 @@ VideoSource::VideoSource(VideoFile *f, GLuint texture, double d) :
     QObject::connect(is, SIGNAL(failed()), this, SIGNAL(failed()));
     // forward the message on play
     QObject::connect(is, SIGNAL(running(bool)), this, SIGNAL(playing(bool)) );
+    // keep the choice of the user when the source is visible again
+    QObject::connect(is, SIGNAL(running(bool)), this, SLOT(cancelOcclusionPause()) );
+    QObject::connect(is, SIGNAL(paused(bool)), this, SLOT(cancelOcclusionPause()) );
+    // choose the frame at each tick of the rendering in frame pacing mode
+    is->setFramePacing( glRenderTimer::getInstance()->isFramePacingMode() );
+    QObject::connect(glRenderTimer::getInstance(), SIGNAL(framePacingChanged(bool)), is, SLOT(setFramePacing(bool)) );
+    QObject::connect(glRenderTimer::getInstance(), SIGNAL(frameScheduled(double)), is, SLOT(present(double)) );
 
 }
 
@@ -68,12 +84,15 @@ VideoSource::~VideoSource()
     // cancel updated frame
     updateFrame(NULL);
 
+    // stop uploading pictures of the video file
+    if (uploadRing)
+        delete uploadRing;
+
     if (is)
         delete is;
 
     // delete picture buffer
-    if (pboIds[0] || pboIds[1])
-        glDeleteBuffers(2, pboIds);
+    deleteFramePBO();
 
 #ifdef VIDEOPICTURE_DEBUG
     fprintf(stderr, "\nCount Video Picture %d.", VideoPicture::count);
@@ -120,6 +139,40 @@ void VideoSource::pause(bool on)
         is->pause(on);
 }
 
+bool VideoSource::isOpaque() const
+{
+    return format == GL_RGB;
+}
+
+void VideoSource::setOccluded(bool on)
+{
+    if ( on == isOccluded() )
+        return;
+
+    Source::setOccluded(on);
+
+    // stop decoding while hidden
+    // (unless the frames are shown by clones)
+    if (on) {
+        if ( isPlaying() && !isPaused() && !isCloned() ) {
+            // (set after the pause, which cancels it)
+            is->pause(true);
+            occlusionPaused = true;
+        }
+    }
+    // resume when visible again
+    else if (occlusionPaused) {
+        occlusionPaused = false;
+        if ( isPaused() )
+            is->pause(false);
+    }
+}
+
+void VideoSource::cancelOcclusionPause()
+{
+    occlusionPaused = false;
+}
+
 int VideoSource::getFrameWidth() const { return is->getFrameWidth(); }
 int VideoSource::getFrameHeight() const { return is->getFrameHeight(); }
 double VideoSource::getFrameRate() const { return is->getFrameRate(); }
@@ -176,29 +229,62 @@ QDomElement VideoSource::getConfiguration(QDomDocument &doc, QDir current)
 
 void VideoSource::fillFramePBO(const VideoPicture *p)
 {
-    // if the video picture contains a buffer, use it to fill the PBO
-    // NB : equivalent but faster (memmove instead of memcpy ?) than
-    // glNamedBufferSubData(pboIds[nextIndex], 0, imgsize, vp->getBuffer());
-
-    // bind PBO to update pixel values
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIds[nextIndex]);
-
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, imgsize, 0, GL_STREAM_DRAW);
-
-    // map the buffer object into client's memory
-    GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-    if (ptr && p->getBuffer()) {
-        // update data directly on the mapped buffer
-        memmove(ptr, p->getBuffer(), imgsize);
-        // release pointer to mapping buffer
-        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    // persistently mapped PBO : write directly in the buffer
+    if (pboPointers[nextIndex]) {
+
+        // the upload from this buffer was requested pboCount - 1 frames ago;
+        // make sure it is over before overwriting the pixels
+        if (pboFences[nextIndex]) {
+            glClientWaitSync(pboFences[nextIndex], GL_SYNC_FLUSH_COMMANDS_BIT, VIDEOSOURCE_PBO_TIMEOUT);
+            glDeleteSync(pboFences[nextIndex]);
+            pboFences[nextIndex] = 0;
+        }
+
+        // coherent mapping : no need to flush or to unmap
+        if (p->getBuffer())
+            memcpy(pboPointers[nextIndex], p->getBuffer(), imgsize);
     }
+    else {
+        // if the video picture contains a buffer, use it to fill the PBO
+        // NB : equivalent but faster (memmove instead of memcpy ?) than
+        // glNamedBufferSubData(pboIds[nextIndex], 0, imgsize, vp->getBuffer());
+
+        // bind PBO to update pixel values
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIds[nextIndex]);
+
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, imgsize, 0, GL_STREAM_DRAW);
+
+        // map the buffer object into client's memory
+        GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+        if (ptr && p->getBuffer()) {
+            // update data directly on the mapped buffer
+            memmove(ptr, p->getBuffer(), imgsize);
+            // release pointer to mapping buffer
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
 
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
 
-    // In dual PBO mode, increment current index first then get the next index
-    index = (index + 1) % 2;
-    nextIndex = (index + 1) % 2;
+    // In multiple PBO mode, increment current index first then get the next index
+    index = (index + 1) % pboCount;
+    nextIndex = (index + 1) % pboCount;
+}
+
+void VideoSource::deleteFramePBO()
+{
+    for (int i = 0; i < VIDEOSOURCE_PBO_COUNT; ++i) {
+        if (pboFences[i])
+            glDeleteSync(pboFences[i]);
+        pboFences[i] = 0;
+        // NB: deleting a buffer unmaps it
+        pboPointers[i] = NULL;
+    }
+
+    if (pboIds[0])
+        glDeleteBuffers(VIDEOSOURCE_PBO_COUNT, pboIds);
+    for (int i = 0; i < VIDEOSOURCE_PBO_COUNT; ++i)
+        pboIds[i] = 0;
 }
 
 // only Rendering Manager can call this
@@ -215,6 +301,10 @@ void VideoSource::update()
     if (unpackrowlenght)
         glPixelStorei(GL_UNPACK_ROW_LENGTH, unpackrowlenght);
 
+    // copy the most recent picture uploaded by the thread
+    if (uploadRing && uploadRing->pull(textureIndex))
+        changed = true;
+
     if (pboNeedsUpdate)
     {
         // bind PBO to read pixels
@@ -225,7 +315,15 @@ void VideoSource::update()
 
         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
+        // signal when the persistently mapped buffer can be written again
+        if (pboPointers[index]) {
+            if (pboFences[index])
+                glDeleteSync(pboFences[index]);
+            pboFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
         pboNeedsUpdate = false;
+        changed = true;
     }
 
     // update texture if given a new vp
@@ -237,23 +335,42 @@ void VideoSource::update()
         // apply fading
         setFading( vp->getFading() );
 
-        if ( pboIds[nextIndex] ) {
-
-            // fill the texture using Pixel Buffer Object mechanism
-            fillFramePBO(vp);
+        if ( uploadRing && vp->hasAction(VideoPicture::ACTION_DELETE) ) {
 
-            // Explicit request to display texture (dual buffer mechanism)
-            pboNeedsUpdate = true;
+            // give the picture to the upload thread (which deletes it)
+            // or keep it until a texture of the ring is free
+            int size = vp->getBufferSize();
+            if ( uploadRing->push(vp) ) {
+                uploadedBytes += size;
+                vp = NULL;
+            }
         }
         else {
-            // without PBO, use standard opengl (slower)
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, vp->getWidth(),
-                            vp->getHeight(), format, GL_UNSIGNED_BYTE, vp->getBuffer());
 
-        }
+            if ( pboIds[nextIndex] ) {
 
-        // done! Cancel (free) updated frame
-        updateFrame(NULL);
+                // fill the texture using Pixel Buffer Object mechanism
+                fillFramePBO(vp);
+
+                // Explicit request to display texture (dual buffer mechanism)
+                pboNeedsUpdate = true;
+            }
+            else {
+                // pictures of the ring would be older than this one
+                if (uploadRing)
+                    uploadRing->discard();
+
+                // without PBO, use standard opengl (slower)
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, vp->getWidth(),
+                                vp->getHeight(), format, GL_UNSIGNED_BYTE, vp->getBuffer());
+                changed = true;
+            }
+
+            uploadedBytes += vp->getBufferSize();
+
+            // done! Cancel (free) updated frame
+            updateFrame(NULL);
+        }
     }
 
     if (unpackrowlenght)
@@ -302,42 +419,48 @@ bool VideoSource::setVideoFormat(const VideoPicture *p)
         glTexImage2D(GL_TEXTURE_2D, 0, (GLenum) preferedinternalformat, p->getWidth(),
                      p->getHeight(), 0, format, GL_UNSIGNED_BYTE, p->getBuffer());
 
-        if ( isPlayable() && RenderingManager::usePboExtension())
+        // upload pictures in a thread if possible
+        // (through persistently mapped buffers, see TextureRing)
+        if ( isPlayable() && TextureUploader::isSupported() )
+        {
+            if (uploadRing)
+                delete uploadRing;
+            uploadRing = new TextureRing(p->getWidth(), p->getHeight(), format, preferedinternalformat, unpackrowlenght);
+        }
+        else if ( isPlayable() && RenderingManager::usePboExtension())
         {
             imgsize = p->getBufferSize();
 
             // delete picture buffer
-            if (pboIds[0] || pboIds[1])
-                glDeleteBuffers(2, pboIds);
-            // create 2 pixel buffer objects,
-            glGenBuffers(2, pboIds);
-            // create first PBO
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIds[0]);
-            // glBufferDataARB with NULL pointer reserves only memory space.
-            glBufferData(GL_PIXEL_UNPACK_BUFFER, imgsize, 0, GL_STREAM_DRAW);
-            // fill in with reset picture
-            GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-            if (ptr)  {
-                // update data directly on the mapped buffer
-                memmove(ptr, p->getBuffer(), imgsize);
-                // release pointer to mapping buffer
-                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-            }
-            else
-                return false;
-
-            // idem with second PBO
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIds[1]);
-            glBufferData(GL_PIXEL_UNPACK_BUFFER, imgsize, 0, GL_STREAM_DRAW);
-            ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-            if (ptr) {
-                // update data directly on the mapped buffer
+            deleteFramePBO();
+
+            // create a ring of persistently mapped pixel buffer objects if possible,
+            // otherwise 2 pixel buffer objects mapped at each frame
+            pboCount = RenderingManager::usePersistentPboExtension() ? VIDEOSOURCE_PBO_COUNT : 2;
+            glGenBuffers(pboCount, pboIds);
+            for (int i = 0; i < pboCount; ++i) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIds[i]);
+                GLubyte* ptr = NULL;
+                if (RenderingManager::usePersistentPboExtension()) {
+                    // immutable storage, mapped for the lifetime of the buffer
+                    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, imgsize, 0, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+                    ptr = pboPointers[i] = (GLubyte*) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imgsize, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+                }
+                else {
+                    // glBufferDataARB with NULL pointer reserves only memory space.
+                    glBufferData(GL_PIXEL_UNPACK_BUFFER, imgsize, 0, GL_STREAM_DRAW);
+                    ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+                }
+                if (!ptr) {
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                    return false;
+                }
+                // fill in with reset picture
                 memmove(ptr, p->getBuffer(), imgsize);
                 // release pointer to mapping buffer
-                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                if (!pboPointers[i])
+                    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
             }
-            else
-                return false;
 
             glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
             index = 0;
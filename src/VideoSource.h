@@ -31,7 +31,15 @@
 #include "Source.h"
 #include "VideoFile.h"
 #include "ViewRenderWidget.h"
+#include "TextureUploader.h"
 
+/**
+ * Number of pixel buffer objects in the upload ring when they
+ * are persistently mapped (otherwise 2 buffers mapped at each frame)
+ * and maximum time to wait (ns) for the upload from a buffer to be over.
+ */
+#define VIDEOSOURCE_PBO_COUNT 3
+#define VIDEOSOURCE_PBO_TIMEOUT 20000000
 
 class VideoSource : public Source {
 
@@ -54,6 +62,8 @@ public:
     bool isPlayable() const;
     bool isPlaying() const;
     bool isPaused() const;
+    bool isOpaque() const;
+    void setOccluded(bool on);
 
     inline VideoFile *getVideoFile() const { return is; }
 
@@ -62,6 +72,9 @@ public:
     double getFrameRate() const;
     double getAspectRatio() const;
 
+    // bytes of the pictures given to OpenGL
+    inline qint64 getUploadedBytes() const { return uploadedBytes; }
+
     QDomElement getConfiguration(QDomDocument &doc, QDir current);
 
 public slots:
@@ -69,9 +82,14 @@ public slots:
     void pause(bool on);
     void updateFrame (VideoPicture *);
 
+private slots:
+    // the user paused, resumed or stopped the video
+    void cancelOcclusionPause();
+
 private:
 
     void fillFramePBO(const VideoPicture *vp);
+    void deleteFramePBO();
     bool setVideoFormat(const VideoPicture *vp);
 
     static RTTI type;
@@ -81,10 +99,17 @@ private:
     VideoPicture *vp;
     AVPixelFormat internalFormat;
 
-    GLuint pboIds[2];
-    int index, nextIndex;
+    GLuint pboIds[VIDEOSOURCE_PBO_COUNT];
+    GLubyte *pboPointers[VIDEOSOURCE_PBO_COUNT];
+    GLsync pboFences[VIDEOSOURCE_PBO_COUNT];
+    int pboCount, index, nextIndex;
     int imgsize, unpackrowlenght;
     bool pboNeedsUpdate;
+    // textures filled by the upload thread
+    TextureRing *uploadRing;
+    // paused because hidden
+    bool occlusionPaused;
+    qint64 uploadedBytes;
 };
 
 #endif /* VIDEOSOURCE_H_ */
@@ -32,7 +32,7 @@
 Source::RTTI VideoStreamSource::type = Source::STREAM_SOURCE;
 
 VideoStreamSource::VideoStreamSource(VideoStream *s, GLuint texture, double d) :
-    Source(texture, d), status(STREAM_BLANK), format(GL_RGB), is(s), vp(NULL)
+    Source(texture, d), status(STREAM_BLANK), format(GL_RGB), is(s), vp(NULL), uploadRing(NULL)
 {
     if (!is)
         SourceConstructorException().raise();
@@ -101,6 +101,10 @@ VideoStreamSource::~VideoStreamSource()
     // cancel updated frame
     updateFrame(NULL);
 
+    // stop uploading pictures of the stream
+    if (uploadRing)
+        delete uploadRing;
+
     // delete input stream
     if (is) {
         delete is;
@@ -202,6 +206,10 @@ void VideoStreamSource::update()
 {
     glBindTexture(GL_TEXTURE_2D, textureIndex);
 
+    // copy the most recent picture uploaded by the thread
+    if (uploadRing)
+        uploadRing->pull(textureIndex);
+
     // update texture if given a new vp
     if ( vp && vp->getBuffer() != NULL )
     {
@@ -213,7 +221,13 @@ void VideoStreamSource::update()
             glTexImage2D(GL_TEXTURE_2D, 0, (GLenum) format, vp->getWidth(),
                           vp->getHeight(), 0, format, GL_UNSIGNED_BYTE, vp->getBuffer());
 
-            if (RenderingManager::usePboExtension())
+            // upload pictures in a thread if possible
+            if (TextureUploader::isSupported()) {
+                if (uploadRing)
+                    delete uploadRing;
+                uploadRing = new TextureRing(vp->getWidth(), vp->getHeight(), format, format);
+            }
+            else if (RenderingManager::usePboExtension())
             {
                 imgsize =  vp->getWidth() * vp->getHeight() * 3;
                 // create 2 pixel buffer objects,
@@ -236,7 +250,14 @@ void VideoStreamSource::update()
 
         else if ( status == STREAM_READY ) {
 
-            if ( pboIds[0] && pboIds[1] ) {
+            if ( uploadRing && vp->hasAction(VideoPicture::ACTION_DELETE) ) {
+
+                // give the picture to the upload thread (which deletes it)
+                // or drop it if all textures of the ring are in use
+                if ( uploadRing->push(vp) )
+                    vp = NULL;
+            }
+            else if ( pboIds[0] && pboIds[1] ) {
 
                 // fill the texture using Pixel Buffer Object mechanism
                 fillFramePBO(vp);
@@ -248,6 +269,10 @@ void VideoStreamSource::update()
 
             }
             else {
+                // pictures of the ring would be older than this one
+                if (uploadRing)
+                    uploadRing->discard();
+
                 // without PBO, use standard opengl (slower)
                 glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, vp->getWidth(),
                                 vp->getHeight(), format, GL_UNSIGNED_BYTE, vp->getBuffer());
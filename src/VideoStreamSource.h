@@ -5,6 +5,7 @@
 
 #include "Source.h"
 #include "VideoStream.h"
+#include "TextureUploader.h"
 
 
 class VideoStreamSource : public Source
@@ -64,6 +65,8 @@ private:
     GLuint pboIds[2];
     int index, nextIndex;
     int imgsize;
+    // textures filled by the upload thread
+    TextureRing *uploadRing;
 
     int width, height;
 };
@@ -43,18 +43,24 @@
 #include "MagnetCursor.h"
 #include "glmixer.h"
 #include "WorkspaceManager.h"
+#include "ColorLookupTable.h"
+#include "Profiler.h"
+#include "Tracer.h"
+
+#include <cstring>
+#include <QFile>
 
 #ifdef GLM_SNAPSHOT
 #include "SnapshotManager.h"
 #include "SnapshotView.h"
 #endif
 
-GLuint ViewRenderWidget::vertex_array_coords = 0;
+GLuint ViewRenderWidget::vertex_buffer = 0;
 GLuint ViewRenderWidget::border_thin_shadow = 0,
         ViewRenderWidget::border_large_shadow = 0;
 GLuint ViewRenderWidget::border_thin = 0, ViewRenderWidget::border_large = 0;
 GLuint ViewRenderWidget::border_scale = 0, ViewRenderWidget::border_tooloverlay = 0;
-GLuint ViewRenderWidget::quad_texured = 0, ViewRenderWidget::quad_window[] = {0, 0};
+GLuint ViewRenderWidget::quad_window[] = {0, 0};
 GLuint ViewRenderWidget::frame_selection = 0, ViewRenderWidget::frame_screen = 0;
 GLuint ViewRenderWidget::frame_screen_thin = 0, ViewRenderWidget::frame_screen_mask = 0;
 GLuint ViewRenderWidget::circle_mixing = 0, ViewRenderWidget::circle_limbo = 0, ViewRenderWidget::layerbg = 0;
@@ -135,7 +141,6 @@ GLubyte ViewRenderWidget::stippling[] = {
 //GLfloat ViewRenderWidget::texc[8] = {0.f, 1.f,  1.f, 1.f,  1.f, 0.f,  0.f, 0.f};
 
 GLfloat ViewRenderWidget::coords[8] = { -1.f, 1.f,  1.f, 1.f, 1.f, -1.f,  -1.f, -1.f };
-GLfloat ViewRenderWidget::texc[8] = {0.f, 0.f,  1.f, 0.f,  1.f, 1.f,  0.f, 1.f};
 GLfloat ViewRenderWidget::maskc[8] = {0.f, 0.f,  1.f, 0.f,  1.f, 1.f,  0.f, 1.f};
 QGLShaderProgram *ViewRenderWidget::program = 0;
 QString ViewRenderWidget::glslShaderFile = ":/glsl/shaders/imageProcessing_fragment.glsl";
@@ -159,6 +164,14 @@ int ViewRenderWidget::_filter_step = -1;
 int ViewRenderWidget::_filter_kernel = -1;
 int ViewRenderWidget::_fading = -1;
 int ViewRenderWidget::_lumakey = -1;
+int ViewRenderWidget::_textureCoordinates = -1;
+int ViewRenderWidget::_sourceTransform = -1;
+ShaderAttributes ViewRenderWidget::currentAttributes = ViewRenderWidget::defaultShaderAttributes();
+// values of the uniforms of the vertex shader (sent to each variant in use)
+static GLfloat currentTextureCoordinates[4] = {0.f, 0.f, 1.f, 1.f};
+static QMatrix4x4 currentSourceTransform;
+uint ViewRenderWidget::shaderFeatures = ViewRenderWidget::SHADER_ALL;
+bool ViewRenderWidget::shaderPermutations = false;
 
 
 const char * const black_xpm[] = { "2 2 1 1", ". c #000000", "..", ".."};
@@ -366,19 +379,11 @@ void ViewRenderWidget::initializeGL()
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
     }
 
-    // Create display lists
-
-    // display list to enable the vertex array for drawing
-    vertex_array_coords = glGenLists(1);
-    glNewList(vertex_array_coords, GL_COMPILE);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    glVertexPointer(2, GL_FLOAT, 0, ViewRenderWidget::coords);
-    glTexCoordPointer(2, GL_FLOAT, 0, ViewRenderWidget::maskc);
-    glEndList();
+    // vertex buffer of the quad used for drawing sources
+    vertex_buffer = buildVertexBuffer();
+    setupVertexArray();
 
-    // display lists for drawing GUI
-    quad_texured = buildTexturedQuadList();
+    // Create display lists for drawing GUI
     border_thin_shadow = buildLineList();
     border_large_shadow = border_thin_shadow + 1;
     frame_selection = buildSelectList();
@@ -716,6 +721,9 @@ void ViewRenderWidget::paintGL()
 {
     static GLfloat angle = 0;
 
+    TRACE_SCOPE("paintGL");
+    Profiler::getInstance()->beginFrame();
+
     // for animation
     emit tick();
 
@@ -744,12 +752,17 @@ void ViewRenderWidget::paintGL()
     for(SourceSet::iterator  its = RenderingManager::getInstance()->getBegin(); its != RenderingManager::getInstance()->getEnd(); its++) {
 
         // update the content of the sources if not in standy
-        if (!(*its)->isStandby())
+        if (!(*its)->isStandby()) {
+            Profiler::getInstance()->begin((*its)->getName());
             (*its)->update();
+            Profiler::getInstance()->end();
+        }
     }
 
     // draw the view
+    Profiler::getInstance()->begin(tr("View"));
     _currentView->paint();
+    Profiler::getInstance()->end();
 
     //
     // 3. draw a semi-transparent overlay if view should be faded out
@@ -824,8 +837,11 @@ void ViewRenderWidget::paintGL()
 #endif
 
     // Catalog : show if visible
-    if (_catalogView->visible())
+    if (_catalogView->visible()) {
+        Profiler::getInstance()->begin(tr("Catalog"));
         _catalogView->paint();
+        Profiler::getInstance()->end();
+    }
 
     // FPS computation every 5 frames
     if (++fpsCounter_ == 5)
@@ -843,6 +859,10 @@ void ViewRenderWidget::paintGL()
     if (showFps_ || ( f_p_s_ < 800.0 / (float) glRenderTimer::getInstance()->interval() && f_p_s_ > 0) )
         displayFramerate();
 
+    // HUD display of the profiler
+    if (Profiler::getInstance()->isEnabled())
+        displayProfiler();
+
     // Pause logo
     if (RenderingManager::getInstance()->isPaused()){
         glMatrixMode(GL_PROJECTION);
@@ -868,6 +888,8 @@ void ViewRenderWidget::paintGL()
         qglColor(Qt::lightGray);
         renderText(20, height() - 20, message, labelfont);
     }
+
+    Profiler::getInstance()->endFrame();
 }
 
 void ViewRenderWidget::displayFramerate()
@@ -895,6 +917,54 @@ void ViewRenderWidget::displayFramerate()
 }
 
 
+void ViewRenderWidget::displayProfiler()
+{
+    QList<Profiler::Timing> timings = Profiler::getInstance()->timings();
+    if (timings.isEmpty())
+        return;
+
+    static QFont font(getMonospaceFont(), 9);
+    int lineheight = QFontMetrics(font).height();
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0.0, width(), 0.0, height());
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    // background of the table
+    glColor4ub(COLOR_FADING, 200);
+    glRecti(5, height() - 40, 45 * QFontMetrics(font).width('0'), height() - 45 - lineheight * (timings.size() + 1));
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+
+    // one line per section, indented by depth
+    qglColor(Qt::lightGray);
+    int y = 40 + lineheight;
+    renderText(10, y, QString("  GPU ms   CPU ms  ") + tr("Section"), font);
+    foreach (const Profiler::Timing &t, timings) {
+        y += lineheight;
+        QString gpu = t.gpu < 0.0 ? QString("-") : QString::number(t.gpu, 'f', 2);
+        renderText(10, y, QString("%1 %2  %3%4").arg(gpu, 8).arg(t.cpu, 8, 'f', 2).arg(QString(2 * t.depth, ' ')).arg(t.name), font);
+    }
+}
+
+bool ViewRenderWidget::getProfilerVisible()
+{
+    return Profiler::getInstance()->isEnabled();
+}
+
+void ViewRenderWidget::setProfilerVisible(bool on)
+{
+    Profiler::getInstance()->setEnabled(on);
+}
+
 void ViewRenderWidget::setFramerateVisible(bool on)
 {
     showFps_ = on;
@@ -1423,45 +1493,140 @@ void ViewRenderWidget::setBaseColor(QColor c, float alpha)
 {
     if (_baseColor<0) return;
 
-    program->setUniformValue(_baseColor, c);
-    program->setUniformValue(_fading, 1.f);
+    ShaderAttributes a = currentAttributes;
+    a.baseColor[0] = c.redF();
+    a.baseColor[1] = c.greenF();
+    a.baseColor[2] = c.blueF();
+    a.baseColor[3] = c.alphaF();
+    a.fading = 1.f;
+    a.baseAlpha = alpha > -1.0 ? alpha : 1.f;
+    setShaderAttributes(a);
+}
 
-    if (alpha > -1.0)
-        program->setUniformValue(_baseAlpha, alpha);
-    else
-        program->setUniformValue(_baseAlpha, 1.f);
+void ViewRenderWidget::setBaseAlpha(float alpha)
+{
+    if (_baseAlpha<0 || currentAttributes.baseAlpha == alpha) return;
+
+    program->setUniformValue(_baseAlpha, alpha);
+    currentAttributes.baseAlpha = alpha;
 }
 
-void ViewRenderWidget::resetShaderAttributes()
+void ViewRenderWidget::setStippling(float stipple)
+{
+    if (_stippling<0 || currentAttributes.stippling == stipple) return;
+
+    program->setUniformValue(_stippling, stipple);
+    currentAttributes.stippling = stipple;
+}
+
+void ViewRenderWidget::setFading(float fade)
+{
+    if (_fading<0 || currentAttributes.fading == fade) return;
+
+    program->setUniformValue(_fading, fade);
+    currentAttributes.fading = fade;
+}
+
+const ShaderAttributes &ViewRenderWidget::defaultShaderAttributes()
+{
+    // white, opaque, no effect, no filter
+    static const ShaderAttributes defaults = {
+        {1.f, 1.f, 1.f, 1.f},
+        1.f, 0.f, 1.f,
+        {1.f, 1.f, 1.f, 1.f}, {0.f, 1.f, 0.f, 1.f},
+        1.f, 0.f, 1.f, 0.f,
+        0, -1,
+        -1.f, -1.f,
+        {0.f, 0.f, 0.f, 0.f},
+        0.f,
+        0,
+        {1.f / 640.f, 1.f / 480.f}
+    };
+
+    return defaults;
+}
+
+#define ATTRIBUTE_CHANGED(v) ( force || memcmp(&a.v, &currentAttributes.v, sizeof(a.v)) != 0 )
+
+void ViewRenderWidget::setShaderAttributes(const ShaderAttributes &a, bool force)
 {
     if (_baseColor<0) return;
 
-    // set color & alpha
-    program->setUniformValue(_baseColor, QColor(Qt::white));
-    program->setUniformValue(_baseAlpha, 1.f);
-    program->setUniformValue(_stippling, 0.f);
-    program->setUniformValue(_fading, 1.f);
-    // gamma
-    program->setUniformValue(_gamma, 1.f, 1.f, 1.f, 1.f);
-    program->setUniformValue(_levels, 0.f, 1.f, 0.f, 1.f);
-    // effects
-    program->setUniformValue(_contrast, 1.f);
-    program->setUniformValue(_saturation, 1.f);
-    program->setUniformValue(_brightness, 0.f);
-    program->setUniformValue(_hueshift, 0.f);
-    program->setUniformValue(_chromakey, 0.f, 0.f, 0.f, 0.f );
-    program->setUniformValue(_threshold, -1.f);
-    program->setUniformValue(_lumakey, -1.f);
-    program->setUniformValue(_nbColors, (GLint) -1);
-    program->setUniformValue(_invertMode, (GLint) 0);
-
-    // disable filtering
+    // send only the values which are different from those in the program
+    if (ATTRIBUTE_CHANGED(baseColor))
+        program->setUniformValue(_baseColor, a.baseColor[0], a.baseColor[1], a.baseColor[2], a.baseColor[3]);
+    if (ATTRIBUTE_CHANGED(baseAlpha))
+        program->setUniformValue(_baseAlpha, a.baseAlpha);
+    if (ATTRIBUTE_CHANGED(stippling))
+        program->setUniformValue(_stippling, a.stippling);
+    if (ATTRIBUTE_CHANGED(fading))
+        program->setUniformValue(_fading, a.fading);
+    if (ATTRIBUTE_CHANGED(gamma))
+        program->setUniformValue(_gamma, a.gamma[0], a.gamma[1], a.gamma[2], a.gamma[3]);
+    if (ATTRIBUTE_CHANGED(levels))
+        program->setUniformValue(_levels, a.levels[0], a.levels[1], a.levels[2], a.levels[3]);
+    if (ATTRIBUTE_CHANGED(contrast))
+        program->setUniformValue(_contrast, a.contrast);
+    if (ATTRIBUTE_CHANGED(brightness))
+        program->setUniformValue(_brightness, a.brightness);
+    if (ATTRIBUTE_CHANGED(saturation))
+        program->setUniformValue(_saturation, a.saturation);
+    if (ATTRIBUTE_CHANGED(hueshift))
+        program->setUniformValue(_hueshift, a.hueshift);
+    if (ATTRIBUTE_CHANGED(invertMode))
+        program->setUniformValue(_invertMode, a.invertMode);
+    if (ATTRIBUTE_CHANGED(nbColors))
+        program->setUniformValue(_nbColors, a.nbColors);
+    if (ATTRIBUTE_CHANGED(threshold))
+        program->setUniformValue(_threshold, a.threshold);
+    if (ATTRIBUTE_CHANGED(lumakey))
+        program->setUniformValue(_lumakey, a.lumakey);
+    if (ATTRIBUTE_CHANGED(chromakey))
+        program->setUniformValue(_chromakey, a.chromakey[0], a.chromakey[1], a.chromakey[2], a.chromakey[3]);
+    if (ATTRIBUTE_CHANGED(chromadelta))
+        program->setUniformValue(_chromadelta, a.chromadelta);
+
+    // filtering uniforms only exist in the complete shader
     if (!disableFiltering) {
-        program->setUniformValue(_filter_step, 1.f / 640.f, 1.f / 480.f);
-        program->setUniformValue(_filter_type, (GLint) 0);
-        program->setUniformValue(_filter_kernel, filter_kernel[0]);
+        if (ATTRIBUTE_CHANGED(filter_type)) {
+            program->setUniformValue(_filter_type, a.filter_type);
+            // the kernel is a constant of the filter type
+            if (a.filter_type < 10)
+                program->setUniformValue(_filter_kernel, filter_kernel[a.filter_type]);
+        }
+        if (ATTRIBUTE_CHANGED(filter_step))
+            program->setUniformValue(_filter_step, a.filter_step[0], a.filter_step[1]);
     }
 
+    currentAttributes = a;
+}
+
+void ViewRenderWidget::setTextureCoordinates(GLfloat left, GLfloat top, GLfloat right, GLfloat bottom)
+{
+    currentTextureCoordinates[0] = left;
+    currentTextureCoordinates[1] = top;
+    currentTextureCoordinates[2] = right;
+    currentTextureCoordinates[3] = bottom;
+
+    if (program && _textureCoordinates > -1)
+        program->setUniformValue(_textureCoordinates, left, top, right, bottom);
+}
+
+void ViewRenderWidget::setSourceTransform(const QMatrix4x4 &transform)
+{
+    currentSourceTransform = transform;
+
+    if (program && _sourceTransform > -1)
+        program->setUniformValue(_sourceTransform, transform);
+}
+
+void ViewRenderWidget::resetShaderAttributes()
+{
+    if (_baseColor<0) return;
+
+    // set color & alpha, no effect and no filter
+    setShaderAttributes( defaultShaderAttributes() );
+
     // activate texture 1 ; double texturing of the mask
     glActiveTexture(GL_TEXTURE1);
     // select and enable the texture corresponding to the mask
@@ -1470,17 +1635,164 @@ void ViewRenderWidget::resetShaderAttributes()
     glActiveTexture(GL_TEXTURE0);
 
     // reset texture coordinate
-    texc[0] = texc[6] = 0.f;
-    texc[1] = texc[3] = 1.f;
-    texc[2] = texc[4] = 1.f;
-    texc[5] = texc[7] = 0.f;
-    program->setAttributeArray ("texCoord", ViewRenderWidget::texc, 2, 0);
+    setTextureCoordinates(0.f, 1.f, 1.f, 0.f);
 
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glBlendEquation(GL_FUNC_ADD);
 
 }
 
+/*
+** PROGRAM VARIANTS
+**
+** The fragment shader is compiled with the features used by the sources
+** (#define SHADER_FILTER etc. inserted after the #version directive).
+** Each variant has its own uniform locations and values.
+*/
+#define SHADER_UNIFORM_COUNT 21
+static const char *uniformNames[SHADER_UNIFORM_COUNT] = {
+    "baseColor", "baseAlpha", "stippling", "gamma", "levels", "contrast", "brightness",
+    "saturation", "hueshift", "invertMode", "nbColors", "threshold", "chromakey",
+    "chromadelta", "fade", "lumakey", "filter_type", "filter_step", "filter_kernel",
+    "textureCoordinates", "sourceTransform" };
+static int *uniformLocations[SHADER_UNIFORM_COUNT] = {
+    &ViewRenderWidget::_baseColor, &ViewRenderWidget::_baseAlpha, &ViewRenderWidget::_stippling,
+    &ViewRenderWidget::_gamma, &ViewRenderWidget::_levels, &ViewRenderWidget::_contrast,
+    &ViewRenderWidget::_brightness, &ViewRenderWidget::_saturation, &ViewRenderWidget::_hueshift,
+    &ViewRenderWidget::_invertMode, &ViewRenderWidget::_nbColors, &ViewRenderWidget::_threshold,
+    &ViewRenderWidget::_chromakey, &ViewRenderWidget::_chromadelta, &ViewRenderWidget::_fading,
+    &ViewRenderWidget::_lumakey, &ViewRenderWidget::_filter_type, &ViewRenderWidget::_filter_step,
+    &ViewRenderWidget::_filter_kernel, &ViewRenderWidget::_textureCoordinates,
+    &ViewRenderWidget::_sourceTransform };
+
+// same attribute location in all variants
+// (not aliased with the conventional attributes)
+#define ATTRIBUTE_MASKCOORD 7
+
+typedef struct {
+    QGLShaderProgram *program;
+    int uniforms[SHADER_UNIFORM_COUNT];
+    ShaderAttributes attributes;
+} ShaderVariant;
+
+static QMap<uint, ShaderVariant> shaderVariants;
+static QByteArray fragmentShaderCode;
+static QString fragmentShaderFile;
+
+void ViewRenderWidget::buildShaderProgram(QGLShaderProgram *p, uint features)
+{
+    // delete previous program if existed
+    p->removeAllShaders();
+
+    // features are defined after the version directive
+    QByteArray code = fragmentShaderCode;
+    QByteArray defines;
+    if (features & SHADER_FILTER)
+        defines += "#define SHADER_FILTER\n";
+    if (features & SHADER_CHROMAKEY)
+        defines += "#define SHADER_CHROMAKEY\n";
+    if (features & SHADER_COLOR)
+        defines += "#define SHADER_COLOR\n";
+    if (features & SHADER_HSL)
+        defines += "#define SHADER_HSL\n";
+    if (features & SHADER_LUT)
+        defines += "#define SHADER_LUT\n#define LUT_SIZE " + QByteArray::number(LUT_SIZE) + ".0\n";
+    int version = code.indexOf("#version");
+    code.insert( version < 0 ? 0 : code.indexOf('\n', version) + 1, defines);
+
+    if (!p->addShaderFromSourceCode(QGLShader::Fragment, code))
+        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL error in fragment shader; \n\n%1").arg(p->log()) ) );
+    else if (p->log().contains("warning"))
+        qCritical() << fragmentShaderFile << QChar(124).toLatin1() << QObject::tr("OpenGL GLSL warning in fragment shader;%1").arg(p->log());
+
+    if (!p->addShaderFromSourceFile(QGLShader::Vertex, ":/glsl/shaders/imageProcessing_vertex.glsl"))
+        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL error in vertex shader; \n\n%1").arg(p->log()) ) );
+    else if (p->log().contains("warning"))
+        qCritical() << "imageProcessing_vertex.glsl" << QChar(124).toLatin1()<< QObject::tr("OpenGL GLSL warning in vertex shader;%1").arg(p->log());
+
+    p->bindAttributeLocation("maskCoord", ATTRIBUTE_MASKCOORD);
+
+    if (!p->link())
+        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL linking error; \n\n%1").arg(p->log()) ) );
+
+    if (!p->bind())
+        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL binding error; \n\n%1").arg(p->log()) ) );
+
+    // set the pointer to the array for the mask attributes
+    if (vertex_buffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        p->setAttributeBuffer(ATTRIBUTE_MASKCOORD, GL_FLOAT, sizeof(coords), 2);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    else
+        p->setAttributeArray(ATTRIBUTE_MASKCOORD, ViewRenderWidget::maskc, 2);
+    p->enableAttributeArray(ATTRIBUTE_MASKCOORD);
+
+    // get uniforms (unused uniforms of the variant are at -1)
+    for (int i = 0; i < SHADER_UNIFORM_COUNT; ++i)
+        *uniformLocations[i] = p->uniformLocation(uniformNames[i]);
+    if (ViewRenderWidget::disableFiltering)
+        _filter_type = _filter_step = _filter_kernel = -1;
+
+    // set the default values for the uniform variables
+    p->setUniformValue("sourceTexture", 0);
+    p->setUniformValue("maskTexture", 1);
+    p->setUniformValue("lutTexture", 2);
+    p->setUniformValue("sourceDrawing", false);
+
+    // new program : all values have to be sent
+    // (only the uniforms ; a variant can be built while drawing a source,
+    // after its mask texture and blending are set)
+    program = p;
+    setShaderAttributes( defaultShaderAttributes(), true );
+    setTextureCoordinates(currentTextureCoordinates[0], currentTextureCoordinates[1], currentTextureCoordinates[2], currentTextureCoordinates[3]);
+    setSourceTransform(currentSourceTransform);
+
+    // keep the variant
+    ShaderVariant v;
+    v.program = p;
+    for (int i = 0; i < SHADER_UNIFORM_COUNT; ++i)
+        v.uniforms[i] = *uniformLocations[i];
+    v.attributes = currentAttributes;
+    shaderVariants[features] = v;
+    shaderFeatures = features;
+}
+
+void ViewRenderWidget::setShaderFeatures(uint features)
+{
+    if (!program || !shaderPermutations)
+        return;
+
+    if (disableFiltering)
+        features &= ~SHADER_FILTER;
+
+    // nothing to do if the program is already the right one
+    if (features == shaderFeatures)
+        return;
+
+    // keep the values of the uniforms of the current variant
+    shaderVariants[shaderFeatures].attributes = currentAttributes;
+
+    if (shaderVariants.contains(features)) {
+        // use the variant
+        const ShaderVariant &v = shaderVariants[features];
+        program = v.program;
+        program->bind();
+        for (int i = 0; i < SHADER_UNIFORM_COUNT; ++i)
+            *uniformLocations[i] = v.uniforms[i];
+        currentAttributes = v.attributes;
+        shaderFeatures = features;
+        // the vertex shader uniforms are shared by all variants
+        program->setUniformValue(_textureCoordinates, currentTextureCoordinates[0], currentTextureCoordinates[1], currentTextureCoordinates[2], currentTextureCoordinates[3]);
+        program->setUniformValue(_sourceTransform, currentSourceTransform);
+    }
+    else {
+        // compile the variant the first time it is needed
+        buildShaderProgram(new QGLShaderProgram(program->parent()), features);
+        qDebug() << fragmentShaderFile << QChar(124).toLatin1()<< QObject::tr("OpenGL GLSL program variant %1 compiled (%2 variants).").arg(features).arg(shaderVariants.size());
+    }
+}
+
 void ViewRenderWidget::setupFilteringShaderProgram(QString fshfile)
 {
     if (!program)
@@ -1489,61 +1801,25 @@ void ViewRenderWidget::setupFilteringShaderProgram(QString fshfile)
     if (fshfile.isEmpty())
         return;
 
-    // delete previous program if existed
-    program->removeAllShaders();
-
-    if (!program->addShaderFromSourceFile(QGLShader::Fragment, fshfile))
-        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL error in fragment shader; \n\n%1").arg(program->log()) ) );
-    else if (program->log().contains("warning"))
-        qCritical() << fshfile << QChar(124).toLatin1() << QObject::tr("OpenGL GLSL warning in fragment shader;%1").arg(program->log());
-
-    if (!program->addShaderFromSourceFile(QGLShader::Vertex, ":/glsl/shaders/imageProcessing_vertex.glsl"))
-        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL error in vertex shader; \n\n%1").arg(program->log()) ) );
-    else if (program->log().contains("warning"))
-        qCritical() << "imageProcessing_vertex.glsl" << QChar(124).toLatin1()<< QObject::tr("OpenGL GLSL warning in vertex shader;%1").arg(program->log());
-
-    if (!program->link())
-        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL linking error; \n\n%1").arg(program->log()) ) );
-
-    if (!program->bind())
-        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL binding error; \n\n%1").arg(program->log()) ) );
-
-    // set the pointer to the array for the texture attributes
-    program->setAttributeArray ("texCoord", ViewRenderWidget::texc, 2, 0);
-    program->enableAttributeArray("texCoord");
-    program->setAttributeArray ("maskCoord", ViewRenderWidget::maskc, 2, 0);
-    program->enableAttributeArray("maskCoord");
-
-    // get uniforms
-    _baseColor = program->uniformLocation("baseColor");
-    _baseAlpha = program->uniformLocation("baseAlpha");
-    _stippling = program->uniformLocation("stippling");
-    _gamma  = program->uniformLocation("gamma");
-    _levels  = program->uniformLocation("levels");
-    _contrast  = program->uniformLocation("contrast");
-    _brightness  = program->uniformLocation("brightness");
-    _saturation  = program->uniformLocation("saturation");
-    _hueshift  = program->uniformLocation("hueshift");
-    _invertMode  = program->uniformLocation("invertMode");
-    _nbColors  = program->uniformLocation("nbColors");
-    _threshold  = program->uniformLocation("threshold");
-    _chromakey  = program->uniformLocation("chromakey");
-    _chromadelta  = program->uniformLocation("chromadelta");
-    _fading  = program->uniformLocation("fade");
-    _lumakey  = program->uniformLocation("lumakey");
+    // read the code of the fragment shader
+    QFile file(fshfile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        qFatal( "%s", qPrintable( QObject::tr("OpenGL GLSL error in fragment shader; \n\nCannot read %1").arg(fshfile) ) );
+    fragmentShaderCode = file.readAll();
+    fragmentShaderFile = fshfile;
 
-    // set the default values for the uniform variables
-    program->setUniformValue("sourceTexture", 0);
-    program->setUniformValue("maskTexture", 1);
-    program->setUniformValue("sourceDrawing", false);
-    program->setUniformValue(_fading, 1.f);
-
-    if (!ViewRenderWidget::disableFiltering) {
-        _filter_type  = program->uniformLocation("filter_type");
-        _filter_step  = program->uniformLocation("filter_step");
-        _filter_kernel  = program->uniformLocation("filter_kernel");
+    // variants are possible only if the code uses the features
+    shaderPermutations = fragmentShaderCode.contains("#ifdef SHADER_");
+
+    // delete previous variants (the current program is re-used)
+    foreach (const ShaderVariant &v, shaderVariants) {
+        if (v.program != program)
+            delete v.program;
     }
+    shaderVariants.clear();
 
+    // the default program has all the features
+    buildShaderProgram(program, disableFiltering ? SHADER_ALL & ~SHADER_FILTER : SHADER_ALL);
     resetShaderAttributes();
 
     // ready
@@ -1609,7 +1885,7 @@ GLuint ViewRenderWidget::buildSelectList()
         glLineStipple(1, 0x7777);
         // glLineStipple(1, 0x6666);
         glEnable(GL_LINE_STIPPLE);
-        glCallList(vertex_array_coords);
+        setupVertexArray();
         glPushMatrix();
         glScalef(1.12, 1.12, 1.0);
         glDrawArrays(GL_LINE_LOOP, 0, 4);
@@ -1627,7 +1903,7 @@ GLuint ViewRenderWidget::buildSelectList()
         glLineWidth(3.0);
         glLineStipple(1, 0x6186);
         glEnable(GL_LINE_STIPPLE);
-        glCallList(vertex_array_coords);
+        setupVertexArray();
         glPushMatrix();
         glScalef(1.12, 1.12, 1.0);
         glDrawArrays(GL_LINE_LOOP, 0, 4);
@@ -1640,32 +1916,44 @@ GLuint ViewRenderWidget::buildSelectList()
 }
 
 /**
- * Build a display list of a textured QUAD and returns its id
+ * Build the vertex buffer object of the quad and returns its id
  *
- * This is used only for the source drawing in GL_SELECT mode
+ * It contains the vertex coordinates followed by the mask coordinates
+ * (also used as texture coordinates for the GUI). Returns 0 if vertex
+ * buffer objects are not supported (the arrays are used from memory).
  *
  **/
-GLuint ViewRenderWidget::buildTexturedQuadList()
+GLuint ViewRenderWidget::buildVertexBuffer()
 {
-    GLuint id = glGenLists(1);
-    glNewList(id, GL_COMPILE);
+    if (!glewIsSupported("GL_ARB_vertex_buffer_object"))
+        return 0;
 
-        glBegin(GL_QUADS); // begin drawing a square
+    GLuint id = 0;
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_ARRAY_BUFFER, id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(coords) + sizeof(maskc), NULL, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(coords), coords);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(coords), sizeof(maskc), maskc);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glTexCoord2f(0.f, 1.f);
-        glVertex2f(-1.0f, -1.0f); // Bottom Left
-        glTexCoord2f(1.f, 1.f);
-        glVertex2f(1.0f, -1.0f); // Bottom Right
-        glTexCoord2f(1.f, 0.f);
-        glVertex2f(1.0f, 1.0f); // Top Right
-        glTexCoord2f(0.f, 0.f);
-        glVertex2f(-1.0f, 1.0f); // Top Left
-
-        glEnd();
+    return id;
+}
 
+void ViewRenderWidget::setupVertexArray()
+{
+    // NB: the pointers are offsets in the buffer if there is one
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, vertex_buffer ? 0 : coords);
+    glTexCoordPointer(2, GL_FLOAT, 0, vertex_buffer ? (GLvoid *) sizeof(coords) : maskc);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    glEndList();
-    return id;
+void ViewRenderWidget::drawQuad(GLenum mode)
+{
+    setupVertexArray();
+    glDrawArrays(mode, 0, 4);
 }
 
 /**
@@ -1679,7 +1967,7 @@ GLuint ViewRenderWidget::buildLineList()
     // default thin border
     glNewList(base, GL_COMPILE);
 
-        glCallList(vertex_array_coords);
+        setupVertexArray();
 
         glLineWidth(2.0);
         glBindTexture(GL_TEXTURE_2D, white_texture);
@@ -1693,7 +1981,7 @@ GLuint ViewRenderWidget::buildLineList()
     // over
     glNewList(base + 1, GL_COMPILE);
 
-        glCallList(vertex_array_coords);
+        setupVertexArray();
 
         glBindTexture(GL_TEXTURE_2D, white_texture);
         glLineWidth(4.0);
@@ -1709,7 +1997,7 @@ GLuint ViewRenderWidget::buildLineList()
     // default border STATIC
     glNewList(base + 2, GL_COMPILE);
 
-        glCallList(vertex_array_coords);
+        setupVertexArray();
 
         glBindTexture(GL_TEXTURE_2D, white_texture);
         glLineWidth(1.0);
@@ -1723,7 +2011,7 @@ GLuint ViewRenderWidget::buildLineList()
     // over STATIC
     glNewList(base + 3, GL_COMPILE);
 
-        glCallList(vertex_array_coords);
+        setupVertexArray();
 
         glBindTexture(GL_TEXTURE_2D, white_texture);
         glLineWidth(3.0);
@@ -2039,7 +2327,7 @@ GLuint ViewRenderWidget::buildWindowList(GLubyte r, GLubyte g, GLubyte b)
         glPushMatrix();
         glTranslatef(0.02 * SOURCE_UNIT, -0.1 * SOURCE_UNIT, 0.1);
         glScalef(1.4 * SOURCE_UNIT, 1.4 * SOURCE_UNIT, 1.0);
-        glCallList(vertex_array_coords);
+        setupVertexArray();
         glDrawArrays(GL_QUADS, 0, 4);
         glPopMatrix();
         glDisable(GL_TEXTURE_2D);
@@ -2259,7 +2547,7 @@ GLuint ViewRenderWidget::buildBordersList()
     glLineWidth(1.0);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glBlendEquation(GL_FUNC_ADD);
-    glCallList(vertex_array_coords);
+    setupVertexArray();
     glDrawArrays(GL_LINE_LOOP, 0, 4);
     glEndList();
 
@@ -2268,7 +2556,7 @@ GLuint ViewRenderWidget::buildBordersList()
     glLineWidth(3.0);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glBlendEquation(GL_FUNC_ADD);
-    glCallList(vertex_array_coords);
+    setupVertexArray();
     glDrawArrays(GL_LINE_LOOP, 0, 4);
     glEndList();
 
@@ -2277,7 +2565,7 @@ GLuint ViewRenderWidget::buildBordersList()
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glBlendEquation(GL_FUNC_ADD);
     glLineWidth(3.0);
-    glCallList(vertex_array_coords);
+    setupVertexArray();
     glDrawArrays(GL_LINE_LOOP, 0, 4);
     glLineWidth(1.0);
     glBegin(GL_LINES); // begin drawing handles
@@ -2326,7 +2614,7 @@ GLuint ViewRenderWidget::buildBordersList()
     glLineWidth(1.0);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glBlendEquation(GL_FUNC_ADD);
-    glCallList(vertex_array_coords);
+    setupVertexArray();
     glDrawArrays(GL_LINE_LOOP, 0, 4);
     glEndList();
 
@@ -2338,7 +2626,7 @@ GLuint ViewRenderWidget::buildBordersList()
 //    glDisable(GL_LINE_STIPPLE);
 //    glPointSize(8.0);
 ////    glColor4ub(COLOR_SOURCE_STATIC, 180);
-//    glCallList(vertex_array_coords);
+//    setupVertexArray();
 //    glPushMatrix();
 //    glScalef(0.8, 0.8, 1.0);
 //    glDrawArrays(GL_POINTS, 0, 4);
@@ -2353,7 +2641,7 @@ GLuint ViewRenderWidget::buildBordersList()
     glDisable(GL_LINE_STIPPLE);
 //    glPointSize(8.0);
 ////    glColor4ub(COLOR_SOURCE_STATIC, 180);
-//    glCallList(vertex_array_coords);
+//    setupVertexArray();
 //    glPushMatrix();
 //    glScalef(0.8, 0.8, 1.0);
 //    glDrawArrays(GL_POINTS, 0, 4);
@@ -2550,7 +2838,7 @@ GLuint ViewRenderWidget::buildFadingList()
     glColor4ub(255, 255, 255, 220);
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, texid);
-    glCallList(quad_texured);
+    drawQuad();
     glDisable(GL_TEXTURE_2D);
 
     glMatrixMode(GL_PROJECTION);
@@ -2591,7 +2879,7 @@ GLuint ViewRenderWidget::buildSnapshotList()
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glBlendEquation(GL_FUNC_ADD);
-        glCallList(vertex_array_coords);
+        setupVertexArray();
 
         // uniform background
         glDisable(GL_TEXTURE_2D);
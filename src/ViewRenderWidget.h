@@ -33,6 +33,7 @@
 #include <QEvent>
 #include <QGestureEvent>
 #include <QString>
+#include <QMatrix4x4>
 
 #include "glRenderWidget.h"
 #include "SourceSet.h"
@@ -108,6 +109,7 @@ public:
      * Specific methods
      */
     void displayFramerate();
+    void displayProfiler();
     float getFramerate() { return f_p_s_; }
     void setLabels(QLabel *label, QLabel *labelFPS) { zoomLabel = label; fpsLabel = labelFPS; }
     int catalogWidth();
@@ -149,6 +151,9 @@ public:
     bool getFramerateVisible(){ return showFps_; }
     void setFramerateVisible(bool on);
 
+    bool getProfilerVisible();
+    void setProfilerVisible(bool on);
+
     /**
      * selection and layout
      */
@@ -210,13 +215,12 @@ public slots:
 public:
     // Shading
     static GLfloat coords[8];
-    static GLfloat texc[8];
     static GLfloat maskc[8];
     static QGLShaderProgram *program;
     static QString glslShaderFile;
     static GLfloat filter_kernel[10][3][3];
     static bool disableFiltering;
-    static int _baseColor, _baseAlpha, _stippling, _gamma, _levels, _contrast, _brightness, _saturation, _hueshift, _invertMode, _nbColors, _threshold, _chromakey, _chromadelta, _filter_type, _filter_step, _filter_kernel, _fading, _lumakey;
+    static int _baseColor, _baseAlpha, _stippling, _gamma, _levels, _contrast, _brightness, _saturation, _hueshift, _invertMode, _nbColors, _threshold, _chromakey, _chromadelta, _filter_type, _filter_step, _filter_kernel, _fading, _lumakey, _textureCoordinates, _sourceTransform;
 
     static const QMap<int, QPair<QString, QString> > getMaskDecription();
     static const GLuint getMaskTexture(int);
@@ -224,18 +228,47 @@ public:
     static void resetShaderAttributes();
     static void setupFilteringShaderProgram(QString fshfile);
     static void setBaseColor(QColor c, float alpha = -1.0);
+    static void setBaseAlpha(float alpha);
+    static void setStippling(float stipple);
+    static void setFading(float fade);
+    // send the values of the uniforms which changed (all if force)
+    static void setShaderAttributes(const ShaderAttributes &attributes, bool force = false);
+    static const ShaderAttributes &defaultShaderAttributes();
+    // area of the texture mapped on the quad
+    static void setTextureCoordinates(GLfloat left, GLfloat top, GLfloat right, GLfloat bottom);
+    // placement of the quad applied after the modelview matrix (identity by default)
+    static void setSourceTransform(const QMatrix4x4 &transform = QMatrix4x4());
+
+    // Geometry
+    // vertex and mask coordinates of the quad (vertex buffer object)
+    static void setupVertexArray();
+    // draw the quad (-1,-1) to (1,1) with its vertex array
+    static void drawQuad(GLenum mode = GL_TRIANGLE_FAN);
+
+    // features of the image processing shader
+    typedef enum {
+        SHADER_NONE = 0,
+        SHADER_FILTER = 1,      // convolution, erosion and dilation
+        SHADER_CHROMAKEY = 2,
+        SHADER_COLOR = 4,       // brightness, contrast, levels, gamma, color inversion
+        SHADER_HSL = 8,         // hue, saturation, posterize, lumakey, threshold, luminance inversion
+        SHADER_ALL = 15,
+        SHADER_LUT = 16         // continuous color and hsl operations read in a ColorLookupTable
+    } shaderFeature;
+    // use the program variant compiled with these features only
+    static void setShaderFeatures(uint features);
 
 protected:
     // all the display lists
     static GLuint border_thin_shadow, border_large_shadow;
     static GLuint border_thin, border_large, border_scale, border_tooloverlay;
     static GLuint frame_selection, frame_screen, frame_screen_thin, frame_screen_mask;
-    static GLuint quad_texured, quad_window[2];
+    static GLuint quad_window[2];
     static GLuint circle_mixing, circle_limbo, layerbg;
     static GLuint fading;
     static GLuint stipplingMode;
     static GLubyte stippling[];
-    static GLuint vertex_array_coords;
+    static GLuint vertex_buffer;
     static GLuint black_texture, white_texture;
     static GLuint center_pivot;
     static GLuint snapshot;
@@ -246,6 +279,13 @@ protected:
     static QMap<int, QPair<QString, QString> > mask_description;
     static int mask_custom;
 
+    // values currently in the program
+    static ShaderAttributes currentAttributes;
+    // features of the current program variant
+    static uint shaderFeatures;
+    static bool shaderPermutations;
+    static void buildShaderProgram(QGLShaderProgram *p, uint features);
+
 private:
     // V i e w s
     View *_currentView, *_renderView;
@@ -286,7 +326,7 @@ private:
     // utility to build the display lists
     GLuint buildSelectList();
     GLuint buildLineList();
-    GLuint buildTexturedQuadList();
+    GLuint buildVertexBuffer();
     GLuint buildCircleList();
     GLuint buildLimboCircleList();
     GLuint buildLayerbgList();
@@ -2,6 +2,10 @@
 
 #include <QFontDatabase>
 
+#ifndef Q_OS_WIN
+#include <sys/resource.h>
+#endif
+
 QMap<int, QPair<int, int> > presetBlending;
 QStringList listofextensions;
 
@@ -286,6 +290,22 @@ QString getByteSizeString(double numbytes)
     return QString().setNum(numbytes,'f',1) + " " + unit;
 }
 
+qint64 getPeakResidentMemory()
+{
+#ifndef Q_OS_WIN
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MAC
+        return (qint64) usage.ru_maxrss;
+#else
+        // kilobytes on linux
+        return (qint64) usage.ru_maxrss * 1024;
+#endif
+    }
+#endif
+    return -1;
+}
+
 
 
 void initApplicationFonts()
@@ -78,6 +78,8 @@ int intFromBlendingPreset(GLenum, GLenum);
 void addPathToSystemPath(QByteArray path);
 
 QString getByteSizeString(double numbytes);
+// maximum memory used by the process (bytes, -1 if unknown)
+qint64 getPeakResidentMemory();
 
 void initApplicationFonts();
 QString getMonospaceFont();
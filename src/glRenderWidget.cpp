@@ -25,6 +25,7 @@
 
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QDebug>
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QListView>
@@ -201,11 +202,16 @@ glRenderTimer *glRenderTimer::getInstance()
     return _instance;
 }
 
-glRenderTimer::glRenderTimer() : QObject(), _interval(20), _updater(0), _activeTiming(false)
+glRenderTimer::glRenderTimer() : QObject(), _interval(20), _updater(0), _activeTiming(false), _framePacing(false),
+    _deadline(0), _lastPresent(-1), _periodStart(0), _refreshPeriod(0.0)
 {
     _elapsedTimer = new QElapsedTimer();
     _timer = new QTimer();
-    connect(_timer, SIGNAL(timeout()), this, SIGNAL(timeout()));
+    connect(_timer, SIGNAL(timeout()), this, SLOT(tick()));
+
+    _presentTimer = new QElapsedTimer();
+    _presentTimer->start();
+    _presentHistogram.fill(0, PRESENT_HISTOGRAM_SIZE);
 
     restartTimer(false);
 }
@@ -241,6 +247,7 @@ void glRenderTimer::restartTimer(bool active)
     if (active) {
         _updater = startTimer(0);
         _elapsedTimer->start();
+        _deadline = 0;
     }
     // passive timing mode
     else {
@@ -268,15 +275,126 @@ void glRenderTimer::endActiveTiming()
 
 void glRenderTimer::timerEvent(QTimerEvent * event)
 {
+    qint64 now = _elapsedTimer->nsecsElapsed();
+    qint64 period = (qint64) _interval * 1000000;
+    qint64 tolerance = 0;
+
+    // align on the refresh of the display : the interval is a
+    // multiple of the refresh period, and a tick up to half a
+    // refresh early falls on the same vertical synchronization
+    qint64 refresh = (qint64) (refreshPeriod() * 1000000000.0);
+    if (refresh > 0) {
+        period = qMax( (qint64) 1, qRound64( (double) period / (double) refresh ) ) * refresh;
+        tolerance = refresh / 2;
+    }
+
     // did not reach interval: discard
-    if ( _elapsedTimer->elapsed() < _interval )
+    if ( now < _deadline - tolerance )
         return;
 
-    // restart time counter
-    if ( _elapsedTimer->restart() < 2 * _interval )
-        // emit extra timeout if too much delay
-        emit timeout();
-
+    // too much delay : skip this tick
     // NB: sending less signal when system is slow is not ideal
     // but this allows recovering faster
+    if ( now > _deadline + period ) {
+        _deadline = now + period;
+        return;
+    }
+
+    // next tick relative to this deadline (no drift)
+    _deadline += period;
+
+    tick();
+}
+
+void glRenderTimer::tick()
+{
+    // sources choose the frame displayed at the next refresh
+    if (_framePacing) {
+        double period = refreshPeriod();
+        emit frameScheduled( period > 0.0 ? period : (double) _interval / 1000.0 );
+    }
+
+    emit timeout();
+}
+
+void glRenderTimer::setFramePacingMode(bool on)
+{
+    if (on != _framePacing) {
+        _framePacing = on;
+        emit framePacingChanged(_framePacing);
+    }
+}
+
+void glRenderTimer::framePresented()
+{
+    QMutexLocker locker(&_presentMutex);
+
+    qint64 now = _presentTimer->nsecsElapsed();
+
+    if (_lastPresent > -1) {
+        double dt = (double) (now - _lastPresent) / 1000000000.0;
+        _presentHistogram[ qBound(0, (int) (dt * 1000.0), PRESENT_HISTOGRAM_SIZE - 1) ]++;
+        // ignore the frames presented immediately one after another
+        if (dt > 0.004)
+            _periodIntervals.append(dt);
+    }
+    _lastPresent = now;
+
+    // estimate the refresh period every second
+    if (now - _periodStart < 1000000000)
+        return;
+    _periodStart = now;
+
+    // the shortest interval is the period of the display if
+    // the others are multiples of it (presentation is synchronized)
+    // and if it is shorter than the interval of the timer
+    double shortest = 0.0;
+    foreach (double dt, _periodIntervals)
+        shortest = shortest > 0.0 ? qMin(shortest, dt) : dt;
+
+    int aligned = 0;
+    if ( shortest > 0.0 && shortest * 1000.0 < 0.9 * (double) _interval ) {
+        foreach (double dt, _periodIntervals) {
+            double r = dt / shortest;
+            if ( qAbs(r - qRound(r)) < 0.15 )
+                ++aligned;
+        }
+    }
+
+    double previous = _refreshPeriod;
+    if ( _periodIntervals.size() > 9 && aligned > _periodIntervals.size() * 8 / 10 )
+        _refreshPeriod = _refreshPeriod > 0.0 ? 0.9 * _refreshPeriod + 0.1 * shortest : shortest;
+    else
+        _refreshPeriod = 0.0;
+
+    if ( (previous > 0.0) != (_refreshPeriod > 0.0) ) {
+        if (_refreshPeriod > 0.0)
+            qDebug() << "glRenderTimer" << QChar(124).toLatin1() << tr("Frames aligned on the display refresh (%1 ms).").arg(_refreshPeriod * 1000.0, 0, 'f', 2);
+        else
+            qDebug() << "glRenderTimer" << QChar(124).toLatin1() << tr("Frames not aligned on the display refresh.");
+    }
+
+    _periodIntervals.clear();
+}
+
+double glRenderTimer::refreshPeriod()
+{
+    QMutexLocker locker(&_presentMutex);
+
+    return _refreshPeriod;
+}
+
+QVector<int> glRenderTimer::presentIntervalHistogram()
+{
+    QMutexLocker locker(&_presentMutex);
+
+    return _presentHistogram;
+}
+
+void glRenderTimer::resetStatistics()
+{
+    QMutexLocker locker(&_presentMutex);
+
+    _presentHistogram.fill(0, PRESENT_HISTOGRAM_SIZE);
+    _lastPresent = -1;
 }
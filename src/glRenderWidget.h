@@ -28,6 +28,14 @@
 
 #include "common.h"
 
+#include <QMutex>
+#include <QVector>
+
+/**
+ * Number of bins (of 1 ms) of the histogram of presentation intervals
+ */
+#define PRESENT_HISTOGRAM_SIZE 100
+
 class glRenderTimer: public QObject {
 
     Q_OBJECT
@@ -46,16 +54,44 @@ public:
     void beginActiveTiming();
     void endActiveTiming();
 
+    // sources choose their frame at each tick
+    void setFramePacingMode(bool on);
+    inline const bool isFramePacingMode() { return _framePacing; }
+
+    // feedback of the output when a frame is presented (any thread)
+    void framePresented();
+    // measured period of the display in seconds (0 if unknown)
+    double refreshPeriod();
+    // count of intervals between presented frames (1 ms bins)
+    QVector<int> presentIntervalHistogram();
+    void resetStatistics();
+
 signals:
     void timeout();
+    // emitted before timeout() in frame pacing mode, with
+    // the delay (seconds) until the frame will be displayed
+    void frameScheduled(double);
+    void framePacingChanged(bool);
+
+private slots:
+    void tick();
 
 private:
     void timerEvent(QTimerEvent * event);
     void restartTimer(bool active);
     int _interval, _updater;
-    bool _activeTiming;
+    bool _activeTiming, _framePacing;
+    qint64 _deadline;
     class QElapsedTimer *_elapsedTimer;
     class QTimer *_timer;
+
+    // presentation statistics
+    QMutex _presentMutex;
+    class QElapsedTimer *_presentTimer;
+    qint64 _lastPresent, _periodStart;
+    QList<double> _periodIntervals;
+    double _refreshPeriod;
+    QVector<int> _presentHistogram;
 };
 
 class glRenderWidget  : public QGLWidget
@@ -57,6 +57,7 @@
 #include "FuzzyCursor.h"
 #include "MagnetCursor.h"
 #include "RenderingEncoder.h"
+#include "ReplayBuffer.h"
 #include "SessionSwitcher.h"
 #include "MixingToolboxWidget.h"
 #include "LayoutToolboxWidget.h"
@@ -66,6 +67,9 @@
 #include "VideoStreamDialog.h"
 #include "CodecManager.h"
 #include "WorkspaceManager.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include "MetricsManager.h"
 #include "OpenSoundControlTranslator.h"
 #include "BasketSelectionDialog.h"
 #include "CameraDialog.h"
@@ -561,6 +565,12 @@ GLMixer::GLMixer ( QWidget *parent): QMainWindow ( parent ),
     QObject::connect(actionPause_recording, SIGNAL(toggled(bool)), RenderingManager::getRecorder(), SLOT(setPaused(bool)));
     QObject::connect(RenderingManager::getRecorder(), SIGNAL(processing(bool)), actionRecord, SLOT(setDisabled(bool)));
     QObject::connect(RenderingManager::getRecorder(), SIGNAL(processing(bool)), this, SLOT(setBusy(bool)));
+    QObject::connect(actionInstant_replay, SIGNAL(toggled(bool)), RenderingManager::getRecorder(), SLOT(setReplayActive(bool)));
+    QObject::connect(RenderingManager::getRecorder(), SIGNAL(replayActivated(bool)), actionInstant_replay, SLOT(setChecked(bool)));
+    QObject::connect(RenderingManager::getRecorder(), SIGNAL(replayActivated(bool)), actionSave_replay, SLOT(setEnabled(bool)));
+    QObject::connect(actionSave_replay, SIGNAL(triggered()), RenderingManager::getRecorder(), SLOT(saveReplay()));
+    QObject::connect(actionStream_output, SIGNAL(toggled(bool)), RenderingManager::getRecorder(), SLOT(setStreamingActive(bool)));
+    QObject::connect(RenderingManager::getRecorder(), SIGNAL(streamingActivated(bool)), actionStream_output, SLOT(setChecked(bool)));
 
     // connect recorder to disable many actions, like quitting, opening session, preferences, etc.
     QObject::connect(RenderingManager::getRecorder(), SIGNAL(activated(bool)), actionNew_Session, SLOT(setDisabled(bool)));
@@ -760,6 +770,40 @@ void GLMixer::on_actionOpenGL_extensions_triggered(){
     glRenderWidget::showGlExtensionsInformationDialog(QString::fromUtf8(":/glmixer/icons/display.png"));
 }
 
+void GLMixer::on_actionProfiler_toggled(bool on){
+
+    RenderingManager::getRenderingWidget()->setProfilerVisible(on);
+}
+
+void GLMixer::on_actionExportProfile_triggered(){
+
+    // get the filename of a csv file
+    QString fileName = getFileName(tr("Export profile of the rendering to file"),
+                                   tr("CSV file") + " (*.csv)",
+                                   QString("csv"),
+                                   QFileInfo( QDir::home(), "glmixer_profile.csv").absoluteFilePath() );
+
+    if (!fileName.isEmpty())
+        Profiler::getInstance()->exportCsv(fileName);
+}
+
+void GLMixer::on_actionTrace_toggled(bool on){
+
+    Tracer::getInstance()->setEnabled(on);
+}
+
+void GLMixer::on_actionExportTrace_triggered(){
+
+    // get the filename of a json file
+    QString fileName = getFileName(tr("Export trace of the threads to file"),
+                                   tr("JSON file") + " (*.json)",
+                                   QString("json"),
+                                   QFileInfo( QDir::home(), "glmixer_trace.json").absoluteFilePath() );
+
+    if (!fileName.isEmpty())
+        Tracer::getInstance()->exportJson(fileName);
+}
+
 
 void GLMixer::on_copyNotes_clicked() {
 
@@ -2999,6 +3043,10 @@ void GLMixer::readSettings( QString pathtobin )
     _settings->endArray();
 #endif
 
+    // Metrics served over HTTP
+    if (_settings->value("MetricsEnabled", "0").toBool())
+        MetricsManager::getInstance()->setEnabled(true, (quint16) _settings->value("MetricsPort", "9464").toInt());
+
     // ok
     qDebug() << _settings->fileName() << QChar(124).toLatin1() << tr("All settings restored.");
 }
@@ -3069,6 +3117,10 @@ void GLMixer::saveSettings()
     _settings->endArray();
 #endif
 
+    // Metrics served over HTTP
+    _settings->setValue("MetricsEnabled", MetricsManager::getInstance()->isEnabled());
+    _settings->setValue("MetricsPort", MetricsManager::getInstance()->getPort());
+
     // make sure system saves settings NOW
     _settings->sync();
 
@@ -3453,9 +3505,51 @@ void GLMixer::restorePreferences(const QByteArray & state){
     stream >> duration;
     RenderingManager::getInstance()->getSessionSwitcher()->setSmoothAlphaDuration(duration);
 
+    // (the following sections are missing in the preferences saved by
+    // previous versions : keep the defaults when the stream ends)
+
+    // ad. Instant replay duration
+    int replayduration = DEFAULT_REPLAY_DURATION;
+    if (!stream.atEnd())
+        stream >> replayduration;
+    RenderingManager::getRecorder()->setReplayDuration(replayduration);
+
+    // ae. Additional recording output
+    bool addoutput = false;
+    uint addformat = 0, addquality = 0;
+    int addscale = 50;
+    if (!stream.atEnd())
+        stream >> addoutput >> addformat >> addquality >> addscale;
+    RenderingManager::getRecorder()->clearOutputs();
+    if (addoutput)
+        RenderingManager::getRecorder()->addOutput((encodingformat) addformat, (encodingquality) addquality, addscale);
+
+    // af. Network streaming
+    QString streamurl = DEFAULT_STREAMING_URL;
+    int streamlatency = DEFAULT_STREAMING_LATENCY;
+    if (!stream.atEnd())
+        stream >> streamurl >> streamlatency;
+    RenderingManager::getRecorder()->setStreamingUrl(streamurl);
+    RenderingManager::getRecorder()->setStreamingLatency(streamlatency);
+
+    // ag. Frame pacing
+    bool framepacing = true;
+    if (!stream.atEnd())
+        stream >> framepacing;
+    glRenderTimer::getInstance()->setFramePacingMode(framepacing);
+
+    // ah. Dynamic resolution
+    bool dynamicresolution = false;
+    if (!stream.atEnd())
+        stream >> dynamicresolution;
+    RenderingManager::getInstance()->setDynamicResolution(dynamicresolution);
+
     // ensure the Rendering Manager updates
     RenderingManager::getInstance()->resetFrameBuffer();
 
+    // measure performance of encoders (if not already done for these preferences)
+    RenderingManager::getRecorder()->calibrate();
+
     // de-select current source
     RenderingManager::getInstance()->unsetCurrentSource();
 
@@ -3573,6 +3667,27 @@ QByteArray GLMixer::getPreferences() const {
     // ac. Output fading duration
     stream << RenderingManager::getInstance()->getSessionSwitcher()->smoothAlphaDuration();
 
+    // ad. Instant replay duration
+    stream << RenderingManager::getRecorder()->replayDuration();
+
+    // ae. Additional recording output
+    QList<RecordingOutput> outputs = RenderingManager::getRecorder()->outputs();
+    stream << !outputs.isEmpty();
+    if (outputs.isEmpty())
+        stream << (uint) 0 << (uint) 0 << (int) 50;
+    else
+        stream << (uint) outputs.first().format << (uint) outputs.first().quality << outputs.first().scale;
+
+    // af. Network streaming
+    stream << RenderingManager::getRecorder()->streamingUrl();
+    stream << RenderingManager::getRecorder()->streamingLatency();
+
+    // ag. Frame pacing
+    stream << glRenderTimer::getInstance()->isFramePacingMode();
+
+    // ah. Dynamic resolution
+    stream << RenderingManager::getInstance()->dynamicResolution();
+
     return data;
 }
 
@@ -4045,6 +4160,30 @@ QString GLMixer::getMaskFileName(QString suggestion) {
         return QString("");
 }
 
+QString GLMixer::getColorTableFileName(QString suggestion) {
+
+    // try to help user by proposing suggested file
+    QString previousfilename = suggestion;
+    if (previousfilename.isEmpty())
+        previousfilename = _settings->value("previousColorTable", "").toString();
+
+    // try to re-open where previous
+    QFileInfo fi( previousfilename );
+    QDir di(QDesktopServices::storageLocation(QDesktopServices::DocumentsLocation));
+    previousfilename = fi.isReadable() ? fi.absoluteFilePath() : di.absolutePath();
+    // open file
+    QString fileName = QFileDialog::getOpenFileName(NULL, "Open Color Table", previousfilename, "3D Lookup Table (*.cube)" );
+
+    // check validity of file
+    QFileInfo fileInfo(fileName);
+    if (fileInfo.isFile() && fileInfo.isReadable()) {
+        _settings->setValue("previousColorTable", fileName);
+        return fileInfo.absoluteFilePath() ;
+    }
+    else
+        return QString("");
+}
+
 void GLMixer::on_actionWebsite_triggered() {
 
     QDesktopServices::openUrl(QUrl("https://sourceforge.net/projects/glmixer/", QUrl::TolerantMode));
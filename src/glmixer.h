@@ -81,6 +81,10 @@ public slots:
     void on_actionEditSource_triggered();
     void on_actionFormats_and_Codecs_triggered();
     void on_actionOpenGL_extensions_triggered();
+    void on_actionProfiler_toggled(bool on);
+    void on_actionExportProfile_triggered();
+    void on_actionTrace_toggled(bool on);
+    void on_actionExportTrace_triggered();
     void on_frameForwardButton_clicked();
     void on_fastForwardButton_pressed();
     void on_fastForwardButton_released();
@@ -163,6 +167,7 @@ public slots:
     QString getFileName(QString title, QString filters, QString saveExtention = QString(), QString suggestion = QString());
     QStringList getMediaFileNames(bool &smartScalingRequest, bool &hwDecodingRequest);
     QString getMaskFileName(QString suggestion);
+    QString getColorTableFileName(QString suggestion);
 
     // timer display
     void setDisplayTimeEnabled(bool on);
@@ -226,6 +226,9 @@ bool GLMixerApp::hasCrashLogs() {
 //           qPrintable(pattern), qPrintable(text), matches);
 //}
 
+// the benchmarks (glmixer-bench, glmixer-decodebench) have their own main
+#ifndef GLM_BENCH
+
 int main(int argc, char **argv)
 {
     bool crashrecover = false;
@@ -234,6 +237,10 @@ int main(int argc, char **argv)
     //
     // 0. Create the Qt application and treat arguments
     //
+#if QT_VERSION >= 0x040800
+    // the texture uploader and output presenter threads use OpenGL (Xlib)
+    QCoreApplication::setAttribute(Qt::AA_X11InitThreads);
+#endif
     GLMixerApp a(argc, argv);
 
     // get the arguments into a list
@@ -391,3 +398,5 @@ int main(int argc, char **argv)
 
     return returnvalue;
 }
+
+#endif // GLM_BENCH